@@ -0,0 +1,120 @@
+#include "sg20_graphgen/graph_generator.h"
+#include "sg20_graphgen/output_sink.h"
+#include "sg20_graphgen/synthetic.h"
+
+#include "absl/flags/flag.h"
+#include "absl/flags/parse.h"
+#include "absl/flags/usage.h"
+#include "absl/strings/str_cat.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <sys/wait.h>
+
+ABSL_FLAG(int, modules, 40, "Number of modules of the synthetic collection.");
+ABSL_FLAG(int, topics, 25, "Number of topics per module.");
+ABSL_FLAG(int, repetitions, 3,
+          "Number of dot runs per variant, the median is reported.");
+ABSL_FLAG(std::string, dot, "dot", "Command that runs graphviz dot.");
+ABSL_FLAG(std::string, workDir, "",
+          "Directory for the generated dot files, the temporary directory if "
+          "empty.");
+
+namespace {
+
+struct Variant {
+  const char *name;
+  sg20::DotLayoutOptions options;
+};
+
+using Clock = std::chrono::steady_clock;
+
+double secondsSince(Clock::time_point start) {
+  return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+} // namespace
+
+// Compares the time dot needs to render the full graph of a synthetic
+// collection in collection order, in layout order, and in layout order with
+// same ranks, to decide on the default of --layoutOrder.
+int main(int argc, char *argv[]) {
+  absl::SetProgramUsageMessage(absl::StrCat(
+      "Measure the dot render time of the full graph with and without layout "
+      "order.\n\nExample usage: ",
+      argv[0], " --modules 100 --topics 50"));
+  absl::ParseCommandLine(argc, argv);
+
+  sg20::SyntheticCollectionOptions collectionOptions;
+  collectionOptions.numModules = absl::GetFlag(FLAGS_modules);
+  collectionOptions.topicsPerModule = absl::GetFlag(FLAGS_topics);
+  auto MC = sg20::generateSyntheticCollection(collectionOptions);
+
+  std::filesystem::path workDir = absl::GetFlag(FLAGS_workDir);
+  if (workDir.empty()) {
+    workDir = std::filesystem::temp_directory_path();
+  }
+  int repetitions = std::max(absl::GetFlag(FLAGS_repetitions), 1);
+
+  std::vector<Variant> variants = {{"collection order", {false, false}},
+                                   {"layout order", {true, false}},
+                                   {"layout order, same rank", {true, true}}};
+  std::cout << MC.numModules() << " modules, " << MC.numTopics()
+            << " topics\n";
+  std::cout << std::left << std::setw(26) << "variant" << std::right
+            << std::setw(12) << "emit [s]" << std::setw(12) << "dot [s]"
+            << "\n";
+  for (size_t index = 0; index < variants.size(); ++index) {
+    auto &variant = variants[index];
+    auto dotFile = workDir / ("sg20_layout_bench_" + std::to_string(index) +
+                              ".dot");
+    auto emitStart = Clock::now();
+    {
+      sg20::OutputSink out(dotFile);
+      sg20::writeOutput(MC, sg20::OutputKind::FullDot, out, variant.options);
+      out.flush();
+      if (!out.good()) {
+        std::cerr << "Could not write " << dotFile << "\n";
+        return 1;
+      }
+    }
+    double emitSeconds = secondsSince(emitStart);
+
+    std::string command = absl::StrCat(absl::GetFlag(FLAGS_dot),
+                                       " -Tsvg -o /dev/null ",
+                                       dotFile.string());
+    std::vector<double> dotSeconds;
+    for (int run = 0; run < repetitions; ++run) {
+      auto dotStart = Clock::now();
+      int status = std::system(command.c_str());
+      if (status != 0) {
+        std::filesystem::remove(dotFile);
+        if (WIFEXITED(status) && WEXITSTATUS(status) == 127) {
+          std::cerr << "Could not run " << absl::GetFlag(FLAGS_dot)
+                    << ", is graphviz installed?\n";
+        } else {
+          std::cerr << "dot failed on " << dotFile << "\n";
+        }
+        return 1;
+      }
+      dotSeconds.push_back(secondsSince(dotStart));
+    }
+    std::filesystem::remove(dotFile);
+    std::nth_element(dotSeconds.begin(),
+                     dotSeconds.begin() + dotSeconds.size() / 2,
+                     dotSeconds.end());
+
+    std::cout << std::left << std::setw(26) << variant.name << std::right
+              << std::fixed << std::setprecision(3) << std::setw(12)
+              << emitSeconds << std::setw(12)
+              << dotSeconds[dotSeconds.size() / 2] << "\n";
+  }
+  return 0;
+}
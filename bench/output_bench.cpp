@@ -0,0 +1,94 @@
+#include "sg20_graphgen/graph_generator.h"
+#include "sg20_graphgen/output_sink.h"
+#include "sg20_graphgen/synthetic.h"
+
+#include "absl/flags/flag.h"
+#include "absl/flags/parse.h"
+#include "absl/flags/usage.h"
+#include "absl/strings/str_cat.h"
+
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <string>
+#include <vector>
+
+ABSL_FLAG(int, modules, 1000, "Number of modules of the synthetic collection.");
+ABSL_FLAG(int, topics, 100, "Number of topics per module.");
+ABSL_FLAG(int, repetitions, 5,
+          "Number of runs per output kind, the fastest one is reported.");
+ABSL_FLAG(std::vector<std::string>, kinds,
+          std::vector<std::string>({"dot", "htmldot", "yaml", "json",
+                                    "msgpack", "svg", "html"}),
+          "Comma separated list of the output kinds to measure.");
+ABSL_FLAG(std::string, output, "",
+          "File the outputs are written to, a file in the temporary directory "
+          "if empty. It is deleted afterwards.");
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+double secondsSince(Clock::time_point start) {
+  return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+} // namespace
+
+// Measures the time and throughput of writing every output kind of a
+// synthetic collection through an OutputSink.
+int main(int argc, char *argv[]) {
+  absl::SetProgramUsageMessage(absl::StrCat(
+      "Measure the throughput of the output writers.\n\nExample usage: ",
+      argv[0], " --modules 1000 --topics 100 --kinds yaml,json"));
+  absl::ParseCommandLine(argc, argv);
+
+  sg20::SyntheticCollectionOptions collectionOptions;
+  collectionOptions.numModules = absl::GetFlag(FLAGS_modules);
+  collectionOptions.topicsPerModule = absl::GetFlag(FLAGS_topics);
+  auto MC = sg20::generateSyntheticCollection(collectionOptions);
+  std::filesystem::path outputFilename(absl::GetFlag(FLAGS_output));
+  if (outputFilename.empty()) {
+    outputFilename =
+        std::filesystem::temp_directory_path() / "sg20_output_bench.out";
+  }
+  int repetitions = std::max(absl::GetFlag(FLAGS_repetitions), 1);
+
+  std::cout << MC.numModules() << " modules, " << MC.numTopics()
+            << " topics\n";
+  std::cout << std::left << std::setw(10) << "kind" << std::right
+            << std::setw(12) << "time [s]" << std::setw(12) << "size [MB]"
+            << std::setw(12) << "MB/s" << "\n";
+  for (auto &kindName : absl::GetFlag(FLAGS_kinds)) {
+    auto kind = sg20::parseOutputKind(kindName);
+    if (!kind) {
+      std::cerr << "Unknown output kind " << kindName << "\n";
+      return 1;
+    }
+
+    double bestSeconds = std::numeric_limits<double>::max();
+    for (int run = 0; run < repetitions; ++run) {
+      auto start = Clock::now();
+      sg20::OutputSink out(outputFilename);
+      sg20::writeOutput(MC, *kind, out);
+      out.flush();
+      bestSeconds = std::min(bestSeconds, secondsSince(start));
+      if (!out.good()) {
+        std::cerr << "Could not write " << outputFilename << "\n";
+        return 1;
+      }
+    }
+
+    double megabytes =
+        std::filesystem::file_size(outputFilename) / double(1 << 20);
+    std::cout << std::left << std::setw(10) << kindName << std::right
+              << std::fixed << std::setprecision(3) << std::setw(12)
+              << bestSeconds << std::setw(12) << megabytes << std::setw(12)
+              << megabytes / bestSeconds << "\n";
+  }
+  std::filesystem::remove(outputFilename);
+  return 0;
+}
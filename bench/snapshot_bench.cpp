@@ -0,0 +1,110 @@
+#include "sg20_graphgen/snapshot.h"
+#include "sg20_graphgen/synthetic.h"
+
+#include "absl/flags/flag.h"
+#include "absl/flags/parse.h"
+#include "absl/flags/usage.h"
+#include "absl/strings/str_cat.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+ABSL_FLAG(int, modules, 100, "Number of modules of the synthetic collection.");
+ABSL_FLAG(int, topics, 100, "Number of topics per module.");
+ABSL_FLAG(int, updates, 20, "Number of published updates per batch size.");
+ABSL_FLAG(std::vector<std::string>, batches,
+          std::vector<std::string>({"1", "10", "100"}),
+          "Comma separated list of the number of edits per update.");
+ABSL_FLAG(int, readers, 2,
+          "Number of threads that read snapshots during the updates.");
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+double secondsSince(Clock::time_point start) {
+  return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+} // namespace
+
+// Measures the cost of publishing a new snapshot, which copies the complete
+// collection, for updates with different numbers of edits, while reader
+// threads keep traversing the current snapshot.
+int main(int argc, char *argv[]) {
+  absl::SetProgramUsageMessage(absl::StrCat(
+      "Measure the time to publish snapshots of a collection.\n\nExample "
+      "usage: ",
+      argv[0], " --modules 100 --topics 100 --batches 1,10,100"));
+  absl::ParseCommandLine(argc, argv);
+
+  sg20::SyntheticCollectionOptions collectionOptions;
+  collectionOptions.numModules = absl::GetFlag(FLAGS_modules);
+  collectionOptions.topicsPerModule = absl::GetFlag(FLAGS_topics);
+  sg20::SnapshotPublisher publisher(
+      sg20::generateSyntheticCollection(collectionOptions));
+  int updates = std::max(absl::GetFlag(FLAGS_updates), 1);
+
+  auto initial = publisher.acquire();
+  std::cout << initial->getCollection().numModules() << " modules, "
+            << initial->getCollection().numTopics() << " topics\n";
+  initial.reset();
+
+  std::atomic<bool> done{false};
+  std::atomic<long> reads{0};
+  std::vector<std::thread> readers;
+  for (int reader = 0; reader < absl::GetFlag(FLAGS_readers); ++reader) {
+    readers.emplace_back([&publisher, &done, &reads]() {
+      while (!done) {
+        auto snapshot = publisher.acquire();
+        size_t numDependencies = 0;
+        for (auto &module : snapshot->getCollection().modules()) {
+          for (auto &topic : module->topics()) {
+            numDependencies += topic->numDependencies();
+          }
+        }
+        reads += numDependencies != SIZE_MAX;
+      }
+    });
+  }
+
+  std::cout << std::right << std::setw(8) << "edits" << std::setw(16)
+            << "update [ms]" << std::setw(16) << "per edit [ms]"
+            << std::setw(18) << "snapshot reads/s" << "\n";
+  int nextTopic = 0;
+  for (auto &batchFlag : absl::GetFlag(FLAGS_batches)) {
+    int batch = std::max(std::atoi(batchFlag.c_str()), 1);
+    long readsBefore = reads;
+    auto start = Clock::now();
+    for (int update = 0; update < updates; ++update) {
+      publisher.update([&](sg20::ModuleCollection &moduleCollection) {
+        sg20::Module &module = **moduleCollection.modules().begin();
+        for (int edit = 0; edit < batch; ++edit) {
+          moduleCollection.addTopicToModule(
+              "bench topic " + std::to_string(nextTopic++), module);
+        }
+        return true;
+      });
+    }
+    double seconds = secondsSince(start);
+    double milliseconds = 1000 * seconds / updates;
+    std::cout << std::setw(8) << batch << std::fixed << std::setprecision(3)
+              << std::setw(16) << milliseconds << std::setw(16)
+              << milliseconds / batch << std::setprecision(1) << std::setw(18)
+              << (reads - readsBefore) / seconds << "\n";
+  }
+
+  done = true;
+  for (auto &reader : readers) {
+    reader.join();
+  }
+  return 0;
+}
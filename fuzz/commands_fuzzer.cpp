@@ -0,0 +1,59 @@
+#include "fuzz_util.h"
+
+#include "sg20_graphgen/commands.h"
+#include "sg20_graphgen/search_index.h"
+
+#include <istream>
+#include <ostream>
+#include <sstream>
+
+using namespace sg20;
+
+// Collection the commands run on. Names with colons, arrows, and digits, and
+// names that are prefixes of others, make splitting the input ambiguous.
+static ModuleCollection buildCollection() {
+  ModuleCollection::Builder builder;
+  const char *moduleNames[] = {"Basics", "Basics advanced", "a:b -> c:d",
+                               "10"};
+  const char *topicNames[] = {"Types", "x:y", "p -> q", "2", "Types:Values"};
+  int topicID = 0;
+  for (int moduleIndex = 0; moduleIndex < 4; ++moduleIndex) {
+    Module &module = builder.addModule(moduleNames[moduleIndex],
+                                       moduleIndex + 1);
+    for (const char *topicName : topicNames) {
+      Topic &topic = builder.addTopic(module, topicName, ++topicID);
+      if (topicID > 1) {
+        builder.addDependency(topic, topicID - 1, DependencyKind::Hard);
+        builder.addDependency(topic, topicID / 2, DependencyKind::Soft);
+      }
+    }
+  }
+  return builder.finish();
+}
+
+// Runs the input as a yamlEditor session on a copy of the collection.
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size) {
+  // Long sessions only repeat what short ones find, but take much longer.
+  if (size > 4096) {
+    return 0;
+  }
+  static const ModuleCollection base = buildCollection();
+  ModuleCollection moduleCollection = base.clone();
+  LazySearchIndex searchIndex;
+
+  std::istringstream in{std::string(fuzz::asStringView(data, size))};
+  std::ostringstream out;
+  std::string cmd;
+  while (in >> cmd) {
+    CommandType cmdType = convertToCommandType(cmd);
+    if (cmdType == CommandType::HELP || cmdType == CommandType::QUIT ||
+        cmdType == CommandType::ERROR) {
+      std::string rest;
+      std::getline(in, rest);
+      continue;
+    }
+    executeCommand(moduleCollection, cmdType, in, out, out, &searchIndex);
+    out.str("");
+  }
+  return 0;
+}
@@ -0,0 +1,43 @@
+#ifndef SG20_GRAPHGEN_FUZZ_UTIL_H
+#define SG20_GRAPHGEN_FUZZ_UTIL_H
+
+#include "sg20_graphgen/graph_generator.h"
+#include "sg20_graphgen/modules.h"
+#include "sg20_graphgen/output_sink.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <sstream>
+#include <string>
+#include <string_view>
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size);
+
+namespace sg20::fuzz {
+
+inline std::string_view asStringView(const uint8_t *data, size_t size) {
+  return std::string_view(reinterpret_cast<const char *>(data), size);
+}
+
+// Returns the output of the kind, e.g., to compare collections by their yaml
+// encoding.
+inline std::string encode(const ModuleCollection &moduleCollection,
+                          OutputKind kind) {
+  std::ostringstream stream;
+  {
+    OutputSink out(stream);
+    writeOutput(moduleCollection, kind, out);
+  }
+  return stream.str();
+}
+
+// Aborts, so the fuzzer reports the input as a crash.
+[[noreturn]] inline void fail(const char *msg) {
+  std::fprintf(stderr, "%s\n", msg);
+  std::abort();
+}
+
+} // namespace sg20::fuzz
+
+#endif // SG20_GRAPHGEN_FUZZ_UTIL_H
@@ -0,0 +1,82 @@
+#include "fuzz_util.h"
+
+#include "sg20_graphgen/history.h"
+#include "sg20_graphgen/serialization.h"
+
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+
+#include <unistd.h>
+
+using namespace sg20;
+
+namespace {
+
+// The file layout of src/history.cpp. Mutated records would almost never
+// pass the checksum, so the fuzzer frames the records itself and the input
+// mostly mutates their payload, i.e., the encoded changes.
+constexpr std::string_view HistoryMagic = "SG20HIS\x01";
+
+uint32_t computeChecksum(std::string_view data) {
+  uint32_t hash = 2166136261u;
+  for (char c : data) {
+    hash = (hash ^ static_cast<uint8_t>(c)) * 16777619u;
+  }
+  return hash;
+}
+
+void appendUInt32(std::string &out, uint32_t value) {
+  for (int shift = 0; shift < 32; shift += 8) {
+    out.push_back(static_cast<char>(value >> shift));
+  }
+}
+
+// Turns the input into a history file. If the first byte is 0, the rest is
+// the file. Otherwise, the input is a sequence of records, each with a kind
+// byte, a one byte length, and the payload, which get a valid header.
+std::string buildHistoryFile(std::string_view input) {
+  if (!input.empty() && input[0] == 0) {
+    return std::string(input.substr(1));
+  }
+  std::string file(HistoryMagic);
+  while (input.size() >= 2) {
+    char kind = input[0];
+    std::string_view payload =
+        input.substr(2, static_cast<uint8_t>(input[1]));
+    input.remove_prefix(2 + payload.size());
+    appendUInt32(file, payload.size());
+    file.push_back(kind);
+    appendUInt32(file, computeChecksum(payload));
+    file.append(payload);
+  }
+  return file;
+}
+
+} // namespace
+
+// Opens the history and loads every revision.
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size) {
+  static const std::filesystem::path filepath =
+      std::filesystem::temp_directory_path() /
+      ("sg20_history_fuzzer_" + std::to_string(::getpid()));
+  {
+    std::string file = buildHistoryFile(fuzz::asStringView(data, size));
+    std::ofstream out(filepath, std::ios::binary | std::ios::trunc);
+    out.write(file.data(), file.size());
+  }
+
+  try {
+    HistoryStore history(filepath);
+    for (size_t revision = 0; revision < history.numRevisions(); ++revision) {
+      try {
+        history.loadRevision(revision);
+      } catch (ParseError &) {
+      }
+    }
+  } catch (ParseError &) {
+  }
+  std::filesystem::remove(filepath);
+  return 0;
+}
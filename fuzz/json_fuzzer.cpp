@@ -0,0 +1,27 @@
+#include "fuzz_util.h"
+
+#include "sg20_graphgen/serialization.h"
+
+using namespace sg20;
+
+// Loads the input and, if it is a valid collection, stores and reloads it,
+// which has to give the same encoding again.
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size) {
+  std::string stored;
+  try {
+    stored = fuzz::encode(loadModulesFromJSON(fuzz::asStringView(data, size)),
+                          OutputKind::JSON);
+  } catch (ParseError &) {
+    return 0;
+  }
+
+  try {
+    if (fuzz::encode(loadModulesFromJSON(stored), OutputKind::JSON) !=
+        stored) {
+      fuzz::fail("Reloaded JSON differs");
+    }
+  } catch (ParseError &) {
+    fuzz::fail("Stored JSON does not load");
+  }
+  return 0;
+}
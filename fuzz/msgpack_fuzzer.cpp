@@ -0,0 +1,28 @@
+#include "fuzz_util.h"
+
+#include "sg20_graphgen/serialization.h"
+
+using namespace sg20;
+
+// Loads the input and, if it is a valid collection, stores and reloads it,
+// which has to give the same encoding again.
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size) {
+  std::string stored;
+  try {
+    stored =
+        fuzz::encode(loadModulesFromMsgPack(fuzz::asStringView(data, size)),
+                     OutputKind::MsgPack);
+  } catch (ParseError &) {
+    return 0;
+  }
+
+  try {
+    if (fuzz::encode(loadModulesFromMsgPack(stored), OutputKind::MsgPack) !=
+        stored) {
+      fuzz::fail("Reloaded MessagePack differs");
+    }
+  } catch (ParseError &) {
+    fuzz::fail("Stored MessagePack does not load");
+  }
+  return 0;
+}
@@ -0,0 +1,38 @@
+#!/bin/sh
+# Builds the tests and the fuzz targets with AddressSanitizer and UBSan, runs
+# the tests and the corpus, and then fuzzes every target for FUZZ_SECONDS
+# seconds. Fuzzing needs clang, set CXX=clang++ if it is not the default
+# compiler; with other compilers only the tests and the corpus are run.
+# Finally, the snapshot stress test runs in a ThreadSanitizer build.
+#
+# Usage: fuzz/run_sanitized.sh [build directory]
+set -e
+
+source_dir=$(cd "$(dirname "$0")/.." && pwd)
+build_dir=${1:-"$source_dir/_sanitize_build"}
+fuzz_seconds=${FUZZ_SECONDS:-60}
+
+cmake -S "$source_dir" -B "$build_dir" -DCMAKE_BUILD_TYPE=RelWithDebInfo \
+  -DSG20GG_SANITIZE=ON -DSG20GG_TESTS=ON -DSG20GG_FUZZ=ON
+cmake --build "$build_dir" -j "$(nproc)"
+(cd "$build_dir" && ctest --output-on-failure)
+
+for target in commands history json msgpack yaml; do
+  fuzzer="$build_dir/bin/${target}Fuzzer"
+  if ! "$fuzzer" -help=1 2>&1 | grep -q libFuzzer; then
+    echo "Skipping fuzzing, the targets were not built with libFuzzer"
+    break
+  fi
+  # New inputs go into the build directory, the committed corpus only seeds.
+  mkdir -p "$build_dir/corpus/$target"
+  "$fuzzer" -max_total_time="$fuzz_seconds" \
+    -artifact_prefix="$build_dir/${target}-" \
+    "$build_dir/corpus/$target" "$source_dir/fuzz/corpus/$target"
+done
+
+# ThreadSanitizer cannot be combined with AddressSanitizer.
+tsan_build_dir="$build_dir-tsan"
+cmake -S "$source_dir" -B "$tsan_build_dir" -DCMAKE_BUILD_TYPE=RelWithDebInfo \
+  -DSG20GG_TSAN=ON -DSG20GG_TESTS=ON
+cmake --build "$tsan_build_dir" -j "$(nproc)" --target snapshotStressTest
+(cd "$tsan_build_dir" && ctest --output-on-failure -R snapshotStress)
@@ -0,0 +1,38 @@
+#include "fuzz_util.h"
+
+#include "sg20_graphgen/serialization.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Runs the fuzz target once on every input file, for compilers without
+// libFuzzer. Directories are expanded to the files in them, options of
+// libFuzzer, e.g., -runs=0, are ignored.
+int main(int argc, char *argv[]) {
+  std::vector<std::filesystem::path> inputs;
+  for (int index = 1; index < argc; ++index) {
+    std::filesystem::path path = argv[index];
+    if (argv[index][0] == '-') {
+      continue;
+    }
+    if (std::filesystem::is_directory(path)) {
+      for (auto &entry : std::filesystem::directory_iterator(path)) {
+        inputs.push_back(entry.path());
+      }
+    } else {
+      inputs.push_back(path);
+    }
+  }
+  std::sort(inputs.begin(), inputs.end());
+
+  for (auto &input : inputs) {
+    std::string contents = sg20::readFileContents(input);
+    LLVMFuzzerTestOneInput(reinterpret_cast<const uint8_t *>(contents.data()),
+                           contents.size());
+  }
+  std::cout << "Ran " << inputs.size() << " inputs\n";
+  return 0;
+}
@@ -0,0 +1,32 @@
+#include "fuzz_util.h"
+
+#include "sg20_graphgen/serialization.h"
+
+#include "yaml-cpp/exceptions.h"
+
+#include <optional>
+
+using namespace sg20;
+
+static std::optional<std::string> loadYAML(std::string_view input,
+                                           YAMLSplitting splitting) {
+  try {
+    return fuzz::encode(loadModulesFromYAML(input, splitting),
+                        OutputKind::YAML);
+  } catch (ParseError &) {
+  } catch (YAML::Exception &) {
+  }
+  return std::nullopt;
+}
+
+// Parses the input as a whole and split at module boundaries. Inputs that
+// cannot be split are parsed as a whole, so both results have to agree.
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size) {
+  std::string_view input = fuzz::asStringView(data, size);
+  auto serial = loadYAML(input, YAMLSplitting::Never);
+  auto split = loadYAML(input, YAMLSplitting::Always);
+  if (serial != split) {
+    fuzz::fail("Serial and split yaml parsing disagree");
+  }
+  return 0;
+}
@@ -0,0 +1,74 @@
+#ifndef SG20_GRAPHGEN_COMMANDS_H
+#define SG20_GRAPHGEN_COMMANDS_H
+
+#include "sg20_graphgen/modules.h"
+#include "sg20_graphgen/search_index.h"
+
+#include <istream>
+#include <ostream>
+#include <string_view>
+#include <type_traits>
+
+namespace sg20 {
+
+// Editing commands on a module collection, shared by the interactive
+// yamlEditor and the query server.
+enum class CommandType {
+  LIST_MODULES = 1,
+  LIST_TOPICS,
+  LIST_DEPENDENCIES,
+  ADD_MODULE,
+  DELETE_MODULE,
+  ADD_TOPIC,
+  DELETE_TOPIC,
+  ADD_DEPENDENCY,
+  DELETE_DEPENDENCY,
+  VALIDATE,
+  LIST_REV_DEPENDENCIES,
+  RENDER_MODULE,
+  FIND,
+  MOVE_TOPIC,
+  COMPACT_IDS,
+  MOVE_TOPICS,
+  HELP,
+  QUIT,
+  ERROR
+};
+
+constexpr auto commandToInt(CommandType cmd) {
+  return static_cast<std::underlying_type<CommandType>::type>(cmd);
+}
+
+// Converts a command name or number, e.g., "listModules" or "1", into the
+// corresponding command type. Returns CommandType::ERROR for unknown commands.
+CommandType convertToCommandType(std::string_view rawCmd);
+
+// Returns true if the command never modifies the collection.
+bool isReadOnlyCommand(CommandType cmd);
+
+// Prints the list of commands with their arguments.
+void printCommandHelp(std::ostream &out);
+
+// Runs the command on the collection. The command arguments are read from the
+// rest of the current line of in, results are printed to out and error
+// messages to err. HELP, QUIT, and ERROR are left to the caller. Returns
+// whether the command modified the collection.
+//
+// FIND uses the search index if one is passed, which is invalidated by all
+// commands that modify the collection. Otherwise, every FIND builds a new
+// index.
+bool executeCommand(ModuleCollection &moduleCollection, CommandType cmd,
+                    std::istream &in, std::ostream &out, std::ostream &err,
+                    LazySearchIndex *searchIndex = nullptr);
+
+// Runs a read only command, see isReadOnlyCommand, on a collection that other
+// threads may read at the same time, e.g., a snapshot. The collection must be
+// fully loaded.
+void executeReadOnlyCommand(const ModuleCollection &moduleCollection,
+                            CommandType cmd, std::istream &in,
+                            std::ostream &out, std::ostream &err,
+                            LazySearchIndex *searchIndex = nullptr);
+
+} // namespace sg20
+
+#endif // SG20_GRAPHGEN_COMMANDS_H
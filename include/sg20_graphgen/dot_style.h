@@ -0,0 +1,132 @@
+#ifndef SG20_GRAPHGEN_DOT_STYLE_H
+#define SG20_GRAPHGEN_DOT_STYLE_H
+
+#include "sg20_graphgen/modules.h"
+
+#include <array>
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace sg20 {
+
+// One rule of a style file. A rule applies to all elements it selects, later
+// rules override the attributes set by earlier ones.
+struct StyleRule {
+  enum class Target { Module, Topic, Edge };
+  Target target;
+
+  // Module name or ID. Edges are selected by the module of their source topic.
+  std::optional<std::string> module;
+  // Topic name or ID, only for topic rules.
+  std::optional<std::string> topic;
+  // Edge selectors, only for edge rules.
+  std::optional<DependencyKind> kind;
+  std::optional<bool> crossModule;
+  // Selects the edges on a critical path of the teaching schedule, i.e., hard
+  // dependencies between topics without slack in consecutive slots.
+  std::optional<bool> critical;
+
+  // Graphviz attributes in the order of the rule file.
+  std::vector<std::pair<std::string, std::string>> attributes;
+};
+
+// Parses a yaml style file of the form
+//
+//   Rules:
+//     - select: edge
+//       kind: soft
+//       crossModule: true
+//       attributes: {color: gray}
+//
+// Throws ParseError for malformed rules.
+std::vector<StyleRule> parseStyleRules(std::string_view input);
+
+// Style rules compiled against a collection. Every module has one row with the
+// attribute lists of its cluster, its topics, and every kind of edge leaving
+// it, so the emitters only look up the row once per module and index it per
+// element. Modules that are not named by any rule share the default row.
+class DotStyleSheet {
+public:
+  // Index into the attribute lists of the sheet.
+  using AttributesID = uint32_t;
+
+  struct ModuleStyle {
+    AttributesID cluster;
+    AttributesID topics;
+    // Indexed by getEdgeIndex.
+    std::array<AttributesID, 8> edges;
+  };
+
+  // Compiles the rules after the built-in defaults, Mrecord topic nodes and
+  // dotted soft dependencies. Rules that select unknown modules or topics are
+  // ignored.
+  DotStyleSheet(const std::vector<StyleRule> &rules,
+                const ModuleCollection &moduleCollection);
+
+  static DotStyleSheet loadFromFile(const std::filesystem::path &filepath,
+                                    const ModuleCollection &moduleCollection);
+
+  const ModuleStyle &getModuleStyle(const Module &module) const {
+    if (!moduleStyles.empty()) {
+      if (auto it = moduleStyles.find(module.getModuleID());
+          it != moduleStyles.end()) {
+        return it->second;
+      }
+    }
+    return defaultStyle;
+  }
+
+  // Comma separated attribute lists, empty if there are no attributes.
+  std::string_view getAttributes(AttributesID ID) const {
+    return attributeLists[ID];
+  }
+
+  // Attributes of a topic node that has rules of its own. Returns std::nullopt
+  // for topics styled like the other topics of their module.
+  std::optional<AttributesID> getTopicOverride(const Topic &topic) const {
+    if (topicStyles.empty()) {
+      return std::nullopt;
+    }
+    auto it = topicStyles.find(topic.getID());
+    if (it == topicStyles.end()) {
+      return std::nullopt;
+    }
+    return it->second;
+  }
+
+  AttributesID getEdgeStyle(const ModuleStyle &style, const Topic &topic,
+                            int dep, DependencyKind kind,
+                            bool crossModule) const {
+    bool critical = kind == DependencyKind::Hard && !criticalSlots.empty() &&
+                    isCriticalEdge(topic.getID(), dep);
+    return style.edges[getEdgeIndex(kind, crossModule, critical)];
+  }
+
+  static size_t getEdgeIndex(DependencyKind kind, bool crossModule,
+                             bool critical) {
+    return (kind == DependencyKind::Soft) * 4 + crossModule * 2 + critical;
+  }
+
+private:
+  bool isCriticalEdge(int topicID, int dep) const;
+
+  std::vector<std::string> attributeLists;
+  ModuleStyle defaultStyle;
+  // Rows of the modules named by rules, by module ID.
+  std::unordered_map<int, ModuleStyle> moduleStyles;
+  // Topic nodes named by rules, by topic ID.
+  std::unordered_map<int, AttributesID> topicStyles;
+  // Slot of every topic without slack, only computed if a rule selects
+  // critical edges.
+  std::unordered_map<int, int> criticalSlots;
+};
+
+} // namespace sg20
+
+#endif // SG20_GRAPHGEN_DOT_STYLE_H
@@ -0,0 +1,368 @@
+#ifndef SG20_GRAPHGEN_EMITTERS_H
+#define SG20_GRAPHGEN_EMITTERS_H
+
+#include "sg20_graphgen/dot_style.h"
+#include "sg20_graphgen/layout.h"
+#include "sg20_graphgen/modules.h"
+#include "sg20_graphgen/output_sink.h"
+#include "sg20_graphgen/traversal.h"
+#include "sg20_graphgen/util.h"
+
+#include "yaml-cpp/emitter.h"
+#include "yaml-cpp/emittermanip.h"
+
+#include "absl/strings/str_cat.h"
+
+#include <cassert>
+#include <cstdint>
+#include <map>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace sg20 {
+
+// Quotes the string if it is not a valid unquoted graphviz ID.
+std::string escapeDotString(std::string_view str);
+
+// Quotes and escapes the string for use in JSON.
+std::string escapeJSONString(std::string_view str);
+
+// Escapes the markup characters of the string for use in XML text and
+// attribute values.
+std::string escapeXMLString(std::string_view str);
+
+//===----------------------------------------------------------------------===//
+// Emitter policies for traverseModuleCollection
+
+// Emits the full dot graph with one cluster per module and one node per topic.
+// If rankLayout is set, the topics of a module on the same layer are placed on
+// the same rank. If style is set, the attributes of the clusters, nodes, and
+// edges are taken from the style sheet.
+class DotGraphEmitter : public EmitterPolicyBase {
+public:
+  DotGraphEmitter(OutputSink &out, const LayoutOrder *rankLayout = nullptr,
+                  const DotStyleSheet *style = nullptr)
+      : out(out), rankLayout(rankLayout), style(style) {}
+
+  void beginCollection(const ModuleCollection &moduleCollection) {
+    collection = &moduleCollection;
+    out << "digraph main {\n"
+        << "graph [\npack=true];\n";
+  }
+  void endCollection(const ModuleCollection &) {
+    out << crossModuleEdges << "}\n";
+  }
+
+  void beginModule(const Module &module) {
+    out << "subgraph " << escapeDotString("cluster_" + module.getModuleName())
+        << " {\n"
+        << "graph [\nlabel=" << escapeDotString(module.getModuleName());
+    if (!style) {
+      out << "];\n"
+          << "node [\nshape=Mrecord];\n";
+      return;
+    }
+
+    moduleStyle = &style->getModuleStyle(module);
+    appendAttributes(style->getAttributes(moduleStyle->cluster));
+    out << "];\n"
+        << "node [\n" << style->getAttributes(moduleStyle->topics) << "];\n";
+  }
+  void endModule(const Module &) {
+    for (auto &[layer, topicIDs] : moduleRanks) {
+      if (topicIDs.size() < 2) {
+        continue;
+      }
+      out << "{rank=same;";
+      for (int topicID : topicIDs) {
+        out << " " << topicID << ";";
+      }
+      out << "}\n";
+    }
+    moduleRanks.clear();
+
+    out << moduleEdges << "}\n";
+    moduleEdges.clear();
+  }
+
+  void beginTopic(const Module &, const Topic &topic) {
+    out << topic.getID() << "[label=" << escapeDotString(topic.getName());
+    if (style) {
+      if (auto topicStyle = style->getTopicOverride(topic)) {
+        appendAttributes(style->getAttributes(*topicStyle));
+      }
+    }
+    out << "];\n";
+    if (rankLayout) {
+      moduleRanks[rankLayout->getLayer(topic.getID())].push_back(topic.getID());
+    }
+  }
+
+  void emitDependency(const Module &module, const Topic &topic, int dep,
+                      DependencyKind kind) {
+    const Module *depModule = collection->getModuleFromTopicID(dep);
+    if (!depModule) {
+      return; // skip dangling dependencies
+    }
+
+    // Edges inside a module are placed in the module cluster after all nodes,
+    // edges between modules are emitted at the end of the graph.
+    std::string &edges = depModule == &module ? moduleEdges : crossModuleEdges;
+    if (!style) {
+      absl::StrAppend(&edges, topic.getID(), " -> ", dep,
+                      kind == DependencyKind::Soft ? "[style=dotted]" : "",
+                      ";\n");
+      return;
+    }
+
+    std::string_view attributes = style->getAttributes(style->getEdgeStyle(
+        *moduleStyle, topic, dep, kind, depModule != &module));
+    if (attributes.empty()) {
+      absl::StrAppend(&edges, topic.getID(), " -> ", dep, ";\n");
+    } else {
+      absl::StrAppend(&edges, topic.getID(), " -> ", dep, "[", attributes,
+                      "];\n");
+    }
+  }
+
+private:
+  void appendAttributes(std::string_view attributes) {
+    if (!attributes.empty()) {
+      out << ", " << attributes;
+    }
+  }
+
+  OutputSink &out;
+  const LayoutOrder *rankLayout;
+  const DotStyleSheet *style;
+  const DotStyleSheet::ModuleStyle *moduleStyle = nullptr;
+  const ModuleCollection *collection = nullptr;
+  std::map<int, std::vector<int>> moduleRanks;
+  std::string moduleEdges;
+  std::string crossModuleEdges;
+};
+
+// Emits the collection in the yaml format read by loadModulesFromFile.
+class YAMLEmitter : public EmitterPolicyBase {
+public:
+  YAMLEmitter(OutputSink &out) : stream(out), yamlOut(stream) {}
+
+  void beginCollection(const ModuleCollection &) {
+    yamlOut << YAML::BeginDoc << YAML::BeginMap;
+    yamlOut << "Modules" << YAML::BeginSeq;
+  }
+  void endCollection(const ModuleCollection &) {
+    yamlOut << YAML::EndSeq << YAML::EndMap << YAML::EndDoc;
+    assert(yamlOut.good() && "Generated YAML was wrongly formated.");
+  }
+
+  void beginModule(const Module &module) {
+    yamlOut << YAML::BeginMap;
+    yamlOut << "name" << module.getModuleName();
+    yamlOut << "mid" << module.getModuleID();
+    yamlOut << "sub" << YAML::BeginSeq;
+  }
+  void endModule(const Module &) { yamlOut << YAML::EndSeq << YAML::EndMap; }
+
+  void beginTopic(const Module &, const Topic &topic) {
+    yamlOut << YAML::BeginMap;
+    yamlOut << "name" << topic.getName();
+    yamlOut << "tid" << topic.getID();
+  }
+  void endTopic(const Module &, const Topic &) {
+    if (openDeps) {
+      yamlOut << YAML::EndSeq;
+      openDeps.reset();
+    }
+    yamlOut << YAML::EndMap;
+  }
+
+  void emitDependency(const Module &, const Topic &, int dep,
+                      DependencyKind kind) {
+    if (openDeps != kind) {
+      if (openDeps) {
+        yamlOut << YAML::EndSeq;
+      }
+      yamlOut << (kind == DependencyKind::Hard ? "dep" : "softdep");
+      yamlOut << YAML::BeginSeq;
+      openDeps = kind;
+    }
+    yamlOut << dep;
+  }
+
+private:
+  // yaml-cpp only writes to streams.
+  OutputSinkStream stream;
+  YAML::Emitter yamlOut;
+  std::optional<DependencyKind> openDeps;
+};
+
+// Emits the collection as JSON, using the same schema as the yaml format.
+class JSONEmitter : public EmitterPolicyBase {
+public:
+  JSONEmitter(OutputSink &out) : out(out) {}
+
+  void beginCollection(const ModuleCollection &) {
+    out << "{\"Modules\": [";
+    moduleSep = "\n";
+  }
+  void endCollection(const ModuleCollection &) { out << "\n]}\n"; }
+
+  void beginModule(const Module &module) {
+    out << moduleSep << "{\"name\": "
+        << escapeJSONString(module.getModuleName())
+        << ", \"mid\": " << module.getModuleID() << ", \"sub\": [";
+    moduleSep = ",\n";
+    topicSep = "\n  ";
+  }
+  void endModule(const Module &) { out << "]}"; }
+
+  void beginTopic(const Module &, const Topic &topic) {
+    out << topicSep << "{\"name\": " << escapeJSONString(topic.getName())
+        << ", \"tid\": " << topic.getID();
+    topicSep = ",\n  ";
+  }
+  void endTopic(const Module &, const Topic &) {
+    if (openDeps) {
+      out << "]";
+      openDeps.reset();
+    }
+    out << "}";
+  }
+
+  void emitDependency(const Module &, const Topic &, int dep,
+                      DependencyKind kind) {
+    if (openDeps != kind) {
+      if (openDeps) {
+        out << "]";
+      }
+      out << (kind == DependencyKind::Hard ? ", \"dep\": ["
+                                            : ", \"softdep\": [");
+      openDeps = kind;
+    } else {
+      out << ", ";
+    }
+    out << dep;
+  }
+
+private:
+  OutputSink &out;
+  std::string_view moduleSep;
+  std::string_view topicSep;
+  std::optional<DependencyKind> openDeps;
+};
+
+// Emits the collection as MessagePack, using the same schema as the yaml
+// format. All maps and arrays are written with their exact length.
+class MsgPackEmitter : public EmitterPolicyBase {
+public:
+  MsgPackEmitter(OutputSink &out) : out(out) {}
+
+  void beginCollection(const ModuleCollection &moduleCollection) {
+    writeMapHeader(1);
+    writeString("Modules");
+    writeArrayHeader(moduleCollection.numModules());
+  }
+
+  void beginModule(const Module &module) {
+    writeMapHeader(3);
+    writeString("name");
+    writeString(module.getModuleName());
+    writeString("mid");
+    writeInt(module.getModuleID());
+    writeString("sub");
+    writeArrayHeader(module.numTopics());
+  }
+
+  void beginTopic(const Module &, const Topic &topic) {
+    writeMapHeader(2 + (topic.numDependencies() > 0) +
+                   (topic.numSoftDependencies() > 0));
+    writeString("name");
+    writeString(topic.getName());
+    writeString("tid");
+    writeInt(topic.getID());
+    openDeps.reset();
+  }
+
+  void emitDependency(const Module &, const Topic &topic, int dep,
+                      DependencyKind kind) {
+    if (openDeps != kind) {
+      if (kind == DependencyKind::Hard) {
+        writeString("dep");
+        writeArrayHeader(topic.numDependencies());
+      } else {
+        writeString("softdep");
+        writeArrayHeader(topic.numSoftDependencies());
+      }
+      openDeps = kind;
+    }
+    writeInt(dep);
+  }
+
+private:
+  void writeBigEndian(uint64_t value, int bytes) {
+    char buffer[8];
+    for (int i = bytes - 1; i >= 0; --i) {
+      buffer[i] = static_cast<char>(value & 0xFF);
+      value >>= 8;
+    }
+    out.write(std::string_view(buffer, bytes));
+  }
+
+  void writeTagged(uint8_t tag, uint64_t value, int bytes) {
+    out.put(static_cast<char>(tag));
+    writeBigEndian(value, bytes);
+  }
+
+  void writeMapHeader(size_t size) {
+    if (size < 16) {
+      out.put(static_cast<char>(0x80 | size));
+    } else if (size <= 0xFFFF) {
+      writeTagged(0xDE, size, 2);
+    } else {
+      writeTagged(0xDF, size, 4);
+    }
+  }
+
+  void writeArrayHeader(size_t size) {
+    if (size < 16) {
+      out.put(static_cast<char>(0x90 | size));
+    } else if (size <= 0xFFFF) {
+      writeTagged(0xDC, size, 2);
+    } else {
+      writeTagged(0xDD, size, 4);
+    }
+  }
+
+  void writeString(std::string_view str) {
+    if (str.size() < 32) {
+      out.put(static_cast<char>(0xA0 | str.size()));
+    } else if (str.size() <= 0xFF) {
+      writeTagged(0xD9, str.size(), 1);
+    } else if (str.size() <= 0xFFFF) {
+      writeTagged(0xDA, str.size(), 2);
+    } else {
+      writeTagged(0xDB, str.size(), 4);
+    }
+    out.write(str);
+  }
+
+  void writeInt(int value) {
+    if (value >= 0 && value <= 0x7F) {
+      out.put(static_cast<char>(value));
+    } else if (value >= -32 && value < 0) {
+      out.put(static_cast<char>(value));
+    } else {
+      writeTagged(0xD2, static_cast<uint32_t>(value), 4);
+    }
+  }
+
+  OutputSink &out;
+  std::optional<DependencyKind> openDeps;
+};
+
+} // namespace sg20
+
+#endif // SG20_GRAPHGEN_EMITTERS_H
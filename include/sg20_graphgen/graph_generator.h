@@ -1,18 +1,105 @@
 #ifndef SG20_GRAPHGEN_GRAPHGENERATOR_H
 #define SG20_GRAPHGEN_GRAPHGENERATOR_H
 
+#include "sg20_graphgen/dot_style.h"
+#include "sg20_graphgen/metrics.h"
 #include "sg20_graphgen/modules.h"
+#include "sg20_graphgen/output_sink.h"
+#include "sg20_graphgen/schedule.h"
+#include "sg20_graphgen/spilled_collection.h"
 
 #include <filesystem>
+#include <optional>
+#include <string_view>
+#include <vector>
 
 namespace sg20 {
 
+struct DotLayoutOptions {
+  // Emit modules and topics in the order computed by computeLayoutOrder
+  // instead of the collection order, which gives dot fewer crossings to
+  // resolve. Off until bench/dot_layout_bench shows a render time win.
+  bool layoutOrder = false;
+  // Place the topics of a module on the same topological layer on the same
+  // rank.
+  bool rankSame = false;
+};
+
+// The emit functions throw std::runtime_error if the output cannot be written.
+//
+// The dot outputs take their attributes from style if it is set, otherwise
+// the built-in styling is used.
 void emitFullDotGraph(const ModuleCollection &moduleCollection,
-                      std::filesystem::path outputFilename);
+                      std::filesystem::path outputFilename,
+                      const DotLayoutOptions &layoutOptions = {},
+                      const DotStyleSheet *style = nullptr);
+
+// Same output as emitFullDotGraph without a style, written module by module
+// from the spilled collection. The cross-module edges are emitted in a second
+// pass instead of being collected in memory.
+void emitFullDotGraph(const SpilledCollection &spilledCollection,
+                      std::filesystem::path outputFilename,
+                      const DotLayoutOptions &layoutOptions = {});
 
 void emitHTMLDotGraph(const ModuleCollection &moduleCollection,
                       std::filesystem::path outputFilename,
-                      bool includeDependecies = false);
+                      bool includeDependecies = false,
+                      const DotStyleSheet *style = nullptr);
+
+// Lays out the full graph with the native layout engine and stores it as SVG.
+void emitSVGGraph(const ModuleCollection &moduleCollection,
+                  std::filesystem::path outputFilename);
+
+// Stores the schedule as HTML page if the filename ends in .html, otherwise
+// as CSV.
+void emitSchedule(const Schedule &schedule,
+                  std::filesystem::path outputFilename);
+
+// Stores the metrics as JSON if the filename ends in .json, otherwise as a
+// human readable report.
+void emitMetrics(const CollectionMetrics &metrics,
+                 std::filesystem::path outputFilename);
+
+//===----------------------------------------------------------------------===//
+// Multi output generation
+
+enum class OutputKind {
+  FullDot,         // dot
+  HTMLDot,         // htmldot
+  HTMLDotWithDeps, // htmldot-deps
+  HTMLTable,       // html
+  YAML,            // yaml
+  JSON,            // json
+  MsgPack,         // msgpack
+  SVG,             // svg
+  HTMLExplorer,    // explorer
+};
+
+struct OutputTarget {
+  OutputKind kind;
+  std::filesystem::path path;
+};
+
+// Parses an output kind name, e.g., dot or htmldot-deps. Returns std::nullopt
+// for unknown names.
+std::optional<OutputKind> parseOutputKind(std::string_view kindName);
+
+// Parses an output target specification of the form KIND=PATH, e.g.,
+// dot=sg20_graph.dot. Returns std::nullopt for malformed specifications.
+std::optional<OutputTarget> parseOutputTarget(std::string_view spec);
+
+// Writes one output into the sink, e.g., into memory.
+void writeOutput(const ModuleCollection &moduleCollection, OutputKind kind,
+                 OutputSink &out, const DotLayoutOptions &layoutOptions = {},
+                 const DotStyleSheet *style = nullptr);
+
+// Writes all outputs, each one on its own thread. The collection is only read,
+// so the writers can share it without synchronization. Throws the error of the
+// first output that could not be written, after all writers are done.
+void emitOutputs(const ModuleCollection &moduleCollection,
+                 const std::vector<OutputTarget> &targets,
+                 const DotLayoutOptions &layoutOptions = {},
+                 const DotStyleSheet *style = nullptr);
 
 } // namespace sg20
 
@@ -0,0 +1,75 @@
+#ifndef SG20_GRAPHGEN_HISTORY_H
+#define SG20_GRAPHGEN_HISTORY_H
+
+#include "sg20_graphgen/modules.h"
+
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+namespace sg20 {
+
+struct HistoryOptions {
+  // Every revision with this number of revisions since the last checkpoint is
+  // stored in full, which bounds the number of deltas applied to reconstruct
+  // a revision.
+  size_t checkpointInterval = 32;
+};
+
+// Append-only store of the revisions of a collection. Every revision is
+// recorded as the module, topic, and dependency changes against the previous
+// one, so the file grows with the size of the changes. Checkpoints store a
+// revision in full and are written periodically, and whenever the changes
+// would be larger than the full revision.
+//
+// The file starts with a magic number, followed by one record per revision
+// with its length, kind, and checksum. A record that was not completely
+// written, e.g., because the writer was killed, is ignored and overwritten by
+// the next revision.
+class HistoryStore {
+public:
+  // Opens the store, an empty one if the file does not exist yet. Throws
+  // ParseError if the file is not a history file.
+  explicit HistoryStore(std::filesystem::path filepath,
+                        HistoryOptions options = {});
+
+  size_t numRevisions() const { return records.size(); }
+
+  // Appends the collection as the newest revision and returns its number. If
+  // nothing changed since the newest revision, no revision is appended and the
+  // number of the newest revision is returned. Throws std::runtime_error for
+  // collections with duplicate module or topic IDs, which cannot be stored as
+  // changes.
+  size_t appendRevision(const ModuleCollection &moduleCollection);
+
+  // Reconstructs the collection of the revision from the closest checkpoint
+  // before it. Throws std::out_of_range for unknown revisions and ParseError
+  // if the file is corrupted.
+  ModuleCollection loadRevision(size_t revision) const;
+
+private:
+  enum class RecordKind : uint8_t { Checkpoint = 1, Delta = 2 };
+
+  struct Record {
+    uint64_t offset;
+    uint32_t length;
+    uint32_t checksum;
+    RecordKind kind;
+    // Revision of the checkpoint the record is based on.
+    size_t checkpoint;
+  };
+
+  // Reads the records from the checkpoint of the revision up to it.
+  std::vector<std::string> readChanges(size_t revision) const;
+
+  std::filesystem::path filepath;
+  HistoryOptions options;
+  std::vector<Record> records;
+  // End of the last complete record, appends start here.
+  uint64_t validEnd = 0;
+};
+
+} // namespace sg20
+
+#endif // SG20_GRAPHGEN_HISTORY_H
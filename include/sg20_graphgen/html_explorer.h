@@ -0,0 +1,24 @@
+#ifndef SG20_GRAPHGEN_HTMLEXPLORER_H
+#define SG20_GRAPHGEN_HTMLEXPLORER_H
+
+#include "sg20_graphgen/modules.h"
+#include "sg20_graphgen/output_sink.h"
+
+namespace sg20 {
+
+// Writes a self-contained HTML page to explore the collection. Modules are
+// expanded and collapsed on click, topics and modules can be searched, and
+// selecting a topic highlights its prerequisites, soft prerequisites, and
+// dependents.
+//
+// The page does not lay out or index anything itself: the topic numbering, the
+// dependencies and dependents of every topic, and the topological layers are
+// computed here and embedded as base64 encoded arrays of delta encoded LEB128
+// varints, which the page decodes into typed arrays on load. Topics of a module
+// are only turned into DOM nodes when the module is expanded.
+void writeHTMLExplorer(const ModuleCollection &moduleCollection,
+                       OutputSink &out);
+
+} // namespace sg20
+
+#endif // SG20_GRAPHGEN_HTMLEXPLORER_H
@@ -1,10 +1,20 @@
 #ifndef SG20_GRAPHGEN_HTMLGENERATOR_H
 #define SG20_GRAPHGEN_HTMLGENERATOR_H
 
+#include "sg20_graphgen/dot_style.h"
 #include "sg20_graphgen/modules.h"
+#include "sg20_graphgen/output_sink.h"
+#include "sg20_graphgen/schedule.h"
+#include "sg20_graphgen/traversal.h"
 
 #include "HTML/HTML.h"
 
+#include "absl/strings/str_cat.h"
+
+#include <filesystem>
+#include <string>
+#include <vector>
+
 namespace sg20 {
 
 //===----------------------------------------------------------------------===//
@@ -14,10 +24,200 @@ HTML::Table generateHTMLTable(const ModuleCollection &moduleCollection,
                               int maxRows = 3);
 HTML::Col generateHTMLCol(const Module &module);
 
+// Builds the HTML table of the given modules of the collection. If
+// moduleAnchors is set, the cell of every module gets the ID returned by
+// getModuleAnchor.
+HTML::Table generateHTMLTable(const ModuleCollection &moduleCollection,
+                              const std::vector<const Module *> &modules,
+                              int maxRows = 3, bool moduleAnchors = false);
+
+std::string getModuleAnchor(const Module &module);
+
+//===----------------------------------------------------------------------===//
+// Split HTML output
+
+// One page of an HTML table that is split over multiple files.
+struct HTMLPage {
+  std::string title;
+  // File name of the page, relative to the index page.
+  std::filesystem::path fileName;
+  std::vector<const Module *> modules;
+};
+
+// Shards the modules in collection order into at most numPages pages with
+// about the same number of topics each. Pages are named after the index file,
+// e.g., sg20_modules_1.html for sg20_modules.html.
+std::vector<HTMLPage>
+splitModulesIntoPages(const ModuleCollection &moduleCollection,
+                      size_t numPages, const std::filesystem::path &indexFile);
+
+// Creates one page per first letter of the module names. Modules that do not
+// start with a letter or digit are put on a page named "other".
+std::vector<HTMLPage>
+splitModulesByLetter(const ModuleCollection &moduleCollection,
+                     const std::filesystem::path &indexFile);
+
+HTML::Document generateHTMLPage(const ModuleCollection &moduleCollection,
+                                const HTMLPage &page,
+                                const std::filesystem::path &indexFile,
+                                int maxRows = 3);
+
+// Builds the index page, which links every page and every module on it.
+HTML::Document generateHTMLIndex(const std::vector<HTMLPage> &pages);
+
+// Writes all pages next to the index file in parallel, followed by the index.
+// Throws std::runtime_error if a page or the index cannot be written.
+void emitSplitHTMLTables(const ModuleCollection &moduleCollection,
+                         const std::vector<HTMLPage> &pages,
+                         const std::filesystem::path &indexFile,
+                         int maxRows = 3);
+
+//===----------------------------------------------------------------------===//
+// Schedule output
+
+// Builds a table with one row per slot and one column per track, where every
+// cell names the module and the topic taught on the track.
+HTML::Table generateScheduleHTMLTable(const Schedule &schedule);
+
+// Builds a page with the schedule table, preceded by the critical path.
+HTML::Document generateScheduleHTMLPage(const Schedule &schedule);
+
 //===----------------------------------------------------------------------===//
 // Dot HTML generator functions
 
 HTML::Table generateDotHTMLTable(const Module &module);
+HTML::Table generateDotHTMLTableHeader(const Module &module);
+HTML::Row generateDotHTMLTopicRow(const Topic &topic);
+
+//===----------------------------------------------------------------------===//
+// Emitter policies for traverseModuleCollection
+
+// Builds the HTML table of all modules, placing maxRows modules in each row.
+class HTMLTableEmitter : public EmitterPolicyBase {
+public:
+  HTMLTableEmitter(int maxRows = 3, bool moduleAnchors = false)
+      : maxRows(maxRows), moduleAnchors(moduleAnchors) {}
+
+  void endCollection(const ModuleCollection &) {
+    if (moduleCounter % maxRows != 0) {
+      table << std::move(row);
+      row = HTML::Row();
+    }
+  }
+
+  void beginModule(const Module &module) {
+    col = HTML::Col();
+    if (moduleAnchors) {
+      col.addAttribute("id", getModuleAnchor(module));
+    }
+    col << HTML::Bold(module.getModuleName());
+    topicList = HTML::List();
+  }
+  void endModule(const Module &) {
+    moduleCounter += 1;
+
+    col << std::move(topicList);
+    row << std::move(col);
+    if (moduleCounter % maxRows == 0) { // persist in table and create next row
+      table << std::move(row);
+      row = HTML::Row();
+    }
+  }
+
+  void beginTopic(const Module &, const Topic &topic) {
+    topicList << HTML::ListItem(topic.getName());
+  }
+
+  HTML::Table takeTable() { return std::move(table); }
+
+private:
+  const int maxRows;
+  const bool moduleAnchors;
+  int moduleCounter = 0;
+  HTML::Table table;
+  HTML::Row row;
+  HTML::Col col;
+  HTML::List topicList;
+};
+
+// Emits a dot graph with one HTML table node per module. Dependencies, if
+// included, connect the table rows of the topics. If style is set, the module
+// nodes get the cluster attributes and the dependencies the edge attributes of
+// the style sheet.
+class HTMLDotGraphEmitter : public EmitterPolicyBase {
+public:
+  HTMLDotGraphEmitter(OutputSink &out, bool includeDependencies = false,
+                      const DotStyleSheet *style = nullptr)
+      : out(out), tableStream(out), includeDependencies(includeDependencies),
+        style(style) {}
+
+  void beginCollection(const ModuleCollection &moduleCollection) {
+    collection = &moduleCollection;
+    out << "digraph main {\n";
+  }
+  void endCollection(const ModuleCollection &) { out << dependencies << "}"; }
+
+  void beginModule(const Module &module) {
+    moduleTable = generateDotHTMLTableHeader(module);
+    if (style) {
+      moduleStyle = &style->getModuleStyle(module);
+    }
+  }
+  void endModule(const Module &module) {
+    out << module.getModuleID() << "[shape=box";
+    if (style) {
+      if (auto attributes = style->getAttributes(moduleStyle->cluster);
+          !attributes.empty()) {
+        out << ", " << attributes;
+      }
+    }
+    out << ", label=<";
+    tableStream << moduleTable;
+    out << ">];\n";
+  }
+
+  void beginTopic(const Module &, const Topic &topic) {
+    moduleTable << generateDotHTMLTopicRow(topic);
+  }
+
+  void emitDependency(const Module &module, const Topic &topic, int dep,
+                      DependencyKind kind) {
+    if (!includeDependencies) {
+      return;
+    }
+    const Module *depModule = collection->getModuleFromTopicID(dep);
+    if (!depModule) {
+      return; // skip dangling dependencies
+    }
+    absl::StrAppend(&dependencies, module.getModuleID(), ":", topic.getID(),
+                    " -> ", depModule->getModuleID(), ":", dep);
+    if (!style) {
+      absl::StrAppend(&dependencies,
+                      kind == DependencyKind::Soft ? "[style=\"dotted\"]" : "",
+                      ";\n");
+      return;
+    }
+
+    std::string_view attributes = style->getAttributes(style->getEdgeStyle(
+        *moduleStyle, topic, dep, kind, depModule != &module));
+    if (attributes.empty()) {
+      absl::StrAppend(&dependencies, ";\n");
+    } else {
+      absl::StrAppend(&dependencies, "[", attributes, "];\n");
+    }
+  }
+
+private:
+  OutputSink &out;
+  // The HTML builder only writes to streams.
+  OutputSinkStream tableStream;
+  const bool includeDependencies;
+  const DotStyleSheet *style;
+  const DotStyleSheet::ModuleStyle *moduleStyle = nullptr;
+  const ModuleCollection *collection = nullptr;
+  HTML::Table moduleTable;
+  std::string dependencies;
+};
 
 } // namespace sg20
 
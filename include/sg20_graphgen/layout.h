@@ -0,0 +1,107 @@
+#ifndef SG20_GRAPHGEN_LAYOUT_H
+#define SG20_GRAPHGEN_LAYOUT_H
+
+#include "sg20_graphgen/modules.h"
+#include "sg20_graphgen/traversal.h"
+
+#include <unordered_map>
+#include <vector>
+
+namespace sg20 {
+
+// Order in which modules and topics are emitted into a dot graph.
+//
+// On large graphs, graphviz spends most of its time in crossing minimization,
+// which starts from the order of the nodes in the input. Emitting the nodes in
+// an order that already has few crossings gives it a better starting point.
+struct LayoutOrder {
+  struct ModuleOrder {
+    const Module *module;
+    std::vector<const Topic *> topics;
+  };
+  std::vector<ModuleOrder> modules;
+
+  // Topological layer of every topic by ID. Topics without dependencies are
+  // on layer 0, every other topic is one layer above its highest dependency.
+  std::unordered_map<int, int> layers;
+
+  int getLayer(int topicID) const {
+    auto layer = layers.find(topicID);
+    return layer != layers.end() ? layer->second : 0;
+  }
+};
+
+// Layers the dependency graph (hard and soft dependencies) topologically and
+// reorders the topics of each layer with the barycenter heuristic, alternating
+// between upward and downward sweeps. The order with the fewest crossings
+// between adjacent layers is kept. Modules keep their collection order and
+// the topics of a module stay together, as dot draws every module as a
+// cluster. Cycles are broken at the topic that comes first in the collection.
+LayoutOrder computeLayoutOrder(const ModuleCollection &moduleCollection,
+                               int sweeps = 4);
+
+// Dependency graph of topics that are numbered densely in collection order,
+// for collections that are not held as ModuleCollection.
+struct LayoutGraph {
+  size_t numModules = 0;
+  // Module number of every topic.
+  std::vector<int> moduleOfTopic;
+  // Pairs of a topic and one of its hard or soft dependencies. Dangling
+  // dependencies and self loops are left out.
+  std::vector<std::pair<int, int>> edges;
+};
+
+struct LayoutRanking {
+  // Topics of every module in layout order, from the highest layer to the
+  // lowest.
+  std::vector<std::vector<int>> moduleTopics;
+  // Topological layer of every topic.
+  std::vector<int> layers;
+};
+
+// Same as computeLayoutOrder on the dense graph, which it consumes.
+LayoutRanking rankLayoutGraph(LayoutGraph graph, int sweeps = 4);
+
+// Coordinates of a layered drawing, in pixels with the origin at the top left.
+struct GraphLayout {
+  struct Box {
+    double x;
+    double y;
+    double width;
+    double height;
+  };
+  // Node box of every topic by ID.
+  std::unordered_map<int, Box> topicBoxes;
+  // Cluster box of every module, in the order of LayoutOrder::modules.
+  std::vector<Box> moduleBoxes;
+  double width = 0;
+  double height = 0;
+};
+
+// Assigns coordinates to the layout order. Every layer is a row, dependents
+// above their dependencies, and every module is a column that is wide enough
+// to hold its topics of each layer side by side. Topics are pulled towards the
+// mean position of their neighbours for the given number of iterations, the
+// layers are processed in parallel.
+GraphLayout computeGraphLayout(const LayoutOrder &order, int iterations = 8);
+
+// Same as traverseModuleCollection but visits modules and topics in layout
+// order, topics are visited from the highest layer to the lowest.
+template <typename... EmitterTys>
+void traverseInLayoutOrder(const ModuleCollection &moduleCollection,
+                           const LayoutOrder &order, EmitterTys &...emitters) {
+  (emitters.beginCollection(moduleCollection), ...);
+  for (auto &moduleOrder : order.modules) {
+    const Module &module = *moduleOrder.module;
+    (emitters.beginModule(module), ...);
+    for (const Topic *topic : moduleOrder.topics) {
+      detail::traverseTopic(module, *topic, emitters...);
+    }
+    (emitters.endModule(module), ...);
+  }
+  (emitters.endCollection(moduleCollection), ...);
+}
+
+} // namespace sg20
+
+#endif // SG20_GRAPHGEN_LAYOUT_H
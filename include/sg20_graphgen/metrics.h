@@ -0,0 +1,70 @@
+#ifndef SG20_GRAPHGEN_METRICS_H
+#define SG20_GRAPHGEN_METRICS_H
+
+#include "sg20_graphgen/modules.h"
+#include "sg20_graphgen/output_sink.h"
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace sg20 {
+
+// Metrics of the dependencies between the modules of a collection, to track
+// how modular the collection is over time. Dangling dependencies are counted
+// but otherwise ignored.
+struct CollectionMetrics {
+  struct ModuleMetrics {
+    int moduleID;
+    std::string name;
+    size_t numTopics = 0;
+    // Number of other modules that depend on this module (fan-in), and that
+    // this module depends on (fan-out), by hard or soft dependencies.
+    size_t fanIn = 0;
+    size_t fanOut = 0;
+    // Number of dependencies from topics of other modules on this module, and
+    // from this module on topics of other modules.
+    size_t incomingEdges = 0;
+    size_t outgoingEdges = 0;
+    // Number of topics of the longest chain of hard dependencies between
+    // topics of the module. Cycles are broken at the topic that comes first
+    // in the module.
+    size_t longestChain = 0;
+  };
+  std::vector<ModuleMetrics> modules;
+
+  size_t numTopics = 0;
+  size_t hardEdges = 0;
+  size_t softEdges = 0;
+  size_t danglingEdges = 0;
+  size_t crossModuleHardEdges = 0;
+  size_t crossModuleSoftEdges = 0;
+
+  // Number of cycles between modules, i.e., strongly connected components of
+  // more than one module in the graph of the hard dependencies between
+  // modules, and the number of modules on them.
+  size_t moduleCycles = 0;
+  size_t modulesInCycles = 0;
+
+  // Number of topics by the number of topics they depend on (out-degree) and
+  // that depend on them (in-degree), by hard or soft dependencies. The index is
+  // the degree.
+  std::vector<size_t> inDegrees;
+  std::vector<size_t> outDegrees;
+};
+
+// Computes the metrics in a single pass over the modules, topics, and
+// dependencies, distributed over all hardware threads. Every thread counts
+// into its own accumulator, which are merged at the end, so the pass runs in
+// O(T + E) for T topics and E dependencies, plus the size of the module graph.
+CollectionMetrics computeMetrics(const ModuleCollection &moduleCollection);
+
+// Writes the metrics as a human readable report.
+void writeMetricsReport(const CollectionMetrics &metrics, OutputSink &out);
+
+// Writes the metrics as a JSON object.
+void writeMetricsJSON(const CollectionMetrics &metrics, OutputSink &out);
+
+} // namespace sg20
+
+#endif // SG20_GRAPHGEN_METRICS_H
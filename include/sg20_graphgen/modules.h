@@ -5,13 +5,19 @@
 
 #include <algorithm>
 #include <filesystem>
+#include <functional>
+#include <limits>
 #include <memory>
 #include <string>
 #include <string_view>
+#include <unordered_map>
+#include <utility>
 #include <vector>
 
 namespace sg20 {
 
+enum class DependencyKind { Hard, Soft };
+
 class Topic {
 public:
   Topic(const std::string name, int ID) : name(name), ID(ID) {}
@@ -20,46 +26,79 @@ public:
   void rename(std::string newName) { name = newName; }
   int getID() const { return ID; }
 
-  auto deps_begin() { return deps.begin(); }
-  auto deps_end() { return deps.end(); }
   auto deps_begin() const { return deps.begin(); }
   auto deps_end() const { return deps.end(); }
-  auto soft_begin() { return softDeps.begin(); }
-  auto soft_end() { return softDeps.end(); }
   auto soft_begin() const { return softDeps.begin(); }
   auto soft_end() const { return softDeps.end(); }
 
-  auto dependencies() { return make_range(deps_begin(), deps_end()); }
-  auto softDependencies() { return make_range(soft_begin(), soft_end()); }
   auto dependencies() const { return make_range(deps_begin(), deps_end()); }
   auto softDependencies() const { return make_range(soft_begin(), soft_end()); }
 
-  void addDependency(int TID) { deps.push_back(TID); }
-  void addSoftDependency(int TID) { softDeps.push_back(TID); }
+  // Reverse edges, i.e., the IDs of topics that depend on this topic. These
+  // are kept up to date by the Topic based add/remove dependency functions.
+  // In lazily loaded collections, only dependents in loaded modules are known.
+  auto rev_deps_begin() const { return revDeps.begin(); }
+  auto rev_deps_end() const { return revDeps.end(); }
+  auto rev_soft_begin() const { return revSoftDeps.begin(); }
+  auto rev_soft_end() const { return revSoftDeps.end(); }
 
-  void removeDependency(int TID) {
-    auto foundDep = std::remove(deps.begin(), deps.end(), TID);
-    if (foundDep != deps.end()) {
-      deps.erase(foundDep);
-    }
+  auto dependents() const {
+    return make_range(rev_deps_begin(), rev_deps_end());
   }
-  void removeSoftDependency(int TID) {
-    auto foundDep = std::remove(softDeps.begin(), softDeps.end(), TID);
-    if (foundDep != softDeps.end()) {
-      softDeps.erase(foundDep);
-    }
+  auto softDependents() const {
+    return make_range(rev_soft_begin(), rev_soft_end());
+  }
+
+  bool hasDependency(int TID) const { return deps.contains(TID); }
+  bool hasSoftDependency(int TID) const { return softDeps.contains(TID); }
+
+  // Adds a dependency by ID only, without recording the reverse edge. Use this
+  // for targets that are not (yet) part of the collection.
+  // Returns false if the dependency already existed.
+  bool addDependency(int TID) { return deps.insert(TID); }
+  bool addSoftDependency(int TID) { return softDeps.insert(TID); }
+
+  // Adds a dependency to target and records the reverse edge on target, also
+  // if the dependency was already added by ID only.
+  // Returns false if the dependency already existed.
+  bool addDependency(Topic &target) {
+    target.revDeps.insert(ID);
+    return deps.insert(target.getID());
+  }
+  bool addSoftDependency(Topic &target) {
+    target.revSoftDeps.insert(ID);
+    return softDeps.insert(target.getID());
+  }
+
+  void removeDependency(int TID) { deps.erase(TID); }
+  void removeSoftDependency(int TID) { softDeps.erase(TID); }
+
+  // Removes the dependency to target together with its reverse edge.
+  void removeDependency(Topic &target) {
+    deps.erase(target.getID());
+    target.revDeps.erase(ID);
+  }
+  void removeSoftDependency(Topic &target) {
+    softDeps.erase(target.getID());
+    target.revSoftDeps.erase(ID);
   }
 
   size_t numDependencies() const { return deps.size(); }
   size_t numSoftDependencies() const { return softDeps.size(); }
 
+  // Number of topics that (softly) depend on this topic.
+  size_t numDependents() const { return revDeps.size(); }
+  size_t numSoftDependents() const { return revSoftDeps.size(); }
+
   void dump(std::ostream &out);
 
 private:
   std::string name;
   const int ID;
-  std::vector<int> deps;
-  std::vector<int> softDeps;
+  SmallIDSet deps;
+  SmallIDSet softDeps;
+  SmallIDSet revDeps;
+  SmallIDSet revSoftDeps;
 };
 
 class Module {
@@ -69,9 +108,13 @@ public:
 
   std::string getModuleName() const { return moduleName; }
   int getModuleID() const { return moduleID; }
-  size_t numTopics() const { return topics_list.size(); }
+  size_t numTopics() const {
+    loadTopics();
+    return topics_list.size();
+  }
 
   inline Topic &addTopic(const std::string name, int TID) {
+    loadTopics();
     topics_list.push_back(std::make_unique<Topic>(std::move(name), TID));
     return *topics_list.back();
   }
@@ -85,8 +128,23 @@ public:
   Topic *getTopicByID(int topicID) const;
 
   void removeTopic(const std::string_view topicName);
+  void removeTopic(int topicID);
+
+  // Removes the topic from the module and returns it, including its
+  // dependencies. Returns nullptr if the module has no such topic.
+  std::unique_ptr<Topic> takeTopic(int topicID);
+  // Removes all topics for which takeIf returns true in a single pass, and
+  // returns them in module order.
+  std::vector<std::unique_ptr<Topic>>
+  takeTopics(const std::function<bool(const Topic &)> &takeIf);
+  Topic &addTopic(std::unique_ptr<Topic> topic) {
+    loadTopics();
+    topics_list.push_back(std::move(topic));
+    return *topics_list.back();
+  }
 
   const Topic *findTopic(int TID) {
+    loadTopics();
     auto find = std::find_if(topics_list.begin(), topics_list.end(),
                              [TID](auto &t) { return t->getID() == TID; });
     if (find != topics_list.end()) {
@@ -96,32 +154,100 @@ public:
     return nullptr;
   }
 
-  auto topics_begin() { return topics_list.begin(); }
-  auto topics_end() { return topics_list.end(); }
-  auto topics_begin() const { return topics_list.begin(); }
-  auto topics_end() const { return topics_list.end(); }
+  auto topics_begin() {
+    loadTopics();
+    return topics_list.begin();
+  }
+  auto topics_end() {
+    loadTopics();
+    return topics_list.end();
+  }
+  auto topics_begin() const {
+    loadTopics();
+    return topics_list.begin();
+  }
+  auto topics_end() const {
+    loadTopics();
+    return topics_list.end();
+  }
 
   auto topics() { return make_range(topics_begin(), topics_end()); }
   auto topics() const { return make_range(topics_begin(), topics_end()); }
 
   void dump(std::ostream &out);
 
+  // Sets the function that adds the topics of a lazily loaded module. It is
+  // called once, on the first access to the topics.
+  void setTopicLoader(std::function<void(Module &)> loader) {
+    topicLoader = std::move(loader);
+  }
+  bool areTopicsLoaded() const { return !topicLoader; }
+
 private:
+  void loadTopics() const {
+    if (topicLoader) {
+      auto loader = std::move(topicLoader);
+      topicLoader = nullptr;
+      loader(const_cast<Module &>(*this));
+    }
+  }
+
   const std::string moduleName;
   const int moduleID;
   std::vector<std::unique_ptr<Topic>> topics_list;
+  mutable std::function<void(Module &)> topicLoader;
 };
 
+// A topic, the module it is in, and the module it is moved to.
+struct TopicMove {
+  Module *source;
+  Topic *topic;
+  Module *target;
+};
+
+// Collections are not synchronized. Threads that read a collection while
+// another one modifies it share it through a SnapshotPublisher instead.
 class ModuleCollection {
 public:
   using ModulesStorageTy = std::vector<std::unique_ptr<Module>>;
 
+  // Loads/stores the collection, the file format is selected by the file
+  // extension: .json for JSON, .msgpack/.mpk for MessagePack, and yaml for
+  // everything else. Yaml files are split at module boundaries and the parts
+  // are parsed in parallel. Storing throws std::runtime_error if the file
+  // cannot be written.
   static ModuleCollection loadModulesFromFile(std::filesystem::path filepath);
   static void storeModulesToFile(const ModuleCollection &MC,
                                  std::filesystem::path filepath);
 
+  // Loads a yaml file lazily, i.e., only the names and IDs of the modules are
+  // read up front and the topics of a module are parsed on their first
+  // access. Files in other formats, and yaml files with a layout the fast scan
+  // does not understand, are loaded completely.
+  //
+  // Lazily loaded collections must not be accessed concurrently until
+  // loadAllModules was called.
+  static ModuleCollection
+  loadModulesLazilyFromFile(std::filesystem::path filepath);
+
+  class Builder;
+  class LazyLoader;
+
 public:
-  ModuleCollection() = default;
+  ModuleCollection();
+  ModuleCollection(ModuleCollection &&other) noexcept;
+  ModuleCollection &operator=(ModuleCollection &&other) noexcept;
+  ~ModuleCollection();
+
+  // Parses the topics of all modules that were not accessed yet. Operations
+  // that need the whole collection, e.g., deleting topics or storing the
+  // collection, do this implicitly.
+  void loadAllModules() const;
+  bool isFullyLoaded() const { return !lazyLoader; }
+
+  // Returns a deep copy with the same modules, topics, IDs, and dependencies
+  // in the same order. Loads all modules of lazily loaded collections.
+  ModuleCollection clone() const;
 
   auto modules_begin() { return modules_storage.begin(); }
   auto modules_end() { return modules_storage.end(); }
@@ -144,7 +270,12 @@ public:
   // If found returns the module, otherwise, nullptr.
   Module *getModuleFromTopicID(int topicID) const;
 
-  // Tries to find a module with the specified moduleName.
+  // Tries to find the topic with the specified topicID.
+  // If found returns the topic, otherwise, nullptr.
+  Topic *getTopicFromID(int topicID) const;
+
+  // Tries to find a module with the specified moduleName, or else the first
+  // module whose name starts with moduleName.
   // If found returns the module, otherwise, nullptr.
   Module *getModuleFromName(std::string_view moduleName) const;
 
@@ -153,19 +284,124 @@ public:
   Module *getModuleFromID(int moduleID) const;
 
   Module &addModule(std::string moduleName);
+
+  // Deletes the module and all of its topics. Dependencies of other topics on
+  // the deleted topics are removed as well.
   void deleteModule(int moduleID);
+  // Same, for exactly this module, also if other modules have the same ID.
+  void deleteModule(Module &module);
 
   Topic *addTopicToModule(std::string topicName,
                           const std::string_view moduleName);
   Topic *addTopicToModule(std::string topicName, Module &module);
 
+  // Deletes the topic and removes all dependencies from and to it.
+  void deleteTopic(int topicID);
+  // Same, for exactly this topic of the module, also if other topics have the
+  // same ID.
+  void deleteTopic(Module &module, Topic &topic);
+
+  // Moves the topic into the target module, keeping its ID and all
+  // dependencies from and to it. Returns the topic, or nullptr if there is no
+  // topic with this ID.
+  Topic *moveTopic(int topicID, Module &target);
+  // Same, for exactly this topic of the source module, also if other topics
+  // have the same ID.
+  void moveTopic(Module &source, Topic &topic, Module &target);
+  // Moves many topics at once, given as pairs of topic ID and target module,
+  // like moveTopic. The topic list of every affected module is rebuilt once,
+  // so the moves take linear time in the size of these modules. Moved topics
+  // are appended to their target in collection order.
+  void moveTopics(const std::vector<std::pair<int, Module *>> &moves);
+  // Same, for exactly the given topics.
+  void moveTopics(const std::vector<TopicMove> &moves);
+
+  // Renumbers the modules and topics with consecutive IDs from 1 in collection
+  // order and rewrites all dependencies to the new IDs. Dependencies on
+  // missing topics get the IDs after the topics, so they stay unresolved.
+  // Topics that reuse the ID of an earlier topic get an ID of their own.
+  void compactIDs();
+
 private:
-  int getNextFreeModuleID() const;
-  int getNextFreeTopicID() const;
+  struct TopicLocation {
+    Module *module;
+    Topic *topic;
+  };
+
+  // Removes all incoming and outgoing edges of the topic, using the reverse
+  // edges so only the affected topics are touched.
+  void unlinkTopic(Topic &topic);
+
+  // Hands the IDs of deleted topics, which lost their index entry, to the
+  // first remaining topic with the same ID, or releases them if there is none.
+  void reindexTopicIDs(const std::vector<int> &unindexedIDs);
+
+  // Appends the module to the collection and records it in the module index.
+  Module &appendModule(std::unique_ptr<Module> module);
 
   ModulesStorageTy modules_storage{};
+
+  // Maps module IDs to their module. If a module ID is used more than once,
+  // the first occurrence is recorded.
+  std::unordered_map<int, Module *> moduleIndex{};
+
+  // Maps topic IDs to their topic and its module. If a topic ID is used more
+  // than once, the first occurrence is recorded.
+  std::unordered_map<int, TopicLocation> topicIndex{};
+
+  // Source of the modules that are not loaded yet, reset once all are.
+  mutable std::unique_ptr<LazyLoader> lazyLoader;
+
+  // IDs for new modules and topics. The IDs of lazily loaded topics are known
+  // from the scan of the file.
+  IDAllocator moduleIDs;
+  IDAllocator topicIDs;
+};
+
+// Builds a collection from modules, topics, and dependencies in file order,
+// as read by the loaders. Dependencies can refer to topics that are only
+// added later, so they are linked when the collection is finished.
+class ModuleCollection::Builder {
+public:
+  Module &addModule(std::string moduleName, int moduleID);
+  // Adds a module that was read together with its topics, e.g., on another
+  // thread. Its topics are indexed as if they were added one by one.
+  Module &addModule(std::unique_ptr<Module> module);
+  Topic &addTopic(Module &module, std::string topicName, int topicID);
+  void addDependency(Topic &topic, int depID, DependencyKind kind) {
+    pendingDeps.push_back({&topic, depID, kind});
+  }
+
+  ModuleCollection finish();
+
+private:
+  struct PendingDependency {
+    Topic *topic;
+    int depID;
+    DependencyKind kind;
+  };
+
+  void recordTopicID(int topicID);
+
+  ModuleCollection collection;
+  std::vector<PendingDependency> pendingDeps;
+  // Range of the topic IDs, to decide if they are dense.
+  int minTopicID = std::numeric_limits<int>::max();
+  int maxTopicID = std::numeric_limits<int>::min();
 };
 
+// Parses a yaml file one module at a time, without building a collection, and
+// calls readModule with every module and the part of the file it was read
+// from, in file order. The dependencies of the topics are set but not linked,
+// i.e., there are no dependents and dangling dependencies are kept. Files that
+// cannot be split at module boundaries are parsed as a whole, then the part is
+// empty. If given, parsePart is called before each part, the text of one module
+// or the whole file, is parsed.
+void forEachYAMLModule(
+    std::string_view contents,
+    const std::function<void(const Module &, std::string_view)> &readModule,
+    const std::function<void(std::string_view)> &parsePart = nullptr);
+
 } // namespace sg20
 
 #endif // SG20_GRAPHGEN_MODULES_H
@@ -0,0 +1,143 @@
+#ifndef SG20_GRAPHGEN_OUTPUT_SINK_H
+#define SG20_GRAPHGEN_OUTPUT_SINK_H
+
+#include <charconv>
+#include <cstddef>
+#include <cstring>
+#include <filesystem>
+#include <memory>
+#include <ostream>
+#include <streambuf>
+#include <string_view>
+#include <type_traits>
+
+struct iovec;
+
+namespace sg20 {
+
+// Returns true if the path names the standard output, i.e., it is "-".
+inline bool isStandardOutput(const std::filesystem::path &path) {
+  return path == "-";
+}
+
+// Buffered writer for the generated outputs. Fragments are collected in a
+// large buffer, integers are formatted in place with std::to_chars, and the
+// buffer is written with a single system call once it is full. Fragments that
+// are larger than half of the buffer are written together with the buffer by
+// writev, without copying them.
+class OutputSink {
+public:
+  static constexpr size_t DefaultBufferSize = 1 << 20;
+
+  // Writes to the file, or to the standard output if the path is "-".
+  explicit OutputSink(const std::filesystem::path &path,
+                      size_t bufferSize = DefaultBufferSize);
+  // Writes to the file descriptor, which is left open.
+  explicit OutputSink(int fd, size_t bufferSize = DefaultBufferSize);
+  // Writes to the stream, e.g., a std::ostringstream.
+  explicit OutputSink(std::ostream &stream,
+                      size_t bufferSize = DefaultBufferSize);
+  OutputSink(const OutputSink &) = delete;
+  OutputSink &operator=(const OutputSink &) = delete;
+  ~OutputSink();
+
+  // Returns false if the file could not be opened or a write failed.
+  bool good() const { return !failed; }
+
+  void write(std::string_view str) {
+    if (str.size() <= capacity - used) {
+      std::memcpy(buffer.get() + used, str.data(), str.size());
+      used += str.size();
+      return;
+    }
+    writeSlow(str);
+  }
+
+  void put(char c) {
+    if (used == capacity) {
+      flush();
+    }
+    buffer[used++] = c;
+  }
+
+  template <typename IntTy>
+  std::enable_if_t<std::is_integral_v<IntTy>> writeInt(IntTy value) {
+    // Enough for the digits and the sign of 64 bit integers.
+    if (capacity - used < 24) {
+      flush();
+    }
+    auto result =
+        std::to_chars(buffer.get() + used, buffer.get() + capacity, value);
+    used = result.ptr - buffer.get();
+  }
+
+  OutputSink &operator<<(std::string_view str) {
+    write(str);
+    return *this;
+  }
+  OutputSink &operator<<(char c) {
+    put(c);
+    return *this;
+  }
+  template <typename IntTy,
+            typename = std::enable_if_t<std::is_integral_v<IntTy> &&
+                                        !std::is_same_v<IntTy, char> &&
+                                        !std::is_same_v<IntTy, bool>>>
+  OutputSink &operator<<(IntTy value) {
+    writeInt(value);
+    return *this;
+  }
+
+  // Writes the buffered output.
+  void flush();
+  // Writes the buffered output and throws std::runtime_error if the output,
+  // which was opened from path, could not be written.
+  void finish(const std::filesystem::path &path);
+
+private:
+  void writeSlow(std::string_view str);
+  void writeVectors(struct iovec *vectors, int count);
+
+  int fd = -1;
+  bool ownsFD = false;
+  std::ostream *stream = nullptr;
+  std::unique_ptr<char[]> buffer;
+  size_t capacity;
+  size_t used = 0;
+  bool failed = false;
+};
+
+// std::ostream that writes into an OutputSink, for writers that only support
+// streams, e.g., yaml-cpp and the HTML builder.
+class OutputSinkStream : public std::ostream {
+public:
+  explicit OutputSinkStream(OutputSink &sink)
+      : std::ostream(&sinkBuffer), sinkBuffer(sink) {}
+
+private:
+  class SinkBuffer : public std::streambuf {
+  public:
+    explicit SinkBuffer(OutputSink &sink) : sink(sink) {}
+
+  protected:
+    int_type overflow(int_type c) override {
+      if (!traits_type::eq_int_type(c, traits_type::eof())) {
+        sink.put(traits_type::to_char_type(c));
+      }
+      return traits_type::not_eof(c);
+    }
+    std::streamsize xsputn(const char *str, std::streamsize count) override {
+      sink.write(std::string_view(str, count));
+      return count;
+    }
+
+  private:
+    OutputSink &sink;
+  };
+
+  SinkBuffer sinkBuffer;
+};
+
+} // namespace sg20
+
+#endif // SG20_GRAPHGEN_OUTPUT_SINK_H
@@ -0,0 +1,74 @@
+#ifndef SG20_GRAPHGEN_PARTITION_H
+#define SG20_GRAPHGEN_PARTITION_H
+
+#include "sg20_graphgen/modules.h"
+
+#include <cstdint>
+#include <optional>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace sg20 {
+
+struct PartitionOptions {
+  // Number of modules to propose, 0 to keep the number of modules.
+  int numParts = 0;
+  // Allowed excess of the largest module over the average topic count, e.g.,
+  // 0.05 for 5%.
+  double imbalance = 0.05;
+  // Start from the current modules if the number of modules is kept, so only
+  // topics that reduce the cut or the imbalance are moved. Otherwise, the
+  // modules are partitioned from scratch.
+  bool keepModules = true;
+  // Maximum number of refinement passes per level.
+  int refinementPasses = 8;
+};
+
+// Proposed assignment of topics to modules.
+struct PartitionProposal {
+  struct Part {
+    // ID of the existing module the part is assigned to, or std::nullopt if a
+    // new module has to be created.
+    std::optional<int> moduleID;
+    std::string moduleName;
+    int numTopics = 0;
+  };
+  std::vector<Part> parts;
+
+  struct TopicAssignment {
+    int topicID;
+    int moduleID;
+    int part;
+  };
+  // All topics in collection order. Topics whose ID is used more than once are
+  // only listed for their first occurrence.
+  std::vector<TopicAssignment> topics;
+
+  // Number of hard dependencies between topics of different modules.
+  int64_t cutBefore = 0;
+  int64_t cutAfter = 0;
+};
+
+// Partitions the hard dependency graph into modules with balanced topic counts
+// and few dependencies between them. The graph is coarsened by heavy edge
+// matching, partitioned on the coarsest level, and refined with k-way
+// Fiduccia-Mattheyses passes on every level while it is projected back.
+// Parts are assigned to the existing modules they overlap most with.
+PartitionProposal computePartition(const ModuleCollection &moduleCollection,
+                                   const PartitionOptions &options);
+
+// Writes the yamlEditor commands that apply the proposal, with all moves in a
+// single moveTopics command, followed by the commands to quit and save.
+void writePartitionScript(const PartitionProposal &proposal,
+                          std::ostream &out);
+
+// Moves the topics of the collection as proposed, in a single
+// ModuleCollection::moveTopics. Modules that are left without topics are
+// kept.
+void applyPartition(ModuleCollection &moduleCollection,
+                    const PartitionProposal &proposal);
+
+} // namespace sg20
+
+#endif // SG20_GRAPHGEN_PARTITION_H
@@ -0,0 +1,75 @@
+#ifndef SG20_GRAPHGEN_QUERY_SERVER_H
+#define SG20_GRAPHGEN_QUERY_SERVER_H
+
+#include "sg20_graphgen/modules.h"
+#include "sg20_graphgen/snapshot.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_set>
+
+namespace sg20 {
+
+// Serves the yamlEditor commands for a loaded collection over a Unix domain
+// socket, so clients do not have to load the collection for every query.
+//
+// A request is a single line with one command and its arguments, e.g.,
+// "listTopics 3" or "render 3 html". Additionally, "save" stores the
+// collection into the output file. Every reply starts with a header line
+// "OK <size>" or "ERROR <size>", followed by <size> bytes of command output.
+//
+// Read only commands run on the current snapshot of the collection, so queries
+// run concurrently and never wait for commands that modify the collection.
+// Those are serialized, applied to the working copy of the collection, and
+// published as a new snapshot once they are done.
+class QueryServer {
+public:
+  struct Reply {
+    bool failed = false;
+    bool closeConnection = false;
+    std::string text;
+  };
+
+  QueryServer(ModuleCollection moduleCollection,
+              std::filesystem::path socketPath,
+              std::filesystem::path outputPath);
+
+  // Binds the socket and serves clients, one thread per connection, until
+  // stop() is called. Throws std::system_error if the socket cannot be set up.
+  void run();
+
+  // Stops accepting clients and closes all open connections. Safe to call
+  // from any thread.
+  void stop();
+
+  // Runs a single request line against the collection.
+  Reply handleRequest(std::string_view request);
+
+private:
+  void serveClient(int clientFD);
+
+  SnapshotPublisher collection;
+  const std::filesystem::path socketPath;
+  const std::filesystem::path outputPath;
+
+  // Concurrent saves do not write the file at the same time.
+  std::mutex saveMutex;
+
+  std::atomic<bool> stopped{false};
+  std::atomic<int> listenFD{-1};
+
+  // Connections are served by detached threads, run() waits until all of them
+  // are finished.
+  std::mutex clientsMutex;
+  std::condition_variable clientsDone;
+  std::unordered_set<int> clientFDs;
+};
+
+} // namespace sg20
+
+#endif // SG20_GRAPHGEN_QUERY_SERVER_H
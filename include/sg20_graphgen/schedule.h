@@ -0,0 +1,59 @@
+#ifndef SG20_GRAPHGEN_SCHEDULE_H
+#define SG20_GRAPHGEN_SCHEDULE_H
+
+#include "sg20_graphgen/modules.h"
+#include "sg20_graphgen/output_sink.h"
+
+#include <vector>
+
+namespace sg20 {
+
+struct ScheduleOptions {
+  // Number of topics that can be taught in parallel in every slot.
+  int tracks = 1;
+  // Maximum number of topics of one module per slot, 0 for no limit.
+  int moduleCapacity = 0;
+};
+
+// Plan for teaching the topics of a collection in slots of equal length,
+// where every topic is taught after all of its hard dependencies. Soft
+// dependencies are ignored, cycles are broken at the topic that comes first in
+// the collection.
+struct Schedule {
+  struct TopicSlot {
+    const Module *module;
+    const Topic *topic;
+    // Earliest and latest slot that keep the critical path length with an
+    // unlimited number of tracks.
+    int earliest;
+    int latest;
+    // Slot and track in the schedule onto a limited number of tracks.
+    int slot;
+    int track;
+  };
+  // All topics in collection order.
+  std::vector<TopicSlot> topics;
+
+  // Number of slots of the longest dependency chain, and one such chain.
+  int criticalPathLength = 0;
+  std::vector<const Topic *> criticalPath;
+
+  // Number of slots of the schedule onto the tracks.
+  int numSlots = 0;
+  int numTracks = 0;
+};
+
+// Computes the earliest and latest slots with the critical path method and
+// list schedules the topics onto the tracks. Among the ready topics, the ones
+// with the earliest latest slot are scheduled first. Runs in
+// O((T + E) log T) for T topics and E dependencies.
+Schedule computeSchedule(const ModuleCollection &moduleCollection,
+                         const ScheduleOptions &options);
+
+// Writes one line per topic with its module, name, ID, earliest and latest
+// slot, and scheduled slot and track.
+void writeScheduleCSV(const Schedule &schedule, OutputSink &out);
+
+} // namespace sg20
+
+#endif // SG20_GRAPHGEN_SCHEDULE_H
@@ -0,0 +1,73 @@
+#ifndef SG20_GRAPHGEN_SEARCHINDEX_H
+#define SG20_GRAPHGEN_SEARCHINDEX_H
+
+#include "sg20_graphgen/modules.h"
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace sg20 {
+
+// Case insensitive search index over the names of all modules and topics of a
+// collection. The index is a snapshot, it has to be rebuilt after the
+// collection was modified.
+class SearchIndex {
+public:
+  struct Match {
+    std::string moduleName;
+    int moduleID;
+    // Set if the match is a topic, otherwise, the module itself matched.
+    std::optional<std::string> topicName;
+    std::optional<int> topicID;
+    // Edit distance between the query and the name, 0 for prefix matches.
+    unsigned distance;
+  };
+
+  explicit SearchIndex(const ModuleCollection &moduleCollection);
+
+  // Returns up to maxResults names that start with the query, or are within a
+  // small edit distance of it. Exact matches come first, followed by prefix
+  // matches in alphabetical order and typo-tolerant matches by edit distance.
+  std::vector<Match> find(std::string_view query, size_t maxResults = 10) const;
+
+  size_t size() const { return entries.size(); }
+
+private:
+  struct Entry {
+    std::string key; // lower case name
+    std::string moduleName;
+    int moduleID;
+    std::optional<std::string> topicName;
+    std::optional<int> topicID;
+  };
+
+  Match makeMatch(uint32_t entry, unsigned distance) const;
+
+  std::vector<Entry> entries;
+  // Entry indices sorted by key for prefix queries.
+  std::vector<uint32_t> sortedEntries;
+  // Entries containing each trigram of their padded key.
+  std::unordered_map<uint32_t, std::vector<uint32_t>> trigramEntries;
+};
+
+// Search index that is built on first use and rebuilt after the collection
+// was modified. Concurrent callers of get must not modify the collection.
+class LazySearchIndex {
+public:
+  const SearchIndex &get(const ModuleCollection &moduleCollection);
+  void invalidate();
+
+private:
+  std::mutex indexMutex;
+  std::unique_ptr<SearchIndex> index;
+};
+
+} // namespace sg20
+
+#endif // SG20_GRAPHGEN_SEARCHINDEX_H
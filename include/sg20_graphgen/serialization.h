@@ -0,0 +1,45 @@
+#ifndef SG20_GRAPHGEN_SERIALIZATION_H
+#define SG20_GRAPHGEN_SERIALIZATION_H
+
+#include "sg20_graphgen/modules.h"
+
+#include <filesystem>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+namespace sg20 {
+
+// Thrown by the JSON and MessagePack loaders for malformed input.
+class ParseError : public std::runtime_error {
+public:
+  using std::runtime_error::runtime_error;
+};
+
+std::string readFileContents(const std::filesystem::path &filepath);
+
+// Streaming loaders for the JSON and MessagePack encodings of the yaml schema
+// (Modules/name/mid/sub/name/tid/dep/softdep). Both parse the input in a single
+// pass and directly build the collection, no document tree is created.
+// Unknown keys are skipped.
+ModuleCollection loadModulesFromJSON(std::string_view input);
+ModuleCollection loadModulesFromMsgPack(std::string_view input);
+
+enum class YAMLSplitting {
+  // Split if there is more than one hardware thread.
+  Auto,
+  Always,
+  Never,
+};
+
+// Loads the yaml encoding. Unless splitting is disabled, the input is split
+// at module boundaries and the parts are parsed in parallel; inputs that
+// cannot be split are parsed as a whole, so the result does not depend on
+// splitting. Throws ParseError or YAML::Exception for malformed input.
+ModuleCollection
+loadModulesFromYAML(std::string_view input,
+                    YAMLSplitting splitting = YAMLSplitting::Auto);
+
+} // namespace sg20
+
+#endif // SG20_GRAPHGEN_SERIALIZATION_H
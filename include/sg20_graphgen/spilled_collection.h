@@ -0,0 +1,158 @@
+#ifndef SG20_GRAPHGEN_SPILLEDCOLLECTION_H
+#define SG20_GRAPHGEN_SPILLEDCOLLECTION_H
+
+#include "sg20_graphgen/layout.h"
+#include "sg20_graphgen/modules.h"
+#include "sg20_graphgen/util.h"
+#include "sg20_graphgen/validator.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace sg20 {
+
+// Read-only memory mapping of a whole file.
+class MappedFile {
+public:
+  MappedFile() = default;
+  // Throws std::runtime_error if the file cannot be mapped.
+  explicit MappedFile(const std::filesystem::path &path);
+  MappedFile(MappedFile &&other) noexcept;
+  MappedFile &operator=(MappedFile &&other) noexcept;
+  ~MappedFile();
+
+  std::string_view contents() const { return {data, size}; }
+
+  // Drops the pages of the range from the memory of the process. They are
+  // read from the file again when they are accessed the next time.
+  void release(size_t offset, size_t length) const;
+
+private:
+  char *data = nullptr;
+  size_t size = 0;
+};
+
+struct SpillOptions {
+  // Budget for the memory of the process in bytes, 0 for no limit.
+  size_t memoryLimit = 0;
+  // Directory for the files of the store, they are deleted as soon as they are
+  // mapped.
+  std::filesystem::path directory = std::filesystem::temp_directory_path();
+};
+
+// Read-only collection for files that are too large to be held as
+// ModuleCollection. The names of the modules and topics and the dependencies
+// of the topics are kept in temporary memory-mapped files, only the modules
+// and an index of the topic IDs are held in memory. Modules and topics are
+// numbered densely in file order.
+//
+// Readers are expected to walk the collection module by module and to release
+// every module they are done with, so the resident part of the mapped files
+// stays small.
+class SpilledCollection {
+public:
+  // Reads the yaml file one module at a time into the store. Throws
+  // std::runtime_error if the store cannot be written, or as soon as the
+  // memory the index and the layout of the graph need, plus the memory for
+  // parsing the next module, exceeds the memory limit.
+  static SpilledCollection loadFromYAMLFile(const std::filesystem::path &path,
+                                            const SpillOptions &options = {});
+
+  size_t numModules() const { return modules.size(); }
+  size_t numTopics() const { return numTopicRecords; }
+
+  int getModuleID(size_t module) const { return modules[module].ID; }
+  std::string_view getModuleName(size_t module) const {
+    return getName(modules[module].nameOffset, modules[module].nameLength);
+  }
+  // Topics of the module are numbered from getFirstTopic on.
+  size_t getFirstTopic(size_t module) const {
+    return modules[module].firstTopic;
+  }
+  size_t getNumTopics(size_t module) const { return modules[module].numTopics; }
+
+  int getTopicID(size_t topic) const { return getTopicRecord(topic).ID; }
+  std::string_view getTopicName(size_t topic) const {
+    const TopicRecord &record = getTopicRecord(topic);
+    return getName(record.nameOffset, record.nameLength);
+  }
+  // Dependencies of the topic by ID, sorted and including dangling ones.
+  auto dependencies(size_t topic) const {
+    const TopicRecord &record = getTopicRecord(topic);
+    const int32_t *begin = getDeps() + record.depOffset;
+    return make_range(begin, begin + record.numDeps);
+  }
+  auto softDependencies(size_t topic) const {
+    const TopicRecord &record = getTopicRecord(topic);
+    const int32_t *begin = getDeps() + record.depOffset + record.numDeps;
+    return make_range(begin, begin + record.numSoftDeps);
+  }
+
+  size_t getModuleOfTopic(size_t topic) const;
+
+  // Returns the first topic with the ID, or std::nullopt if there is none.
+  std::optional<size_t> findTopic(int topicID) const;
+
+  // Drops the mapped names, topics, and dependencies of the module from
+  // memory, they are read again if the module is accessed later.
+  void releaseModule(size_t module) const;
+
+  // Builds the graph for rankLayoutGraph, with the same numbering and edges
+  // as computeLayoutOrder uses for a ModuleCollection of the same file.
+  LayoutGraph buildLayoutGraph() const;
+
+  // Same as validateModuleCollection on a ModuleCollection of the same file.
+  std::vector<ValidationIssue> validate() const;
+
+private:
+  struct ModuleRecord {
+    int ID;
+    uint32_t nameLength;
+    uint64_t nameOffset;
+    size_t firstTopic;
+    size_t numTopics;
+  };
+
+  // Layout of the topic records in the mapped topic file.
+  struct TopicRecord {
+    int32_t ID;
+    uint32_t nameLength;
+    uint64_t nameOffset;
+    // Index of the first hard dependency in the dependency file, the soft
+    // dependencies follow the hard ones.
+    uint64_t depOffset;
+    uint32_t numDeps;
+    uint32_t numSoftDeps;
+  };
+
+  SpilledCollection() = default;
+
+  const TopicRecord &getTopicRecord(size_t topic) const {
+    return reinterpret_cast<const TopicRecord *>(
+        topicFile.contents().data())[topic];
+  }
+  const int32_t *getDeps() const {
+    return reinterpret_cast<const int32_t *>(depFile.contents().data());
+  }
+  std::string_view getName(uint64_t offset, uint32_t length) const {
+    return nameFile.contents().substr(offset, length);
+  }
+
+  std::vector<ModuleRecord> modules;
+  size_t numTopicRecords = 0;
+  size_t numDepRecords = 0;
+  // Pairs of a topic ID and the first topic with it, sorted by ID.
+  std::vector<std::pair<int, uint32_t>> topicIndex;
+  MappedFile topicFile;
+  MappedFile depFile;
+  MappedFile nameFile;
+};
+
+} // namespace sg20
+
+#endif // SG20_GRAPHGEN_SPILLEDCOLLECTION_H
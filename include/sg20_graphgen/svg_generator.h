@@ -0,0 +1,23 @@
+#ifndef SG20_GRAPHGEN_SVGGENERATOR_H
+#define SG20_GRAPHGEN_SVGGENERATOR_H
+
+#include "sg20_graphgen/layout.h"
+#include "sg20_graphgen/modules.h"
+#include "sg20_graphgen/output_sink.h"
+
+namespace sg20 {
+
+// Writes the drawing of the layout as SVG, with one cluster per module, one
+// node per topic, and one arrow per dependency. Soft dependencies are dashed.
+// The markup of the modules is generated in parallel.
+void writeSVGGraph(const LayoutOrder &order, const GraphLayout &layout,
+                   OutputSink &out);
+
+// Lays out the module collection with the native layout engine and writes it
+// as SVG, without going through graphviz.
+void writeSVGGraph(const ModuleCollection &moduleCollection,
+                   OutputSink &out);
+
+} // namespace sg20
+
+#endif // SG20_GRAPHGEN_SVGGENERATOR_H
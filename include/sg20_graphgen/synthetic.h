@@ -0,0 +1,31 @@
+#ifndef SG20_GRAPHGEN_SYNTHETIC_H
+#define SG20_GRAPHGEN_SYNTHETIC_H
+
+#include "sg20_graphgen/modules.h"
+
+#include <cstdint>
+
+namespace sg20 {
+
+struct SyntheticCollectionOptions {
+  int numModules = 100;
+  int topicsPerModule = 100;
+  // Average number of hard and soft dependencies per topic.
+  double dependencies = 1.5;
+  double softDependencies = 0.3;
+  // Share of the dependencies on topics of earlier modules, the others are
+  // on nearby earlier topics of the same module.
+  double crossModuleShare = 0.2;
+  uint64_t seed = 1;
+};
+
+// Generates a random collection shaped like a curriculum, for benchmarks and
+// tests: topics only depend on earlier topics, so the hard dependencies are
+// acyclic. Module IDs start at 1 and topic IDs at 0, both in order. The same
+// options always generate the same collection.
+ModuleCollection
+generateSyntheticCollection(const SyntheticCollectionOptions &options);
+
+} // namespace sg20
+
+#endif // SG20_GRAPHGEN_SYNTHETIC_H
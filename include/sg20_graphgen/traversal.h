@@ -0,0 +1,75 @@
+#ifndef SG20_GRAPHGEN_TRAVERSAL_H
+#define SG20_GRAPHGEN_TRAVERSAL_H
+
+#include "sg20_graphgen/modules.h"
+
+namespace sg20 {
+
+// Default (empty) implementations of all traversal callbacks. Emitter policies
+// derive from this class and hide the callbacks they are interested in. All
+// calls are resolved statically, so there is no virtual dispatch involved.
+class EmitterPolicyBase {
+public:
+  void beginCollection(const ModuleCollection &) {}
+  void endCollection(const ModuleCollection &) {}
+  void beginModule(const Module &) {}
+  void endModule(const Module &) {}
+  void beginTopic(const Module &, const Topic &) {}
+  void endTopic(const Module &, const Topic &) {}
+  void emitDependency(const Module &, const Topic &, int, DependencyKind) {}
+};
+
+namespace detail {
+
+template <typename... EmitterTys>
+void traverseTopic(const Module &module, const Topic &topic,
+                   EmitterTys &...emitters) {
+  (emitters.beginTopic(module, topic), ...);
+  for (auto dep : topic.dependencies()) {
+    (emitters.emitDependency(module, topic, dep, DependencyKind::Hard), ...);
+  }
+  for (auto dep : topic.softDependencies()) {
+    (emitters.emitDependency(module, topic, dep, DependencyKind::Soft), ...);
+  }
+  (emitters.endTopic(module, topic), ...);
+}
+
+template <typename... EmitterTys>
+void traverseModule(const Module &module, EmitterTys &...emitters) {
+  (emitters.beginModule(module), ...);
+  for (auto &topic : module.topics()) {
+    traverseTopic(module, *topic, emitters...);
+  }
+  (emitters.endModule(module), ...);
+}
+
+} // namespace detail
+
+// Walks over all modules, topics, and dependencies of the collection once and
+// forwards every element to all emitters, in order. This allows producing
+// multiple outputs with a single pass over the model.
+//
+// Per topic, all hard dependencies are visited before the soft ones.
+template <typename... EmitterTys>
+void traverseModuleCollection(const ModuleCollection &moduleCollection,
+                              EmitterTys &...emitters) {
+  (emitters.beginCollection(moduleCollection), ...);
+  for (auto &module : moduleCollection.modules()) {
+    detail::traverseModule(*module, emitters...);
+  }
+  (emitters.endCollection(moduleCollection), ...);
+}
+
+// Same as traverseModuleCollection but only visits a single module of the
+// collection. Dependencies on topics of other modules are still forwarded.
+template <typename... EmitterTys>
+void traverseModule(const ModuleCollection &moduleCollection,
+                    const Module &module, EmitterTys &...emitters) {
+  (emitters.beginCollection(moduleCollection), ...);
+  detail::traverseModule(module, emitters...);
+  (emitters.endCollection(moduleCollection), ...);
+}
+
+} // namespace sg20
+
+#endif // SG20_GRAPHGEN_TRAVERSAL_H
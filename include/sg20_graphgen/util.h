@@ -5,8 +5,15 @@
 #include "yaml-cpp/emittermanip.h"
 #include "yaml-cpp/yaml.h"
 
+#include "absl/container/inlined_vector.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
 #include <iterator>
+#include <thread>
 #include <type_traits>
+#include <vector>
 
 namespace sg20 {
 
@@ -28,6 +35,101 @@ auto make_range(IteratorType begin, IteratorType end) {
   return util_range<IteratorType>(std::move(begin), std::move(end));
 }
 
+// Sorted set of IDs that stores the first few elements inline, so small sets
+// do not need a heap allocation. Lookups are O(log n), inserts and erases
+// additionally shift the elements behind the position.
+class SmallIDSet {
+public:
+  using StorageTy = absl::InlinedVector<int, 4>;
+
+  auto begin() const { return IDs.begin(); }
+  auto end() const { return IDs.end(); }
+
+  size_t size() const { return IDs.size(); }
+  bool empty() const { return IDs.empty(); }
+
+  bool contains(int ID) const {
+    return std::binary_search(IDs.begin(), IDs.end(), ID);
+  }
+
+  // Returns true if the ID was not yet part of the set.
+  bool insert(int ID) {
+    auto pos = std::lower_bound(IDs.begin(), IDs.end(), ID);
+    if (pos != IDs.end() && *pos == ID) {
+      return false;
+    }
+    IDs.insert(pos, ID);
+    return true;
+  }
+
+  // Returns true if the ID was part of the set.
+  bool erase(int ID) {
+    auto pos = std::lower_bound(IDs.begin(), IDs.end(), ID);
+    if (pos == IDs.end() || *pos != ID) {
+      return false;
+    }
+    IDs.erase(pos);
+    return true;
+  }
+
+private:
+  StorageTy IDs;
+};
+
+// Allocates the IDs of new modules or topics in O(1). IDs that were released
+// by deletes are handed out again first, so IDs stay dense, otherwise the ID
+// after the highest one seen so far.
+class IDAllocator {
+public:
+  // Records an ID that is in use, e.g., one read from a file.
+  void reserve(int ID) { maxID = std::max(maxID, ID); }
+
+  // Makes the ID of a deleted module or topic available again.
+  void release(int ID) { freeIDs.push_back(ID); }
+
+  int allocate() {
+    if (!freeIDs.empty()) {
+      int ID = freeIDs.back();
+      freeIDs.pop_back();
+      return ID;
+    }
+    return ++maxID;
+  }
+
+private:
+  int maxID = 0;
+  std::vector<int> freeIDs;
+};
+
+// Calls fn(i) for every i in [0, n), distributed over all hardware threads.
+// The calls must be independent of each other.
+template <typename FnTy> void parallelFor(size_t n, FnTy fn) {
+  size_t numThreads =
+      std::min<size_t>(n, std::max(1u, std::thread::hardware_concurrency()));
+  if (numThreads <= 1) {
+    for (size_t i = 0; i < n; ++i) {
+      fn(i);
+    }
+    return;
+  }
+
+  std::atomic<size_t> next{0};
+  auto worker = [&next, &fn, n]() {
+    for (size_t i = next++; i < n; i = next++) {
+      fn(i);
+    }
+  };
+  std::vector<std::thread> threads;
+  threads.reserve(numThreads - 1);
+  for (size_t thread = 1; thread < numThreads; ++thread) {
+    threads.emplace_back(worker);
+  }
+  worker();
+  for (auto &thread : threads) {
+    thread.join();
+  }
+}
+
 class YAMLMap {
 public:
   YAMLMap(YAML::Emitter &emitter) : outputEmitter(emitter) {
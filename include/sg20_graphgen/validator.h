@@ -0,0 +1,44 @@
+#ifndef SG20_GRAPHGEN_VALIDATOR_H
+#define SG20_GRAPHGEN_VALIDATOR_H
+
+#include "sg20_graphgen/modules.h"
+
+#include <ostream>
+#include <vector>
+
+namespace sg20 {
+
+struct ValidationIssue {
+  enum class Kind {
+    DanglingDependency,  // dependency on a topic ID that does not exist
+    DuplicateModuleID,   // module ID used by more than one module
+    DuplicateTopicID,    // topic ID used by more than one topic
+    SelfLoop,            // topic depends on itself
+  };
+
+  Kind kind;
+  int moduleID;
+  int topicID = -1;
+  int targetID = -1;   // only set for dependency related issues
+  bool isSoft = false; // dependency related issue concerns a soft dependency
+  bool repaired = false;
+
+  void dump(std::ostream &out) const;
+};
+
+// Checks the referential integrity of the collection, i.e., that every
+// dependency refers to an existing topic and that IDs are unique. Runs in a
+// single linear sweep over all modules, topics, and dependencies.
+std::vector<ValidationIssue>
+validateModuleCollection(const ModuleCollection &moduleCollection);
+
+// Same as validateModuleCollection but additionally repairs all dependency
+// related issues by removing dangling dependencies and self loops. Duplicate
+// IDs are only reported, as there is no way to tell which topic or module the
+// user meant.
+std::vector<ValidationIssue>
+repairModuleCollection(ModuleCollection &moduleCollection);
+
+} // namespace sg20
+
+#endif // SG20_GRAPHGEN_VALIDATOR_H
@@ -1,5 +1,8 @@
+#include "sg20_graphgen/html_explorer.h"
 #include "sg20_graphgen/html_generator.h"
 #include "sg20_graphgen/modules.h"
+#include "sg20_graphgen/output_sink.h"
+#include "sg20_graphgen/serialization.h"
 
 #include "yaml-cpp/exceptions.h"
 
@@ -9,13 +12,22 @@
 #include "absl/strings/str_cat.h"
 
 #include <filesystem>
-#include <fstream>
 #include <iostream>
+#include <stdexcept>
 
 ABSL_FLAG(std::string, graph_yaml, "sg20_graph.yaml",
           "path to the yaml specification file.");
 ABSL_FLAG(std::string, output, "sg20_modules.html",
           "filename for the generated dot file.");
+ABSL_FLAG(int, pages, 0,
+          "Split the table into this many pages, which are written next to "
+          "the output file. The output file becomes an index of the pages.");
+ABSL_FLAG(bool, splitByLetter, false,
+          "Split the table into one page per first letter of the module "
+          "names, like --pages.");
+ABSL_FLAG(bool, explorer, false,
+          "Generate an interactive page to search the topics and highlight "
+          "their prerequisites instead of the table.");
 
 int main(int argc, char *argv[]) {
   absl::SetProgramUsageMessage(
@@ -33,11 +45,35 @@ int main(int argc, char *argv[]) {
   try {
     auto MC = sg20::ModuleCollection::loadModulesFromFile(yamlInputFile);
 
-    std::ofstream outputFile(absl::GetFlag(FLAGS_output));
-    outputFile << sg20::generateHTMLTable(MC);
+    std::filesystem::path outputFilename(absl::GetFlag(FLAGS_output));
+    if (absl::GetFlag(FLAGS_explorer)) {
+      sg20::OutputSink outputFile(outputFilename);
+      sg20::writeHTMLExplorer(MC, outputFile);
+      outputFile.finish(outputFilename);
+    } else if (absl::GetFlag(FLAGS_splitByLetter)) {
+      sg20::emitSplitHTMLTables(
+          MC, sg20::splitModulesByLetter(MC, outputFilename), outputFilename);
+    } else if (absl::GetFlag(FLAGS_pages) > 0) {
+      sg20::emitSplitHTMLTables(
+          MC,
+          sg20::splitModulesIntoPages(MC, absl::GetFlag(FLAGS_pages),
+                                      outputFilename),
+          outputFilename);
+    } else {
+      sg20::OutputSink outputFile(outputFilename);
+      sg20::OutputSinkStream outputStream(outputFile);
+      outputStream << sg20::generateHTMLTable(MC);
+      outputFile.finish(outputFilename);
+    }
   } catch (YAML::Exception &e) {
     std::cerr << "Syntax error in YAML " << yamlInputFile << std::endl;
     std::cerr << "Got: " << e.what() << std::endl;
+  } catch (sg20::ParseError &e) {
+    std::cerr << "Syntax error in " << yamlInputFile << std::endl;
+    std::cerr << "Got: " << e.what() << std::endl;
+  } catch (std::runtime_error &e) {
+    std::cerr << "Error: " << e.what() << std::endl;
+    return 1;
   }
 
   return 0;
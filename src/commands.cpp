@@ -0,0 +1,970 @@
+#include "sg20_graphgen/commands.h"
+#include "sg20_graphgen/emitters.h"
+#include "sg20_graphgen/html_generator.h"
+#include "sg20_graphgen/traversal.h"
+#include "sg20_graphgen/validator.h"
+
+#include "absl/strings/ascii.h"
+#include "absl/strings/match.h"
+#include "absl/strings/str_split.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cctype>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace sg20 {
+
+namespace {
+
+bool isNumber(const std::string_view str) {
+  return !str.empty() && std::find_if(str.begin(), str.end(), [](char c) {
+                           return !std::isdigit(static_cast<unsigned char>(c));
+                         }) == str.end();
+}
+
+// Looks up the module by ID if the reference is a number, otherwise by name.
+// IDs that do not fit into an int are not found.
+Module *findModule(const ModuleCollection &MC, std::string_view moduleRef) {
+  if (!isNumber(moduleRef)) {
+    return MC.getModuleFromName(moduleRef);
+  }
+  int moduleID;
+  auto [end, ec] = std::from_chars(
+      moduleRef.data(), moduleRef.data() + moduleRef.size(), moduleID);
+  return ec == std::errc() ? MC.getModuleFromID(moduleID) : nullptr;
+}
+
+Topic *findTopic(const ModuleCollection &MC, const Module &module,
+                 std::string_view topicRef) {
+  if (!isNumber(topicRef)) {
+    return module.getTopicByName(topicRef);
+  }
+  int topicID;
+  auto [end, ec] = std::from_chars(
+      topicRef.data(), topicRef.data() + topicRef.size(), topicID);
+  if (ec != std::errc()) {
+    return nullptr;
+  }
+  // The topic index finds the topic without scanning the module, unless the
+  // ID is used more than once and the module has a later occurrence.
+  if (MC.getModuleFromTopicID(topicID) == &module) {
+    return MC.getTopicFromID(topicID);
+  }
+  return module.getTopicByID(topicID);
+}
+
+// Finds the last arrow, " -> " or also " ~> " if soft arrows are allowed,
+// that starts before end. Returns std::string_view::npos if there is none.
+size_t findLastArrow(std::string_view input, size_t end, bool allowSoft) {
+  if (end < 4) {
+    return std::string_view::npos;
+  }
+  size_t arrow = input.substr(0, end).rfind(" -> ");
+  if (allowSoft) {
+    size_t softArrow = input.substr(0, end).rfind(" ~> ");
+    if (softArrow != std::string_view::npos &&
+        (arrow == std::string_view::npos || softArrow > arrow)) {
+      arrow = softArrow;
+    }
+  }
+  return arrow;
+}
+
+// Parts of a dependency input, MODULE:TOPIC -> MODULE:TOPIC. The input is
+// split like the greedy regex (.*):(.*) (->|~>) (.*):(.*), i.e., at the last
+// arrow that is followed by a colon and at the last colon on either side of
+// it. The input is split by hand because std::regex recurses for every
+// character and overflows the stack on long lines.
+struct DependencyInput {
+  std::string_view sourceModule;
+  std::string_view sourceTopic;
+  std::string_view arrow;
+  std::string_view targetModule;
+  std::string_view targetTopic;
+};
+
+std::optional<DependencyInput> splitDependencyInput(std::string_view input) {
+  size_t targetColon = input.rfind(':');
+  if (targetColon == std::string_view::npos) {
+    return std::nullopt;
+  }
+  size_t arrow = findLastArrow(input, targetColon, /*allowSoft=*/true);
+  if (arrow == std::string_view::npos || arrow == 0) {
+    return std::nullopt;
+  }
+  size_t sourceColon = input.rfind(':', arrow - 1);
+  if (sourceColon == std::string_view::npos) {
+    return std::nullopt;
+  }
+  return DependencyInput{
+      input.substr(0, sourceColon),
+      input.substr(sourceColon + 1, arrow - sourceColon - 1),
+      input.substr(arrow + 1, 2),
+      input.substr(arrow + 4, targetColon - arrow - 4),
+      input.substr(targetColon + 1),
+  };
+}
+
+struct ModuleTopicTuple : std::pair<Module *, Topic *> {
+  ModuleTopicTuple(Module *module, Topic *topic)
+      : std::pair<Module *, Topic *>(module, topic) {}
+  Module *getModule() { return first; }
+  Module *getModule() const { return first; }
+  Topic *getTopic() { return second; }
+  Topic *getTopic() const { return second; }
+  bool isValid() const { return getModule() && getTopic(); }
+};
+
+struct SourceTargetDependency : std::pair<ModuleTopicTuple, ModuleTopicTuple> {
+  SourceTargetDependency(ModuleTopicTuple source, ModuleTopicTuple target,
+                         std::string depSpecifier)
+      : std::pair<ModuleTopicTuple, ModuleTopicTuple>(source, target),
+        depSpecifier(std::move(depSpecifier)) {}
+  ModuleTopicTuple getSource() { return first; }
+  ModuleTopicTuple getSource() const { return first; }
+  ModuleTopicTuple getTarget() { return second; }
+  ModuleTopicTuple getTarget() const { return second; }
+  bool isValid() const {
+    return getSource().isValid() && getTarget().isValid();
+  }
+  std::string_view getDependencyTypeSpecifier() const { return depSpecifier; }
+
+private:
+  std::string depSpecifier;
+};
+
+// Runs the commands that only read the collection, see isReadOnlyCommand.
+// Command arguments are read from in, results are printed to out and error
+// messages to err.
+class ReadOnlyCommandHandler {
+public:
+  ReadOnlyCommandHandler(const ModuleCollection &MC, std::istream &in,
+                         std::ostream &out, std::ostream &err)
+      : MC(MC), in(in), out(out), err(err) {}
+
+  void handleListModules();
+  void handleListTopics();
+  void handleListDependencies();
+  void handleListRevDependencies();
+  void handleRenderModule();
+  void handleFind(LazySearchIndex *searchIndex);
+
+protected:
+  Module *getModuleFromUser();
+  ModuleTopicTuple getModuleAndTopicFromUser();
+  SourceTargetDependency getSourceTargetDepFromUser();
+
+  const ModuleCollection &MC;
+  std::istream &in;
+  std::ostream &out;
+  std::ostream &err;
+};
+
+// Runs all editing commands on a collection.
+class CommandHandler : public ReadOnlyCommandHandler {
+public:
+  CommandHandler(ModuleCollection &MC, std::istream &in, std::ostream &out,
+                 std::ostream &err)
+      : ReadOnlyCommandHandler(MC, in, out, err), mutableMC(MC) {}
+
+  void handleAddModule();
+  void handleDeleteModule();
+  void handleAddTopic();
+  void handleDeleteTopic();
+  void handleAddDependency();
+  void handleDeleteDependency();
+  void handleValidate();
+  void handleMoveTopic();
+  void handleMoveTopics();
+  void handleCompactIDs();
+
+  // Whether a command changed the collection. Failed commands leave it as it
+  // was.
+  bool hasModified() const { return modified; }
+
+private:
+  std::optional<TopicMove> parseTopicMove(std::string_view input);
+
+  // The collection of MC, which the editing commands modify.
+  ModuleCollection &mutableMC;
+  bool modified = false;
+};
+
+// This function parses the rest of the user input and returns a module. The
+// leftover user input on the line should be formatted like this:
+//
+// MODULE_NAME
+// where every direct name can be replaced with the corresponding ID.
+//
+// If the module is not found a nullptr is returned instead.
+Module *ReadOnlyCommandHandler::getModuleFromUser() {
+  std::string rawInput;
+  std::getline(in, rawInput);
+  rawInput = absl::StripLeadingAsciiWhitespace(
+      absl::StripTrailingAsciiWhitespace(rawInput));
+
+  Module *reqModule = findModule(MC, rawInput);
+  if (!reqModule) {
+    err << "Could not find module \"" << rawInput << "\"\n";
+    return nullptr;
+  }
+
+  return reqModule;
+}
+
+// This function parses the rest of the user input and returns a pair module and
+// topic. The leftover user input on the line should be formatted like this:
+//
+// MODULE_NAME:TOPIC_NAME
+// where every direct name can be replaced with the corresponding ID.
+//
+// If the module or topic is not found a nullptr is returned instead.
+ModuleTopicTuple ReadOnlyCommandHandler::getModuleAndTopicFromUser() {
+  std::string rawInput;
+  std::getline(in, rawInput);
+  rawInput = absl::StripLeadingAsciiWhitespace(
+      absl::StripTrailingAsciiWhitespace(rawInput));
+
+  std::vector<std::string> splitInput = absl::StrSplit(rawInput, ":");
+  Module *reqModule = findModule(MC, splitInput[0]);
+  if (!reqModule) {
+    err << "Could not find module \"" << splitInput[0] << "\"\n";
+    return {nullptr, nullptr};
+  }
+  if (splitInput.size() < 2) {
+    err << "Could not find topic name.";
+    return {nullptr, nullptr};
+  }
+  Topic *reqTopic =
+      findTopic(MC, *reqModule, splitInput[1]);
+  if (!reqTopic) {
+    err << "Could not find topic \"" << splitInput[1] << "\" in module \""
+        << splitInput[0] << "\"\n";
+    return {nullptr, nullptr};
+  }
+  return {reqModule, reqTopic};
+}
+
+// This function parses the rest of the user input and returns a source and a
+// target tuple with and additional dependency specifier. The leftover user
+// input on the line should be formatted like this:
+//
+// MODULE_NAME:TOPIC_NAME -> MODULE_NAME:TOPIC_NAME
+// where every direct name can be replaced with the corresponding ID.
+//
+// If the modules or topics are not found a nullptr is returned instead.
+SourceTargetDependency ReadOnlyCommandHandler::getSourceTargetDepFromUser() {
+  std::string rawInput;
+  std::getline(in, rawInput);
+
+  auto parts = splitDependencyInput(rawInput);
+  if (!parts) {
+    err << "Command input was wrongly formatted.";
+    return {{nullptr, nullptr}, {nullptr, nullptr}, ""};
+  }
+  std::string depSpecifier(parts->arrow);
+  //===--------------------------------------------------------------------===//
+  // Source module handling
+  std::string_view sourceModuleRef =
+      absl::StripAsciiWhitespace(parts->sourceModule);
+  Module *reqSourceModule = findModule(MC, sourceModuleRef);
+  if (!reqSourceModule) {
+    err << "Could not find source module \"" << sourceModuleRef << "\"\n";
+    return {{nullptr, nullptr}, {nullptr, nullptr}, depSpecifier};
+  }
+
+  //===--------------------------------------------------------------------===//
+  // Source topic handling
+  std::string_view sourceTopicRef =
+      absl::StripAsciiWhitespace(parts->sourceTopic);
+  Topic *reqSourceTopic = findTopic(MC, *reqSourceModule, sourceTopicRef);
+  if (!reqSourceTopic) {
+    err << "Could not find source topic \"" << sourceTopicRef
+        << "\" in module \"" << sourceModuleRef << "\"\n";
+    return {{reqSourceModule, nullptr}, {nullptr, nullptr}, depSpecifier};
+  }
+
+  //===--------------------------------------------------------------------===//
+  // Target module handling
+  std::string_view targetModuleRef =
+      absl::StripAsciiWhitespace(parts->targetModule);
+  Module *reqTargetModule = findModule(MC, targetModuleRef);
+  if (!reqTargetModule) {
+    err << "Could not find target module \"" << targetModuleRef << "\"\n";
+    return {
+        {reqSourceModule, reqSourceTopic}, {nullptr, nullptr}, depSpecifier};
+  }
+
+  //===--------------------------------------------------------------------===//
+  // Target topic handling
+  std::string_view targetTopicRef =
+      absl::StripAsciiWhitespace(parts->targetTopic);
+  Topic *reqTargetTopic = findTopic(MC, *reqTargetModule, targetTopicRef);
+  if (!reqTargetTopic) {
+    err << "Could not find target topic \"" << targetTopicRef
+        << "\" in module \"" << targetModuleRef << "\"\n";
+    return {{reqSourceModule, reqSourceTopic},
+            {reqTargetModule, nullptr},
+            depSpecifier};
+  }
+
+  return {{reqSourceModule, reqSourceTopic},
+          {reqTargetModule, reqTargetTopic},
+          depSpecifier};
+}
+
+void ReadOnlyCommandHandler::handleListModules() {
+  out << "Found the following modules:\n";
+  for (auto &module : MC.modules()) {
+    out << "Name: " << module->getModuleName()
+        << "  (ID: " << module->getModuleID() << ")"
+        << "\n";
+  }
+}
+
+void CommandHandler::handleAddModule() {
+  std::string newModuleName;
+  std::getline(in, newModuleName);
+  newModuleName = absl::StripLeadingAsciiWhitespace(
+      absl::StripTrailingAsciiWhitespace(newModuleName));
+
+  if (newModuleName.empty()) {
+    err << "Module name was empty\n";
+    return;
+  }
+
+  Module &newModule = mutableMC.addModule(newModuleName);
+  modified = true;
+  out << "Create new module: " << newModule.getModuleName()
+      << "  (ID: " << newModule.getModuleID() << ")"
+      << "\n";
+}
+
+void CommandHandler::handleDeleteModule() {
+  Module *reqModule = getModuleFromUser();
+  if (!reqModule) {
+    return; // if user input was wrong return to main menu
+  }
+  std::string deletedModuleName = reqModule->getModuleName();
+  int deletedModuleID = reqModule->getModuleID();
+  mutableMC.deleteModule(*reqModule);
+  modified = true;
+  out << "Deleted module: " << deletedModuleName
+      << "  (ID: " << deletedModuleID << ")"
+      << "\n";
+}
+
+void ReadOnlyCommandHandler::handleListTopics() {
+  Module *reqModule = getModuleFromUser();
+  if (!reqModule) {
+    return; // if user input was wrong return to main menu
+  }
+
+  out << "Found the following topics for " << reqModule->getModuleName()
+      << ":\n";
+  for (auto &topic : reqModule->topics()) {
+    out << "(ID: " << topic->getID() << ")  "
+        << "Name: " << topic->getName() << "\n";
+  }
+}
+
+void CommandHandler::handleAddTopic() {
+  std::string rawInput;
+  std::getline(in, rawInput);
+  std::vector<std::string> splitInput = absl::StrSplit(rawInput, ":");
+
+  if (splitInput.size() < 2) {
+    err << "Input was wrongly formatted.";
+    return;
+  }
+
+  splitInput[0] = absl::StripLeadingAsciiWhitespace(
+      absl::StripTrailingAsciiWhitespace(splitInput[0]));
+  splitInput[1] = absl::StripLeadingAsciiWhitespace(
+      absl::StripTrailingAsciiWhitespace(splitInput[1]));
+
+  Module *reqModule = findModule(MC, splitInput[0]);
+  if (!reqModule) {
+    err << "Could not find module \"" << splitInput[0] << "\"\n";
+    return;
+  }
+  if (splitInput[1].empty()) {
+    err << "Topic name was empty\n";
+    return;
+  }
+  Topic *newTopic =
+      mutableMC.addTopicToModule(std::move(splitInput[1]), *reqModule);
+  modified = true;
+  out << "Created new topic: " << newTopic->getName()
+      << "  (ID: " << newTopic->getID() << ")"
+      << " in module " << reqModule->getModuleName() << "\n";
+}
+
+void CommandHandler::handleDeleteTopic() {
+  auto [reqModule, reqTopic] = getModuleAndTopicFromUser();
+  if (!reqModule || !reqTopic) {
+    return; // if user input was wrong return to main menu
+  }
+
+  std::string deletedTopicName = reqTopic->getName();
+  int deletedTopicID = reqTopic->getID();
+  mutableMC.deleteTopic(*reqModule, *reqTopic);
+  modified = true;
+
+  out << "Deleted topic: " << deletedTopicName << "  (ID: " << deletedTopicID
+      << ") out of module " << reqModule->getModuleName() << "\n";
+}
+
+void CommandHandler::handleAddDependency() {
+  auto sourceTargetDep = getSourceTargetDepFromUser();
+  if (!sourceTargetDep.isValid()) {
+    return; // if user input was wrong return to main menu
+  }
+
+  if (sourceTargetDep.getDependencyTypeSpecifier().compare(0, 2, "->") == 0) {
+    if (!sourceTargetDep.getSource().getTopic()->addDependency(
+            *sourceTargetDep.getTarget().getTopic())) {
+      err << "Dependency already exists\n";
+      return;
+    }
+    modified = true;
+    out << "Added dependency from "
+        << sourceTargetDep.getSource().getTopic()->getName() << " -> "
+        << sourceTargetDep.getTarget().getTopic()->getName() << "\n";
+  } else if (sourceTargetDep.getDependencyTypeSpecifier().compare(0, 2, "~>") ==
+             0) {
+    if (!sourceTargetDep.getSource().getTopic()->addSoftDependency(
+            *sourceTargetDep.getTarget().getTopic())) {
+      err << "Soft dependency already exists\n";
+      return;
+    }
+    modified = true;
+    out << "Added soft dependency from "
+        << sourceTargetDep.getSource().getTopic()->getName() << " ~> "
+        << sourceTargetDep.getTarget().getTopic()->getName() << "\n";
+  } else {
+    err << "Did not understand dependency specifier "
+        << sourceTargetDep.getDependencyTypeSpecifier() << "\n";
+  }
+}
+
+void CommandHandler::handleDeleteDependency() {
+  auto sourceTargetDep = getSourceTargetDepFromUser();
+  if (!sourceTargetDep.isValid()) {
+    return; // if user input was wrong return to main menu
+  }
+
+  std::string deletedSrcTopicName =
+      sourceTargetDep.getSource().getTopic()->getName();
+  std::string deletedTargetTopicName =
+      sourceTargetDep.getTarget().getTopic()->getName();
+
+  Topic *sourceTopic = sourceTargetDep.getSource().getTopic();
+  Topic *targetTopic = sourceTargetDep.getTarget().getTopic();
+  if (sourceTargetDep.getDependencyTypeSpecifier().compare(0, 2, "->") == 0) {
+    modified = sourceTopic->hasDependency(targetTopic->getID());
+    sourceTopic->removeDependency(*targetTopic);
+
+    out << "Removed dependency from " << deletedSrcTopicName << " -> "
+        << deletedTargetTopicName << "\n";
+  } else if (sourceTargetDep.getDependencyTypeSpecifier().compare(0, 2, "~>") ==
+             0) {
+    modified = sourceTopic->hasSoftDependency(targetTopic->getID());
+    sourceTopic->removeSoftDependency(*targetTopic);
+
+    out << "Removed soft dependency from " << deletedSrcTopicName << " ~> "
+        << deletedTargetTopicName << "\n";
+  } else {
+    err << "Did not understand dependency specifier "
+        << sourceTargetDep.getDependencyTypeSpecifier() << "\n";
+  }
+}
+
+void ReadOnlyCommandHandler::handleListDependencies() {
+  auto [reqModule, reqTopic] = getModuleAndTopicFromUser();
+  if (!reqModule || !reqTopic) {
+    return; // if user input was wrong return to main menu
+  }
+
+  out << "Found the following dependencies for [" << reqModule->getModuleName()
+      << ":" << reqTopic->getName() << "]\n";
+  if (reqTopic->numDependencies() > 0) {
+    out << "Dependencies:\n";
+    for (auto dep : reqTopic->dependencies()) {
+      if (const Topic *depTopic = MC.getTopicFromID(dep)) {
+        out << "-> " << depTopic->getName() << "\n";
+      } else {
+        out << "-> unknown topic (ID: " << dep << ")\n";
+      }
+    }
+  }
+  if (reqTopic->numSoftDependencies() > 0) {
+    out << "Soft dependencies:\n";
+    for (auto softDep : reqTopic->softDependencies()) {
+      if (const Topic *depTopic = MC.getTopicFromID(softDep)) {
+        out << "~> " << depTopic->getName() << "\n";
+      } else {
+        out << "~> unknown topic (ID: " << softDep << ")\n";
+      }
+    }
+  }
+}
+
+void ReadOnlyCommandHandler::handleListRevDependencies() {
+  auto [reqModule, reqTopic] = getModuleAndTopicFromUser();
+  if (!reqModule || !reqTopic) {
+    return; // if user input was wrong return to main menu
+  }
+
+  // Dependents are only known for loaded modules.
+  MC.loadAllModules();
+  out << "Found the following topics depending on ["
+      << reqModule->getModuleName() << ":" << reqTopic->getName() << "]\n";
+  auto printDependent = [this](std::string_view arrow, int dependentID) {
+    Module *depModule = MC.getModuleFromTopicID(dependentID);
+    const Topic *depTopic = MC.getTopicFromID(dependentID);
+    if (depModule && depTopic) {
+      out << arrow << " " << depModule->getModuleName() << ":"
+          << depTopic->getName() << "\n";
+    }
+  };
+  if (reqTopic->numDependents() > 0) {
+    out << "Dependents:\n";
+    for (auto dependent : reqTopic->dependents()) {
+      printDependent("<-", dependent);
+    }
+  }
+  if (reqTopic->numSoftDependents() > 0) {
+    out << "Soft dependents:\n";
+    for (auto softDependent : reqTopic->softDependents()) {
+      printDependent("<~", softDependent);
+    }
+  }
+}
+
+void CommandHandler::handleValidate() {
+  std::string rawInput;
+  std::getline(in, rawInput);
+  rawInput = absl::StripLeadingAsciiWhitespace(
+      absl::StripTrailingAsciiWhitespace(rawInput));
+  bool repair = absl::StartsWith(rawInput, "repair");
+
+  auto issues = repair ? repairModuleCollection(mutableMC)
+                       : validateModuleCollection(MC);
+  modified = repair && !issues.empty();
+  if (issues.empty()) {
+    out << "No issues found.\n";
+    return;
+  }
+
+  out << "Found the following issues:\n";
+  for (auto &issue : issues) {
+    issue.dump(out);
+  }
+}
+
+// Renders a single module. The leftover user input on the line should be
+// formatted like this:
+//
+// MODULE_NAME [dot|html]
+// where MODULE_NAME can be replaced with the module ID. Without a format the
+// module is rendered as dot graph.
+void ReadOnlyCommandHandler::handleRenderModule() {
+  std::string rawInput;
+  std::getline(in, rawInput);
+  std::string_view moduleRef = absl::StripAsciiWhitespace(rawInput);
+
+  // Module names can contain spaces, so only the last word is the format.
+  std::string_view format = "dot";
+  if (auto sep = moduleRef.find_last_of(' '); sep != std::string_view::npos) {
+    std::string_view lastWord = moduleRef.substr(sep + 1);
+    if (lastWord == "dot" || lastWord == "html") {
+      format = lastWord;
+      moduleRef = absl::StripTrailingAsciiWhitespace(moduleRef.substr(0, sep));
+    }
+  }
+
+  Module *reqModule = findModule(MC, moduleRef);
+  if (!reqModule) {
+    err << "Could not find module \"" << moduleRef << "\"\n";
+    return;
+  }
+
+  if (format == "html") {
+    HTMLTableEmitter emitter(1);
+    traverseModule(MC, *reqModule, emitter);
+    out << emitter.takeTable() << "\n";
+  } else {
+    // Dependencies on topics of other modules show up as plain ID nodes.
+    OutputSink sink(out);
+    DotGraphEmitter emitter(sink);
+    traverseModule(MC, *reqModule, emitter);
+  }
+}
+
+// Lists the modules and topics matching the rest of the input line, e.g.,
+//
+// find QUERY
+void ReadOnlyCommandHandler::handleFind(LazySearchIndex *searchIndex) {
+  std::string rawInput;
+  std::getline(in, rawInput);
+  std::string_view query = absl::StripAsciiWhitespace(rawInput);
+  if (query.empty()) {
+    err << "Missing search query.\n";
+    return;
+  }
+
+  std::optional<SearchIndex> localIndex;
+  if (!searchIndex) {
+    localIndex.emplace(MC);
+  }
+  const SearchIndex &index =
+      searchIndex ? searchIndex->get(MC) : *localIndex;
+  auto matches = index.find(query);
+  if (matches.empty()) {
+    out << "No matches for \"" << query << "\"\n";
+    return;
+  }
+
+  for (auto &match : matches) {
+    out << match.moduleName;
+    if (match.topicName) {
+      out << ":" << *match.topicName << " (" << match.moduleID << ":"
+          << *match.topicID << ")\n";
+    } else {
+      out << " (" << match.moduleID << ")\n";
+    }
+  }
+}
+
+// Parses a topic move, which should be formatted like this:
+//
+// MODULE_NAME:TOPIC_NAME -> MODULE_NAME
+// where every direct name can be replaced with the corresponding ID.
+std::optional<TopicMove>
+CommandHandler::parseTopicMove(std::string_view input) {
+  // Split at the last arrow and the last colon before it, like the regex
+  // (.*):(.*) -> (.*) would.
+  size_t arrow = findLastArrow(input, input.size(), /*allowSoft=*/false);
+  size_t colon = arrow == std::string_view::npos || arrow == 0
+                     ? std::string_view::npos
+                     : input.rfind(':', arrow - 1);
+  if (colon == std::string_view::npos) {
+    err << "Command input was wrongly formatted.";
+    return std::nullopt;
+  }
+
+  std::string_view sourceModuleRef =
+      absl::StripAsciiWhitespace(input.substr(0, colon));
+  Module *reqSourceModule = findModule(MC, sourceModuleRef);
+  if (!reqSourceModule) {
+    err << "Could not find source module \"" << sourceModuleRef << "\"\n";
+    return std::nullopt;
+  }
+
+  std::string_view topicRef =
+      absl::StripAsciiWhitespace(input.substr(colon + 1, arrow - colon - 1));
+  Topic *reqTopic = findTopic(MC, *reqSourceModule, topicRef);
+  if (!reqTopic) {
+    err << "Could not find topic \"" << topicRef << "\" in module \""
+        << sourceModuleRef << "\"\n";
+    return std::nullopt;
+  }
+
+  std::string_view targetModuleRef =
+      absl::StripAsciiWhitespace(input.substr(arrow + 4));
+  Module *reqTargetModule = findModule(MC, targetModuleRef);
+  if (!reqTargetModule) {
+    err << "Could not find target module \"" << targetModuleRef << "\"\n";
+    return std::nullopt;
+  }
+
+  return TopicMove{reqSourceModule, reqTopic, reqTargetModule};
+}
+
+// Moves a topic with all of its dependencies into another module. The
+// leftover user input on the line is parsed by parseTopicMove.
+void CommandHandler::handleMoveTopic() {
+  std::string rawInput;
+  std::getline(in, rawInput);
+
+  auto move = parseTopicMove(rawInput);
+  if (!move) {
+    return;
+  }
+  mutableMC.moveTopic(*move->source, *move->topic, *move->target);
+  modified = true;
+  out << "Moved topic: " << move->topic->getName()
+      << "  (ID: " << move->topic->getID() << ") from module "
+      << move->source->getModuleName() << " to module "
+      << move->target->getModuleName() << "\n";
+}
+
+// Moves many topics in the format of moveTopic, separated by semicolons on
+// the rest of the line, which is how the query server gets them. Without
+// moves on the line, one move per following line is read up to the next
+// empty line. All topics are looked up before the first one is moved, then
+// the topic list of every affected module is rebuilt once, instead of once
+// per topic.
+void CommandHandler::handleMoveTopics() {
+  std::string rawInput;
+  std::getline(in, rawInput);
+
+  std::vector<TopicMove> moves;
+  auto addMove = [&](std::string_view input) {
+    if (auto move = parseTopicMove(input)) {
+      moves.push_back(*move);
+    }
+  };
+  if (!absl::StripAsciiWhitespace(rawInput).empty()) {
+    for (std::string_view input : absl::StrSplit(rawInput, ';')) {
+      if (!absl::StripAsciiWhitespace(input).empty()) {
+        addMove(input);
+      }
+    }
+  } else {
+    while (std::getline(in, rawInput) &&
+           !absl::StripAsciiWhitespace(rawInput).empty()) {
+      addMove(rawInput);
+    }
+  }
+  mutableMC.moveTopics(moves);
+  modified = !moves.empty();
+  out << "Moved " << moves.size() << " topics\n";
+}
+
+void CommandHandler::handleCompactIDs() {
+  std::string rest;
+  std::getline(in, rest);
+
+  mutableMC.compactIDs();
+  modified = true;
+  out << "Renumbered " << MC.numModules() << " modules and " << MC.numTopics()
+      << " topics\n";
+}
+
+bool isCommand(const std::string_view rawCmd, CommandType cmdType,
+               const std::string_view cmdName) {
+  // Command numbers need to match exactly, otherwise, 10 would be taken for 1.
+  return rawCmd == std::to_string(commandToInt(cmdType)) ||
+         absl::StartsWith(rawCmd, cmdName);
+}
+
+} // namespace
+
+CommandType convertToCommandType(const std::string_view rawCmd) {
+  // Listing commands
+  if (isCommand(rawCmd, CommandType::LIST_MODULES, "listModules")) {
+    return CommandType::LIST_MODULES;
+  }
+  if (isCommand(rawCmd, CommandType::LIST_TOPICS, "listTopic")) {
+    return CommandType::LIST_TOPICS;
+  }
+  if (isCommand(rawCmd, CommandType::LIST_DEPENDENCIES, "listDeps")) {
+    return CommandType::LIST_DEPENDENCIES;
+  }
+  if (isCommand(rawCmd, CommandType::LIST_REV_DEPENDENCIES, "listRevDeps")) {
+    return CommandType::LIST_REV_DEPENDENCIES;
+  }
+
+  // Edit module commands
+  if (isCommand(rawCmd, CommandType::ADD_MODULE, "addModule")) {
+    return CommandType::ADD_MODULE;
+  }
+  if (isCommand(rawCmd, CommandType::DELETE_MODULE, "delModule")) {
+    return CommandType::DELETE_MODULE;
+  }
+
+  // Edit topic commands
+  if (isCommand(rawCmd, CommandType::ADD_TOPIC, "addTopic")) {
+    return CommandType::ADD_TOPIC;
+  }
+  if (isCommand(rawCmd, CommandType::DELETE_TOPIC, "delTopic")) {
+    return CommandType::DELETE_TOPIC;
+  }
+
+  // Edit dependencie commands
+  if (isCommand(rawCmd, CommandType::ADD_DEPENDENCY, "addDep")) {
+    return CommandType::ADD_DEPENDENCY;
+  }
+  if (isCommand(rawCmd, CommandType::DELETE_DEPENDENCY, "delDep")) {
+    return CommandType::DELETE_DEPENDENCY;
+  }
+
+  if (isCommand(rawCmd, CommandType::VALIDATE, "validate")) {
+    return CommandType::VALIDATE;
+  }
+  if (isCommand(rawCmd, CommandType::RENDER_MODULE, "render")) {
+    return CommandType::RENDER_MODULE;
+  }
+  if (isCommand(rawCmd, CommandType::FIND, "find")) {
+    return CommandType::FIND;
+  }
+  // Before moveTopic, which is a prefix of it.
+  if (isCommand(rawCmd, CommandType::MOVE_TOPICS, "moveTopics")) {
+    return CommandType::MOVE_TOPICS;
+  }
+  if (isCommand(rawCmd, CommandType::MOVE_TOPIC, "moveTopic")) {
+    return CommandType::MOVE_TOPIC;
+  }
+  if (isCommand(rawCmd, CommandType::COMPACT_IDS, "compactIDs")) {
+    return CommandType::COMPACT_IDS;
+  }
+
+  if (absl::StartsWith(rawCmd, "h") || absl::StartsWith(rawCmd, "help")) {
+    return CommandType::HELP;
+  }
+  if (absl::StartsWith(rawCmd, "q") || absl::StartsWith(rawCmd, "quit")) {
+    return CommandType::QUIT;
+  }
+
+  return CommandType::ERROR;
+}
+
+bool isReadOnlyCommand(CommandType cmd) {
+  switch (cmd) {
+  case CommandType::LIST_MODULES:
+  case CommandType::LIST_TOPICS:
+  case CommandType::LIST_DEPENDENCIES:
+  case CommandType::LIST_REV_DEPENDENCIES:
+  case CommandType::RENDER_MODULE:
+  case CommandType::FIND:
+  case CommandType::HELP:
+  case CommandType::QUIT:
+  case CommandType::ERROR:
+    return true;
+  case CommandType::ADD_MODULE:
+  case CommandType::DELETE_MODULE:
+  case CommandType::ADD_TOPIC:
+  case CommandType::DELETE_TOPIC:
+  case CommandType::ADD_DEPENDENCY:
+  case CommandType::DELETE_DEPENDENCY:
+  case CommandType::MOVE_TOPIC:
+  case CommandType::COMPACT_IDS:
+  case CommandType::MOVE_TOPICS:
+  case CommandType::VALIDATE: // validate repair modifies the collection
+    return false;
+  }
+  return false;
+}
+
+void printCommandHelp(std::ostream &out) {
+  out << R"(
+1) listModules
+2) listTopics   MODULE_NAME
+3) listDeps     MODULE_NAME:TOPIC_NAME
+4) addModule    MODULE_NAME
+5) delModule    MODULE_NAME
+6) addTopic     MODULE_NAME:TOPIC_NAME
+7) delTopic     MODULE_NAME:TOPIC_NAME
+8) addDep       MODULE_NAME:TOPIC_NAME -> MODULE_NAME:TOPIC_NAME
+9) delDep       MODULE_NAME:TOPIC_NAME -> MODULE_NAME:TOPIC_NAME
+10) validate    [repair]
+11) listRevDeps MODULE_NAME:TOPIC_NAME
+12) render      MODULE_NAME [dot|html]
+13) find        QUERY
+14) moveTopic   MODULE_NAME:TOPIC_NAME -> MODULE_NAME
+15) compactIDs  renumbers all modules and topics with consecutive IDs
+16) moveTopics  MODULE_NAME:TOPIC_NAME -> MODULE_NAME; ... on one line, or
+                one move per line after it, up to an empty line
+q) quit
+h) help
+
+Hints:
+  - every NAME can always be replaced by the corresponding ID
+  - dependencies arrows(->) can be replaced with ~> to indicate soft dependencies
+)";
+}
+
+// Runs the commands of isReadOnlyCommand, which only need a const collection.
+static void runReadOnlyCommand(const ModuleCollection &moduleCollection,
+                               CommandType cmd, std::istream &in,
+                               std::ostream &out, std::ostream &err,
+                               LazySearchIndex *searchIndex) {
+  ReadOnlyCommandHandler handler(moduleCollection, in, out, err);
+  switch (cmd) {
+  case CommandType::LIST_MODULES:
+    handler.handleListModules();
+    break;
+  case CommandType::LIST_TOPICS:
+    handler.handleListTopics();
+    break;
+  case CommandType::LIST_DEPENDENCIES:
+    handler.handleListDependencies();
+    break;
+  case CommandType::LIST_REV_DEPENDENCIES:
+    handler.handleListRevDependencies();
+    break;
+  case CommandType::RENDER_MODULE:
+    handler.handleRenderModule();
+    break;
+  case CommandType::FIND:
+    handler.handleFind(searchIndex);
+    break;
+  default:
+    break; // HELP, QUIT, and ERROR are handled by the caller
+  }
+}
+
+bool executeCommand(ModuleCollection &moduleCollection, CommandType cmd,
+                    std::istream &in, std::ostream &out, std::ostream &err,
+                    LazySearchIndex *searchIndex) {
+  if (isReadOnlyCommand(cmd)) {
+    runReadOnlyCommand(moduleCollection, cmd, in, out, err, searchIndex);
+    return false;
+  }
+  if (searchIndex) {
+    searchIndex->invalidate();
+  }
+
+  CommandHandler handler(moduleCollection, in, out, err);
+  switch (cmd) {
+  case CommandType::ADD_MODULE:
+    handler.handleAddModule();
+    break;
+  case CommandType::DELETE_MODULE:
+    handler.handleDeleteModule();
+    break;
+  case CommandType::ADD_TOPIC:
+    handler.handleAddTopic();
+    break;
+  case CommandType::DELETE_TOPIC:
+    handler.handleDeleteTopic();
+    break;
+  case CommandType::ADD_DEPENDENCY:
+    handler.handleAddDependency();
+    break;
+  case CommandType::DELETE_DEPENDENCY:
+    handler.handleDeleteDependency();
+    break;
+  case CommandType::VALIDATE:
+    handler.handleValidate();
+    break;
+  case CommandType::MOVE_TOPIC:
+    handler.handleMoveTopic();
+    break;
+  case CommandType::COMPACT_IDS:
+    handler.handleCompactIDs();
+    break;
+  case CommandType::MOVE_TOPICS:
+    handler.handleMoveTopics();
+    break;
+  default:
+    break; // read only commands
+  }
+  return handler.hasModified();
+}
+
+void executeReadOnlyCommand(const ModuleCollection &moduleCollection,
+                            CommandType cmd, std::istream &in,
+                            std::ostream &out, std::ostream &err,
+                            LazySearchIndex *searchIndex) {
+  assert(isReadOnlyCommand(cmd) && moduleCollection.isFullyLoaded());
+  runReadOnlyCommand(moduleCollection, cmd, in, out, err, searchIndex);
+}
+
+} // namespace sg20
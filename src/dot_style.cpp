@@ -0,0 +1,395 @@
+#include "sg20_graphgen/dot_style.h"
+#include "sg20_graphgen/emitters.h"
+#include "sg20_graphgen/schedule.h"
+#include "sg20_graphgen/serialization.h"
+
+#include "yaml-cpp/yaml.h"
+
+#include <algorithm>
+#include <charconv>
+#include <map>
+
+namespace sg20 {
+
+//===----------------------------------------------------------------------===//
+// Style file parsing
+
+namespace {
+
+[[noreturn]] void throwRuleError(size_t ruleIndex, std::string_view msg) {
+  throw ParseError("Style rule " + std::to_string(ruleIndex + 1) + ": " +
+                   std::string(msg));
+}
+
+std::string readScalar(const YAML::Node &node, size_t ruleIndex,
+                       std::string_view key) {
+  if (!node.IsScalar()) {
+    throwRuleError(ruleIndex, std::string(key) + " is not a scalar");
+  }
+  return node.Scalar();
+}
+
+bool readBool(const YAML::Node &node, size_t ruleIndex, std::string_view key) {
+  bool value;
+  if (!node.IsScalar() || !YAML::convert<bool>::decode(node, value)) {
+    throwRuleError(ruleIndex, std::string(key) + " is not a boolean");
+  }
+  return value;
+}
+
+StyleRule parseStyleRule(const YAML::Node &yamlRule, size_t ruleIndex) {
+  if (!yamlRule.IsMap()) {
+    throwRuleError(ruleIndex, "rule is not a map");
+  }
+
+  StyleRule rule;
+  std::optional<StyleRule::Target> target;
+  bool hasAttributes = false;
+  for (auto entry : yamlRule) {
+    std::string key = readScalar(entry.first, ruleIndex, "key");
+    const YAML::Node &value = entry.second;
+    if (key == "select") {
+      std::string targetName = readScalar(value, ruleIndex, key);
+      if (targetName == "module") {
+        target = StyleRule::Target::Module;
+      } else if (targetName == "topic") {
+        target = StyleRule::Target::Topic;
+      } else if (targetName == "edge") {
+        target = StyleRule::Target::Edge;
+      } else {
+        throwRuleError(ruleIndex, "unknown selection \"" + targetName +
+                                      "\", expected module, topic, or edge");
+      }
+    } else if (key == "module") {
+      rule.module = readScalar(value, ruleIndex, key);
+    } else if (key == "topic") {
+      rule.topic = readScalar(value, ruleIndex, key);
+    } else if (key == "kind") {
+      std::string kindName = readScalar(value, ruleIndex, key);
+      if (kindName == "hard") {
+        rule.kind = DependencyKind::Hard;
+      } else if (kindName == "soft") {
+        rule.kind = DependencyKind::Soft;
+      } else {
+        throwRuleError(ruleIndex, "unknown dependency kind \"" + kindName +
+                                      "\", expected hard or soft");
+      }
+    } else if (key == "crossModule") {
+      rule.crossModule = readBool(value, ruleIndex, key);
+    } else if (key == "critical") {
+      rule.critical = readBool(value, ruleIndex, key);
+    } else if (key == "attributes") {
+      if (!value.IsMap()) {
+        throwRuleError(ruleIndex, "attributes is not a map");
+      }
+      for (auto attribute : value) {
+        rule.attributes.emplace_back(
+            readScalar(attribute.first, ruleIndex, "attribute name"),
+            readScalar(attribute.second, ruleIndex, "attribute value"));
+      }
+      hasAttributes = true;
+    } else {
+      throwRuleError(ruleIndex, "unknown key \"" + key + "\"");
+    }
+  }
+
+  if (!target) {
+    throwRuleError(ruleIndex, "missing select");
+  }
+  if (!hasAttributes) {
+    throwRuleError(ruleIndex, "missing attributes");
+  }
+  rule.target = *target;
+  if (rule.topic && rule.target != StyleRule::Target::Topic) {
+    throwRuleError(ruleIndex, "topic can only be selected by topic rules");
+  }
+  if ((rule.kind || rule.crossModule || rule.critical) &&
+      rule.target != StyleRule::Target::Edge) {
+    throwRuleError(ruleIndex,
+                   "kind, crossModule, and critical only select edges");
+  }
+  return rule;
+}
+
+} // namespace
+
+std::vector<StyleRule> parseStyleRules(std::string_view input) {
+  YAML::Node file = YAML::Load(std::string(input));
+  auto yamlRules = file["Rules"];
+  if (!yamlRules) {
+    return {};
+  }
+  if (!yamlRules.IsSequence()) {
+    throw ParseError("Style file broken, Rules is not a sequence");
+  }
+
+  std::vector<StyleRule> rules;
+  rules.reserve(yamlRules.size());
+  for (auto yamlRule : yamlRules) {
+    rules.push_back(parseStyleRule(yamlRule, rules.size()));
+  }
+  return rules;
+}
+
+//===----------------------------------------------------------------------===//
+// Style sheet compilation
+
+namespace {
+
+using AttributeList = std::vector<std::pair<std::string, std::string>>;
+
+// Sets the attributes of from in into, keeping the position of attributes that
+// are already set.
+void mergeAttributes(AttributeList &into, const AttributeList &from) {
+  for (auto &[name, value] : from) {
+    auto it = std::find_if(into.begin(), into.end(),
+                           [&](auto &entry) { return entry.first == name; });
+    if (it != into.end()) {
+      it->second = value;
+    } else {
+      into.emplace_back(name, value);
+    }
+  }
+}
+
+std::optional<int> parseID(std::string_view str) {
+  int ID;
+  auto [end, ec] = std::from_chars(str.data(), str.data() + str.size(), ID);
+  if (ec != std::errc() || end != str.data() + str.size()) {
+    return std::nullopt;
+  }
+  return ID;
+}
+
+// Finds a module by exact name or by ID.
+const Module *findModule(const ModuleCollection &moduleCollection,
+                         std::string_view selector) {
+  for (auto &module : moduleCollection.modules()) {
+    if (module->getModuleName() == selector) {
+      return module.get();
+    }
+  }
+  if (auto ID = parseID(selector)) {
+    return moduleCollection.getModuleFromID(*ID);
+  }
+  return nullptr;
+}
+
+// Finds the topics with the name or ID, inside of module if it is set.
+std::vector<int> findTopics(const ModuleCollection &moduleCollection,
+                            const Module *module, std::string_view selector) {
+  std::vector<int> topicIDs;
+  auto findInModule = [&](const Module &candidate) {
+    for (auto &topic : candidate.topics()) {
+      if (topic->getName() == selector) {
+        topicIDs.push_back(topic->getID());
+      }
+    }
+  };
+  if (module) {
+    findInModule(*module);
+  } else {
+    for (auto &candidate : moduleCollection.modules()) {
+      findInModule(*candidate);
+    }
+  }
+  if (!topicIDs.empty()) {
+    return topicIDs;
+  }
+
+  if (auto ID = parseID(selector)) {
+    const Topic *topic = module ? module->getTopicByID(*ID)
+                                : moduleCollection.getTopicFromID(*ID);
+    if (topic) {
+      topicIDs.push_back(topic->getID());
+    }
+  }
+  return topicIDs;
+}
+
+// A rule with its module and topic selectors resolved against the collection.
+struct ResolvedRule {
+  explicit ResolvedRule(const StyleRule *rule) : rule(rule) {}
+
+  const StyleRule *rule;
+  std::optional<int> moduleID;
+  // Sorted IDs of the selected topics, only for rules that select topics.
+  std::optional<std::vector<int>> topicIDs;
+
+  bool matchesModule(std::optional<int> ID) const {
+    return !moduleID || moduleID == ID;
+  }
+  bool matchesTopic(int topicID) const {
+    return !topicIDs ||
+           std::binary_search(topicIDs->begin(), topicIDs->end(), topicID);
+  }
+  bool matchesEdge(DependencyKind kind, bool crossModule,
+                   bool critical) const {
+    return (!rule->kind || rule->kind == kind) &&
+           (!rule->crossModule || rule->crossModule == crossModule) &&
+           (!rule->critical || rule->critical == critical);
+  }
+};
+
+// Interns the attribute lists of a style sheet, so equal lists share one ID.
+class AttributeListTable {
+public:
+  AttributeListTable(std::vector<std::string> &lists) : lists(lists) {}
+
+  uint32_t intern(const AttributeList &attributes) {
+    std::string list;
+    for (auto &[name, value] : attributes) {
+      if (!list.empty()) {
+        list += ", ";
+      }
+      list += escapeDotString(name);
+      list += '=';
+      list += escapeDotString(value);
+    }
+    auto [it, inserted] = IDs.try_emplace(list, lists.size());
+    if (inserted) {
+      lists.push_back(std::move(list));
+    }
+    return it->second;
+  }
+
+private:
+  std::vector<std::string> &lists;
+  std::map<std::string, uint32_t> IDs;
+};
+
+} // namespace
+
+DotStyleSheet::DotStyleSheet(const std::vector<StyleRule> &rules,
+                             const ModuleCollection &moduleCollection) {
+  StyleRule defaultTopics;
+  defaultTopics.target = StyleRule::Target::Topic;
+  defaultTopics.attributes = {{"shape", "Mrecord"}};
+  StyleRule defaultSoftEdges;
+  defaultSoftEdges.target = StyleRule::Target::Edge;
+  defaultSoftEdges.kind = DependencyKind::Soft;
+  defaultSoftEdges.attributes = {{"style", "dotted"}};
+
+  std::vector<ResolvedRule> resolvedRules = {ResolvedRule(&defaultTopics),
+                                             ResolvedRule(&defaultSoftEdges)};
+  std::vector<int> styledModules;
+  std::vector<int> styledTopics;
+  bool hasCriticalRules = false;
+  for (auto &rule : rules) {
+    ResolvedRule resolved(&rule);
+    const Module *module = nullptr;
+    if (rule.module) {
+      module = findModule(moduleCollection, *rule.module);
+      if (!module) {
+        continue;
+      }
+      resolved.moduleID = module->getModuleID();
+      styledModules.push_back(module->getModuleID());
+    }
+    if (rule.topic) {
+      auto topicIDs = findTopics(moduleCollection, module, *rule.topic);
+      if (topicIDs.empty()) {
+        continue;
+      }
+      std::sort(topicIDs.begin(), topicIDs.end());
+      styledTopics.insert(styledTopics.end(), topicIDs.begin(),
+                          topicIDs.end());
+      resolved.topicIDs = std::move(topicIDs);
+    }
+    hasCriticalRules |= rule.critical.has_value();
+    resolvedRules.push_back(std::move(resolved));
+  }
+
+  AttributeListTable table(attributeLists);
+  auto compileModuleStyle = [&](std::optional<int> moduleID) {
+    AttributeList cluster;
+    AttributeList topics;
+    std::array<AttributeList, 8> edges;
+    for (auto &resolved : resolvedRules) {
+      if (!resolved.matchesModule(moduleID)) {
+        continue;
+      }
+      switch (resolved.rule->target) {
+      case StyleRule::Target::Module:
+        mergeAttributes(cluster, resolved.rule->attributes);
+        break;
+      case StyleRule::Target::Topic:
+        if (!resolved.topicIDs) {
+          mergeAttributes(topics, resolved.rule->attributes);
+        }
+        break;
+      case StyleRule::Target::Edge:
+        for (auto kind : {DependencyKind::Hard, DependencyKind::Soft}) {
+          for (bool crossModule : {false, true}) {
+            for (bool critical : {false, true}) {
+              size_t index = getEdgeIndex(kind, crossModule, critical);
+              if (resolved.matchesEdge(kind, crossModule, critical)) {
+                mergeAttributes(edges[index], resolved.rule->attributes);
+              }
+            }
+          }
+        }
+        break;
+      }
+    }
+
+    ModuleStyle style;
+    style.cluster = table.intern(cluster);
+    style.topics = table.intern(topics);
+    for (size_t index = 0; index < edges.size(); ++index) {
+      style.edges[index] = table.intern(edges[index]);
+    }
+    return style;
+  };
+
+  defaultStyle = compileModuleStyle(std::nullopt);
+  for (int moduleID : styledModules) {
+    if (!moduleStyles.count(moduleID)) {
+      moduleStyles.emplace(moduleID, compileModuleStyle(moduleID));
+    }
+  }
+
+  for (int topicID : styledTopics) {
+    if (topicStyles.count(topicID)) {
+      continue;
+    }
+    const Module *module = moduleCollection.getModuleFromTopicID(topicID);
+    AttributeList attributes;
+    for (auto &resolved : resolvedRules) {
+      if (resolved.rule->target == StyleRule::Target::Topic &&
+          resolved.matchesModule(module->getModuleID()) &&
+          resolved.matchesTopic(topicID)) {
+        mergeAttributes(attributes, resolved.rule->attributes);
+      }
+    }
+    topicStyles.emplace(topicID, table.intern(attributes));
+  }
+
+  if (hasCriticalRules) {
+    auto schedule = computeSchedule(moduleCollection, ScheduleOptions());
+    for (auto &slot : schedule.topics) {
+      if (slot.earliest == slot.latest) {
+        criticalSlots.emplace(slot.topic->getID(), slot.earliest);
+      }
+    }
+  }
+}
+
+DotStyleSheet
+DotStyleSheet::loadFromFile(const std::filesystem::path &filepath,
+                            const ModuleCollection &moduleCollection) {
+  return DotStyleSheet(parseStyleRules(readFileContents(filepath)),
+                       moduleCollection);
+}
+
+bool DotStyleSheet::isCriticalEdge(int topicID, int dep) const {
+  auto topicSlot = criticalSlots.find(topicID);
+  if (topicSlot == criticalSlots.end()) {
+    return false;
+  }
+  auto depSlot = criticalSlots.find(dep);
+  return depSlot != criticalSlots.end() &&
+         topicSlot->second == depSlot->second + 1;
+}
+
+} // namespace sg20
@@ -0,0 +1,116 @@
+#include "sg20_graphgen/emitters.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+
+namespace sg20 {
+
+// Mirrors the ID rules of graphviz: either an identifier ([a-zA-Z_][\w]*) or
+// a numeral (-?(.[0-9]+ | [0-9]+(.[0-9]*)?)).
+static bool isValidUnquotedDotID(std::string_view str) {
+  if (str.empty()) {
+    return false;
+  }
+
+  auto isIdentChar = [](char c) {
+    return std::isalnum(static_cast<unsigned char>(c)) || c == '_';
+  };
+  if (std::isalpha(static_cast<unsigned char>(str[0])) || str[0] == '_') {
+    return std::all_of(str.begin(), str.end(), isIdentChar);
+  }
+
+  auto isDigit = [](char c) {
+    return std::isdigit(static_cast<unsigned char>(c)) != 0;
+  };
+  if (str[0] == '-') {
+    str.remove_prefix(1);
+  }
+  if (str.empty()) {
+    return false;
+  }
+  auto dot = str.find('.');
+  std::string_view integral = str.substr(0, dot);
+  std::string_view fraction =
+      dot == std::string_view::npos ? std::string_view() : str.substr(dot + 1);
+  return std::all_of(integral.begin(), integral.end(), isDigit) &&
+         std::all_of(fraction.begin(), fraction.end(), isDigit);
+}
+
+std::string escapeDotString(std::string_view str) {
+  if (isValidUnquotedDotID(str)) {
+    return std::string(str);
+  }
+
+  std::string escaped = "\"";
+  for (char c : str) {
+    if (c == '"') {
+      escaped += '\\';
+    }
+    escaped += c;
+  }
+  escaped += '"';
+  return escaped;
+}
+
+std::string escapeJSONString(std::string_view str) {
+  std::string escaped = "\"";
+  for (char c : str) {
+    switch (c) {
+    case '"':
+      escaped += "\\\"";
+      break;
+    case '\\':
+      escaped += "\\\\";
+      break;
+    case '\n':
+      escaped += "\\n";
+      break;
+    case '\t':
+      escaped += "\\t";
+      break;
+    case '\r':
+      escaped += "\\r";
+      break;
+    default:
+      if (static_cast<unsigned char>(c) < 0x20) {
+        char buf[7];
+        std::snprintf(buf, sizeof(buf), "\\u%04x", c);
+        escaped += buf;
+      } else {
+        escaped += c;
+      }
+    }
+  }
+  escaped += '"';
+  return escaped;
+}
+
+std::string escapeXMLString(std::string_view str) {
+  std::string escaped;
+  escaped.reserve(str.size());
+  for (char c : str) {
+    switch (c) {
+    case '&':
+      escaped += "&amp;";
+      break;
+    case '<':
+      escaped += "&lt;";
+      break;
+    case '>':
+      escaped += "&gt;";
+      break;
+    case '"':
+      escaped += "&quot;";
+      break;
+    case '\'':
+      escaped += "&apos;";
+      break;
+    default:
+      escaped += c;
+    }
+  }
+  return escaped;
+}
+
+} // namespace sg20
@@ -1,135 +1,384 @@
 #include "sg20_graphgen/graph_generator.h"
+#include "sg20_graphgen/emitters.h"
+#include "sg20_graphgen/html_explorer.h"
 #include "sg20_graphgen/html_generator.h"
+#include "sg20_graphgen/layout.h"
 #include "sg20_graphgen/modules.h"
+#include "sg20_graphgen/output_sink.h"
+#include "sg20_graphgen/svg_generator.h"
+#include "sg20_graphgen/traversal.h"
 
-#include "boost/graph/adjacency_list.hpp"
-#include "boost/graph/graph_selectors.hpp"
-#include "boost/graph/graphviz.hpp"
-#include "boost/graph/properties.hpp"
-#include "boost/graph/subgraph.hpp"
-#include "boost/pending/property.hpp"
-
-#include <fstream>
-
-using boost::adjacency_list;
-using boost::directedS;
-using boost::edge_attribute;
-using boost::edge_attribute_t;
-using boost::edge_index_t;
-using boost::graph_edge_attribute_t;
-using boost::graph_graph_attribute;
-using boost::graph_graph_attribute_t;
-using boost::graph_name;
-using boost::graph_name_t;
-using boost::graph_vertex_attribute;
-using boost::graph_vertex_attribute_t;
-using boost::property;
-using boost::vecS;
-using boost::vertex_attribute_t;
+#include <algorithm>
+#include <exception>
+#include <iostream>
+#include <map>
+#include <stdexcept>
+#include <string_view>
+#include <thread>
 
 namespace sg20 {
 
-void emitFullDotGraph(const ModuleCollection &moduleCollection,
-                      std::filesystem::path outputFilename) {
-  using GraphvizAttributes = std::map<std::string, std::string>;
-  using Graph = adjacency_list<
-      boost::vecS, boost::vecS, directedS,
-      property<vertex_attribute_t, GraphvizAttributes>,
-      property<edge_index_t, int,
-               property<edge_attribute_t, GraphvizAttributes>>,
-      property<graph_name_t, std::string,
-               property<graph_graph_attribute_t, GraphvizAttributes,
-                        property<graph_vertex_attribute_t, GraphvizAttributes,
-                                 property<graph_edge_attribute_t,
-                                          GraphvizAttributes>>>>>;
-
-  if (outputFilename.extension() != "dot" &&
-      outputFilename.extension() != "gv") {
-    std::cerr
-        << "Warning: Output filename does not have a graphviz extension!\n";
+// Reports where an output is stored. The report goes to the standard error if
+// the output is written to the standard output, e.g., for graphgen | dot.
+static void reportOutput(std::string_view kind,
+                         const std::filesystem::path &outputFilename) {
+  if (isStandardOutput(outputFilename)) {
+    std::cerr << "Storing " << kind << " into the standard output\n";
+  } else {
+    std::cout << "Storing " << kind << " into " << outputFilename << "\n";
   }
+}
 
-  boost::subgraph<Graph> graph(moduleCollection.numTopics());
+static void writeFullDotGraph(const ModuleCollection &moduleCollection,
+                              OutputSink &out,
+                              const DotLayoutOptions &layoutOptions,
+                              const DotStyleSheet *style) {
+  if (!layoutOptions.layoutOrder && !layoutOptions.rankSame) {
+    DotGraphEmitter dotEmitter(out, nullptr, style);
+    traverseModuleCollection(moduleCollection, dotEmitter);
+    return;
+  }
 
-  // set graph properties
-  boost::get_property(graph, graph_name) = "main";
-  boost::get_property(graph, graph_graph_attribute)["pack"] = "true";
+  LayoutOrder order = computeLayoutOrder(moduleCollection);
+  DotGraphEmitter dotEmitter(out, layoutOptions.rankSame ? &order : nullptr,
+                             style);
+  if (layoutOptions.layoutOrder) {
+    traverseInLayoutOrder(moduleCollection, order, dotEmitter);
+  } else {
+    traverseModuleCollection(moduleCollection, dotEmitter);
+  }
+}
 
-  for (auto &module : moduleCollection.modules()) {
-    boost::subgraph<Graph> &sub_graph = graph.create_subgraph();
+void emitFullDotGraph(const ModuleCollection &moduleCollection,
+                      std::filesystem::path outputFilename,
+                      const DotLayoutOptions &layoutOptions,
+                      const DotStyleSheet *style) {
+  if (outputFilename.extension() != ".dot" &&
+      outputFilename.extension() != ".gv" &&
+      !isStandardOutput(outputFilename)) {
+    std::cerr
+        << "Warning: Output filename does not have a graphviz extension!\n";
+  }
 
-    // set sub_graph properties
-    boost::get_property(sub_graph, graph_name) =
-        "cluster_" + module->getModuleName();
-    boost::get_property(sub_graph, graph_graph_attribute)["label"] =
-        module->getModuleName();
-    get_property(sub_graph, graph_vertex_attribute)["shape"] = "Mrecord";
+  reportOutput("graph", outputFilename);
+  OutputSink outputFile(outputFilename);
+  writeFullDotGraph(moduleCollection, outputFile, layoutOptions, style);
+  outputFile.finish(outputFilename);
+}
 
-    for (auto &topic : module->topics()) {
-      int TID = topic->getID();
-      add_vertex(TID, sub_graph);
-      get(vertex_attribute_t(), graph)[TID]["label"] = topic->getName();
+// Same output as DotGraphEmitter without a style. Modules are released as soon
+// as they are written, every module is read once per pass.
+static void writeSpilledDotGraph(const SpilledCollection &spilledCollection,
+                                 OutputSink &out,
+                                 const DotLayoutOptions &layoutOptions) {
+  LayoutRanking ranking;
+  // Pairs of a topic ID and its layer, the first topic in layout order wins.
+  std::vector<std::pair<int, int>> topicLayers;
+  if (layoutOptions.layoutOrder || layoutOptions.rankSame) {
+    ranking = rankLayoutGraph(spilledCollection.buildLayoutGraph());
+  }
+  if (layoutOptions.rankSame) {
+    topicLayers.reserve(spilledCollection.numTopics());
+    for (size_t module = 0; module < spilledCollection.numModules();
+         ++module) {
+      for (int topic : ranking.moduleTopics[module]) {
+        topicLayers.emplace_back(spilledCollection.getTopicID(topic),
+                                 ranking.layers[topic]);
+      }
+      spilledCollection.releaseModule(module);
+    }
+    std::stable_sort(
+        topicLayers.begin(), topicLayers.end(),
+        [](auto &lhs, auto &rhs) { return lhs.first < rhs.first; });
+    topicLayers.erase(
+        std::unique(topicLayers.begin(), topicLayers.end(),
+                    [](auto &lhs, auto &rhs) { return lhs.first == rhs.first; }),
+        topicLayers.end());
+  }
+  ranking.layers = {};
 
-      for (auto dep : topic->dependencies()) {
-        boost::add_edge(TID, dep, graph);
+  auto getLayer = [&](int topicID) {
+    auto entry = std::lower_bound(
+        topicLayers.begin(), topicLayers.end(), topicID,
+        [](const std::pair<int, int> &entry, int topicID) {
+          return entry.first < topicID;
+        });
+    return entry != topicLayers.end() && entry->first == topicID
+               ? entry->second
+               : 0;
+  };
+  auto forEachTopic = [&](size_t module, auto visit) {
+    if (layoutOptions.layoutOrder) {
+      for (int topic : ranking.moduleTopics[module]) {
+        visit(topic);
+      }
+      return;
+    }
+    size_t first = spilledCollection.getFirstTopic(module);
+    for (size_t topic = first;
+         topic < first + spilledCollection.getNumTopics(module); ++topic) {
+      visit(topic);
+    }
+  };
+  // Writes the edges of the topic that stay inside its module, or those that
+  // leave it. Dangling dependencies are skipped.
+  auto writeEdges = [&](size_t module, size_t topic, bool crossModule) {
+    int topicID = spilledCollection.getTopicID(topic);
+    auto writeEdge = [&](int dep, const char *attributes) {
+      auto depTopic = spilledCollection.findTopic(dep);
+      if (!depTopic ||
+          (spilledCollection.getModuleOfTopic(*depTopic) != module) !=
+              crossModule) {
+        return;
       }
+      out << topicID << " -> " << dep << attributes << ";\n";
+    };
+    for (int dep : spilledCollection.dependencies(topic)) {
+      writeEdge(dep, "");
+    }
+    for (int dep : spilledCollection.softDependencies(topic)) {
+      writeEdge(dep, "[style=dotted]");
+    }
+  };
 
-      for (auto dep : topic->softDependencies()) {
-        auto newInstEdge = boost::add_edge(TID, dep, graph);
-        get(edge_attribute, graph)[newInstEdge.first]["style"] = "dotted";
+  out << "digraph main {\n"
+      << "graph [\npack=true];\n";
+  std::map<int, std::vector<int>> moduleRanks;
+  for (size_t module = 0; module < spilledCollection.numModules(); ++module) {
+    std::string moduleName(spilledCollection.getModuleName(module));
+    out << "subgraph " << escapeDotString("cluster_" + moduleName) << " {\n"
+        << "graph [\nlabel=" << escapeDotString(moduleName) << "];\n"
+        << "node [\nshape=Mrecord];\n";
+    forEachTopic(module, [&](size_t topic) {
+      int topicID = spilledCollection.getTopicID(topic);
+      out << topicID << "[label="
+          << escapeDotString(spilledCollection.getTopicName(topic)) << "];\n";
+      if (layoutOptions.rankSame) {
+        moduleRanks[getLayer(topicID)].push_back(topicID);
+      }
+    });
+    for (auto &[layer, topicIDs] : moduleRanks) {
+      if (topicIDs.size() < 2) {
+        continue;
+      }
+      out << "{rank=same;";
+      for (int topicID : topicIDs) {
+        out << " " << topicID << ";";
       }
+      out << "}\n";
     }
+    moduleRanks.clear();
+
+    forEachTopic(module, [&](size_t topic) { writeEdges(module, topic, false); });
+    out << "}\n";
+    spilledCollection.releaseModule(module);
   }
 
-  std::cout << "Storing graph into " << outputFilename << "\n";
-  std::ofstream outputFile(outputFilename);
-  write_graphviz(outputFile, graph);
+  for (size_t module = 0; module < spilledCollection.numModules(); ++module) {
+    forEachTopic(module, [&](size_t topic) { writeEdges(module, topic, true); });
+    spilledCollection.releaseModule(module);
+  }
+  out << "}\n";
 }
 
-void generateDependencies(const ModuleCollection &moduleCollection,
-                          std::ofstream &out) {
-  for (auto &module : moduleCollection.modules()) {
-    for (auto &topic : module->topics()) {
-      for (auto dep : topic->dependencies()) {
-        Module *depModule = moduleCollection.getModuleFromTopicID(dep);
-        if (depModule) {
-          out << module->getModuleID() << ":" << topic->getID() << " -> "
-              << depModule->getModuleID() << ":" << dep << ";\n";
-        }
-      }
-
-      for (auto dep : topic->softDependencies()) {
-        Module *depModule = moduleCollection.getModuleFromTopicID(dep);
-        if (depModule) {
-          out << module->getModuleID() << ":" << topic->getID() << " -> "
-              << depModule->getModuleID() << ":" << dep << "[style=\""
-              << "dotted"
-              << "\"]"
-              << ";\n";
-        }
-      }
-    }
+void emitFullDotGraph(const SpilledCollection &spilledCollection,
+                      std::filesystem::path outputFilename,
+                      const DotLayoutOptions &layoutOptions) {
+  if (outputFilename.extension() != ".dot" &&
+      outputFilename.extension() != ".gv" &&
+      !isStandardOutput(outputFilename)) {
+    std::cerr
+        << "Warning: Output filename does not have a graphviz extension!\n";
   }
+
+  reportOutput("graph", outputFilename);
+  OutputSink outputFile(outputFilename);
+  writeSpilledDotGraph(spilledCollection, outputFile, layoutOptions);
+  outputFile.finish(outputFilename);
 }
 
 void emitHTMLDotGraph(const ModuleCollection &moduleCollection,
                       std::filesystem::path outputFilename,
-                      bool includeDependecies) {
-  std::cout << "Storing graph into " << outputFilename << "\n";
-  std::ofstream outputFile(outputFilename);
-  outputFile << "digraph main {\n";
+                      bool includeDependecies, const DotStyleSheet *style) {
+  reportOutput("graph", outputFilename);
+  OutputSink outputFile(outputFilename);
+  HTMLDotGraphEmitter htmlDotEmitter(outputFile, includeDependecies, style);
+  traverseModuleCollection(moduleCollection, htmlDotEmitter);
+  outputFile.finish(outputFilename);
+}
 
-  for (auto &module : moduleCollection.modules()) {
-    outputFile << module->getModuleID() << "[shape=box"
-               << ", label=<" << generateDotHTMLTable(*(module.get()))
-               << ">];\n";
+void emitSVGGraph(const ModuleCollection &moduleCollection,
+                  std::filesystem::path outputFilename) {
+  if (outputFilename.extension() != ".svg" &&
+      !isStandardOutput(outputFilename)) {
+    std::cerr << "Warning: Output filename does not have an svg extension!\n";
   }
 
-  if (includeDependecies) {
-    generateDependencies(moduleCollection, outputFile);
+  reportOutput("graph", outputFilename);
+  OutputSink outputFile(outputFilename);
+  writeSVGGraph(moduleCollection, outputFile);
+  outputFile.finish(outputFilename);
+}
+
+void emitSchedule(const Schedule &schedule,
+                  std::filesystem::path outputFilename) {
+  reportOutput("schedule", outputFilename);
+  OutputSink outputFile(outputFilename);
+  if (outputFilename.extension() == ".html" ||
+      outputFilename.extension() == ".htm") {
+    OutputSinkStream stream(outputFile);
+    stream << generateScheduleHTMLPage(schedule);
+  } else {
+    writeScheduleCSV(schedule, outputFile);
   }
+  outputFile.finish(outputFilename);
+}
 
-  outputFile << "}";
+void emitMetrics(const CollectionMetrics &metrics,
+                 std::filesystem::path outputFilename) {
+  reportOutput("metrics", outputFilename);
+  OutputSink outputFile(outputFilename);
+  if (outputFilename.extension() == ".json") {
+    writeMetricsJSON(metrics, outputFile);
+  } else {
+    writeMetricsReport(metrics, outputFile);
+  }
+  outputFile.finish(outputFilename);
+}
+
+//===----------------------------------------------------------------------===//
+// Multi output generation
+
+std::optional<OutputKind> parseOutputKind(std::string_view kindName) {
+  if (kindName == "dot") {
+    return OutputKind::FullDot;
+  }
+  if (kindName == "htmldot") {
+    return OutputKind::HTMLDot;
+  }
+  if (kindName == "htmldot-deps") {
+    return OutputKind::HTMLDotWithDeps;
+  }
+  if (kindName == "html") {
+    return OutputKind::HTMLTable;
+  }
+  if (kindName == "yaml") {
+    return OutputKind::YAML;
+  }
+  if (kindName == "json") {
+    return OutputKind::JSON;
+  }
+  if (kindName == "msgpack") {
+    return OutputKind::MsgPack;
+  }
+  if (kindName == "svg") {
+    return OutputKind::SVG;
+  }
+  if (kindName == "explorer") {
+    return OutputKind::HTMLExplorer;
+  }
+  return std::nullopt;
+}
+
+std::optional<OutputTarget> parseOutputTarget(std::string_view spec) {
+  auto sep = spec.find('=');
+  if (sep == std::string_view::npos || sep + 1 == spec.size()) {
+    return std::nullopt;
+  }
+
+  auto kind = parseOutputKind(spec.substr(0, sep));
+  if (!kind) {
+    return std::nullopt;
+  }
+  return OutputTarget{*kind, std::filesystem::path(spec.substr(sep + 1))};
+}
+
+void writeOutput(const ModuleCollection &moduleCollection, OutputKind kind,
+                 OutputSink &out, const DotLayoutOptions &layoutOptions,
+                 const DotStyleSheet *style) {
+  switch (kind) {
+  case OutputKind::FullDot:
+    writeFullDotGraph(moduleCollection, out, layoutOptions, style);
+    break;
+  case OutputKind::HTMLDot:
+  case OutputKind::HTMLDotWithDeps: {
+    HTMLDotGraphEmitter emitter(out, kind == OutputKind::HTMLDotWithDeps,
+                                style);
+    traverseModuleCollection(moduleCollection, emitter);
+    break;
+  }
+  case OutputKind::HTMLTable: {
+    HTMLTableEmitter emitter;
+    traverseModuleCollection(moduleCollection, emitter);
+    OutputSinkStream stream(out);
+    stream << emitter.takeTable();
+    break;
+  }
+  case OutputKind::YAML: {
+    YAMLEmitter emitter(out);
+    traverseModuleCollection(moduleCollection, emitter);
+    break;
+  }
+  case OutputKind::JSON: {
+    JSONEmitter emitter(out);
+    traverseModuleCollection(moduleCollection, emitter);
+    break;
+  }
+  case OutputKind::MsgPack: {
+    MsgPackEmitter emitter(out);
+    traverseModuleCollection(moduleCollection, emitter);
+    break;
+  }
+  case OutputKind::SVG:
+    writeSVGGraph(moduleCollection, out);
+    break;
+  case OutputKind::HTMLExplorer:
+    writeHTMLExplorer(moduleCollection, out);
+    break;
+  }
+}
+
+static void emitOutput(const ModuleCollection &moduleCollection,
+                       const OutputTarget &target,
+                       const DotLayoutOptions &layoutOptions,
+                       const DotStyleSheet *style) {
+  OutputSink outputFile(target.path);
+  writeOutput(moduleCollection, target.kind, outputFile, layoutOptions, style);
+  outputFile.finish(target.path);
+}
+
+void emitOutputs(const ModuleCollection &moduleCollection,
+                 const std::vector<OutputTarget> &targets,
+                 const DotLayoutOptions &layoutOptions,
+                 const DotStyleSheet *style) {
+  // Lazy loading is not synchronized between the writer threads.
+  moduleCollection.loadAllModules();
+  for (auto &target : targets) {
+    reportOutput("output", target.path);
+  }
+
+  // Errors are rethrown once all writers are done, the first one wins.
+  std::vector<std::exception_ptr> errors(targets.size());
+  std::vector<std::thread> writers;
+  writers.reserve(targets.size());
+  for (size_t index = 0; index < targets.size(); ++index) {
+    writers.emplace_back([&moduleCollection, &targets, &layoutOptions, style,
+                          &errors, index]() {
+      try {
+        emitOutput(moduleCollection, targets[index], layoutOptions, style);
+      } catch (std::runtime_error &) {
+        errors[index] = std::current_exception();
+      }
+    });
+  }
+  for (auto &writer : writers) {
+    writer.join();
+  }
+  for (auto &error : errors) {
+    if (error) {
+      std::rethrow_exception(error);
+    }
+  }
 }
 
 } // namespace sg20
@@ -1,6 +1,14 @@
+#include "sg20_graphgen/dot_style.h"
 #include "sg20_graphgen/graph_generator.h"
+#include "sg20_graphgen/history.h"
 #include "sg20_graphgen/html_generator.h"
+#include "sg20_graphgen/metrics.h"
 #include "sg20_graphgen/modules.h"
+#include "sg20_graphgen/output_sink.h"
+#include "sg20_graphgen/schedule.h"
+#include "sg20_graphgen/serialization.h"
+#include "sg20_graphgen/spilled_collection.h"
+#include "sg20_graphgen/validator.h"
 
 #include "yaml-cpp/exceptions.h"
 
@@ -11,14 +19,65 @@
 
 #include <filesystem>
 #include <iostream>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <vector>
 
 ABSL_FLAG(std::string, graph_yaml, "sg20_graph.yaml",
           "path to the yaml specification file.");
-ABSL_FLAG(std::string, output, "sg20_graph.dot",
-          "filename for the generated dot file.");
+ABSL_FLAG(std::string, output, "",
+          "filename for the generated output, - for the standard output. "
+          "Defaults to sg20_graph.dot, sg20_graph.svg with --format svg, "
+          "sg20_schedule.csv with --schedule, and the standard output with "
+          "--stats.");
 ABSL_FLAG(bool, useHTMLDotGraph, false, "Generate an HTML Dot graph instead.");
 ABSL_FLAG(bool, includeDependencies, false,
           "Generate an HTML Dot graph with dependencies.");
+ABSL_FLAG(std::vector<std::string>, emit, {},
+          "Comma separated list of KIND=PATH outputs to generate in one run, "
+          "where KIND is one of dot, htmldot, htmldot-deps, html, yaml, json, "
+          "msgpack, svg, explorer. Cannot be combined with --output or the "
+          "other outputs.");
+ABSL_FLAG(bool, layoutOrder, false,
+          "Emit the full dot graph in topological and barycenter order instead "
+          "of the yaml order, which gives dot fewer crossings to resolve.");
+ABSL_FLAG(bool, rankSame, false,
+          "Place topics of a module on the same topological layer on the same "
+          "rank in the full dot graph.");
+ABSL_FLAG(std::string, format, "dot",
+          "Format of the full graph: dot, or svg to lay out the graph with the "
+          "built-in layout engine instead of graphviz.");
+ABSL_FLAG(std::string, style, "",
+          "Yaml file with style rules for the attributes of the modules, "
+          "topics, and dependencies in the dot graphs.");
+ABSL_FLAG(int, schedule, 0,
+          "Plan a teaching schedule with the given number of parallel tracks "
+          "instead of generating a graph. Written as CSV, or as HTML if the "
+          "output ends in .html.");
+ABSL_FLAG(int, moduleCapacity, 0,
+          "Maximum number of topics of one module per slot of the schedule, "
+          "0 for no limit.");
+ABSL_FLAG(bool, stats, false,
+          "Report metrics of the dependencies between modules instead of "
+          "generating a graph: fan-in and fan-out, cross-module dependencies, "
+          "module cycles, chain lengths, and degree distributions. Printed to "
+          "the standard output, or written as JSON if the output ends in "
+          ".json.");
+ABSL_FLAG(std::string, history, "",
+          "History file that stores the revisions of the yaml file, see "
+          "--record and --at.");
+ABSL_FLAG(bool, record, false,
+          "Append the yaml file to the --history file as a new revision if it "
+          "changed since the last one.");
+ABSL_FLAG(int, at, -1,
+          "Generate the outputs for this revision of the --history file "
+          "instead of the yaml file.");
+ABSL_FLAG(int, memoryLimit, 0,
+          "Generate the full dot graph from a yaml file that does not fit into "
+          "memory, keeping the memory use below this many MB. The collection "
+          "is spilled to temporary files in TMPDIR. 0 loads the collection "
+          "into memory.");
 
 int main(int argc, char *argv[]) {
   absl::SetProgramUsageMessage(
@@ -27,26 +86,241 @@ int main(int argc, char *argv[]) {
   absl::ParseCommandLine(argc, argv);
 
   auto yamlInputFile = std::filesystem::path(absl::GetFlag(FLAGS_graph_yaml));
-  if (!std::filesystem::exists(yamlInputFile)) {
+  auto historyFile = absl::GetFlag(FLAGS_history);
+  int revision = absl::GetFlag(FLAGS_at);
+  if (historyFile.empty() && (revision >= 0 || absl::GetFlag(FLAGS_record))) {
+    std::cerr << "--at and --record need a --history file.\n";
+    return 1;
+  }
+  if (revision >= 0 && absl::GetFlag(FLAGS_record)) {
+    std::cerr << "--at cannot be combined with --record.\n";
+    return 1;
+  }
+  if (revision < 0 && !std::filesystem::exists(yamlInputFile)) {
     std::cerr << "Yaml input file does not exist."
               << "\n";
     return 1;
   }
 
+  auto format = absl::GetFlag(FLAGS_format);
+  if (format != "dot" && format != "svg") {
+    std::cerr << "Unknown format \"" << format << "\", expected dot or svg.\n";
+    return 1;
+  }
+
+  int memoryLimit = absl::GetFlag(FLAGS_memoryLimit);
+  if (memoryLimit < 0) {
+    std::cerr << "--memoryLimit must not be negative.\n";
+    return 1;
+  }
+  if (memoryLimit > 0 &&
+      (!historyFile.empty() || !absl::GetFlag(FLAGS_emit).empty() ||
+       absl::GetFlag(FLAGS_schedule) > 0 || absl::GetFlag(FLAGS_stats) ||
+       format != "dot" || absl::GetFlag(FLAGS_useHTMLDotGraph) ||
+       !absl::GetFlag(FLAGS_style).empty())) {
+    std::cerr << "--memoryLimit only generates the full dot graph, it cannot "
+                 "be combined with --emit, --schedule, --stats, --format, "
+                 "--useHTMLDotGraph, --style, or --history.\n";
+    return 1;
+  }
+  if (memoryLimit > 0 && (yamlInputFile.extension() == ".json" ||
+                          yamlInputFile.extension() == ".msgpack" ||
+                          yamlInputFile.extension() == ".mpk")) {
+    std::cerr << "--memoryLimit needs a yaml input file.\n";
+    return 1;
+  }
+
+  // Every run generates one kind of output, the flags of the other kinds
+  // would be ignored.
+  bool emitMode = !absl::GetFlag(FLAGS_emit).empty();
+  bool statsMode = absl::GetFlag(FLAGS_stats);
+  bool scheduleMode = absl::GetFlag(FLAGS_schedule) > 0;
+  bool svgMode = format == "svg";
+  bool htmlDotMode = absl::GetFlag(FLAGS_useHTMLDotGraph);
+  bool fullDotMode =
+      !emitMode && !statsMode && !scheduleMode && !svgMode && !htmlDotMode;
+  if (emitMode + statsMode + scheduleMode + svgMode + htmlDotMode > 1) {
+    std::cerr << "--emit, --stats, --schedule, --format svg, and "
+                 "--useHTMLDotGraph generate different outputs, only one of "
+                 "them can be used.\n";
+    return 1;
+  }
+  std::string output = absl::GetFlag(FLAGS_output);
+  if (emitMode && !output.empty()) {
+    std::cerr << "--emit names its own output files, it cannot be combined "
+                 "with --output.\n";
+    return 1;
+  }
+  if ((absl::GetFlag(FLAGS_layoutOrder) || absl::GetFlag(FLAGS_rankSame)) &&
+      !fullDotMode && !emitMode) {
+    std::cerr << "--layoutOrder and --rankSame only apply to the full dot "
+                 "graph and --emit.\n";
+    return 1;
+  }
+  if (!absl::GetFlag(FLAGS_style).empty() &&
+      (statsMode || scheduleMode || svgMode)) {
+    std::cerr << "--style only applies to the dot graphs and --emit.\n";
+    return 1;
+  }
+  if (absl::GetFlag(FLAGS_includeDependencies) && !htmlDotMode) {
+    std::cerr << "--includeDependencies needs --useHTMLDotGraph.\n";
+    return 1;
+  }
+  if (absl::GetFlag(FLAGS_moduleCapacity) != 0 && !scheduleMode) {
+    std::cerr << "--moduleCapacity needs --schedule.\n";
+    return 1;
+  }
+  if (output.empty()) {
+    output = statsMode      ? "-"
+             : scheduleMode ? "sg20_schedule.csv"
+             : svgMode      ? "sg20_graph.svg"
+                            : "sg20_graph.dot";
+  }
+  std::filesystem::path outputFilename(output);
+
   try {
-    auto MC = sg20::ModuleCollection::loadModulesFromFile(yamlInputFile);
+    if (memoryLimit > 0) {
+      sg20::SpillOptions spillOptions;
+      spillOptions.memoryLimit = static_cast<size_t>(memoryLimit) << 20;
+      std::optional<sg20::SpilledCollection> spilled;
+      try {
+        spilled = sg20::SpilledCollection::loadFromYAMLFile(yamlInputFile,
+                                                            spillOptions);
+      } catch (std::runtime_error &e) {
+        std::cerr << "Could not spill " << yamlInputFile << " to disk"
+                  << std::endl;
+        std::cerr << "Got: " << e.what() << std::endl;
+        return 1;
+      }
+
+      for (auto &issue : spilled->validate()) {
+        std::cerr << "Warning: ";
+        issue.dump(std::cerr);
+      }
+
+      sg20::DotLayoutOptions layoutOptions;
+      layoutOptions.layoutOrder = absl::GetFlag(FLAGS_layoutOrder);
+      layoutOptions.rankSame = absl::GetFlag(FLAGS_rankSame);
+      sg20::emitFullDotGraph(*spilled, outputFilename, layoutOptions);
+      return 0;
+    }
+
+    std::optional<sg20::HistoryStore> history;
+    if (!historyFile.empty()) {
+      try {
+        history.emplace(historyFile);
+      } catch (std::runtime_error &e) {
+        std::cerr << "Could not open history file " << historyFile << std::endl;
+        std::cerr << "Got: " << e.what() << std::endl;
+        return 1;
+      }
+    }
+
+    sg20::ModuleCollection MC;
+    if (revision >= 0) {
+      if (static_cast<size_t>(revision) >= history->numRevisions()) {
+        std::cerr << "History file " << historyFile << " has "
+                  << history->numRevisions() << " revisions, no revision "
+                  << revision << "\n";
+        return 1;
+      }
+      try {
+        MC = history->loadRevision(revision);
+      } catch (std::runtime_error &e) {
+        std::cerr << "Could not read revision " << revision << " from "
+                  << historyFile << std::endl;
+        std::cerr << "Got: " << e.what() << std::endl;
+        return 1;
+      }
+    } else {
+      MC = sg20::ModuleCollection::loadModulesFromFile(yamlInputFile);
+    }
+
+    if (absl::GetFlag(FLAGS_record)) {
+      try {
+        size_t numRevisions = history->numRevisions();
+        size_t recorded = history->appendRevision(MC);
+        // Keep the standard output clean for outputs written to it.
+        std::ostream &report =
+            sg20::isStandardOutput(outputFilename) ? std::cerr : std::cout;
+        if (history->numRevisions() == numRevisions) {
+          report << "No changes since revision " << recorded << "\n";
+        } else {
+          report << "Recorded revision " << recorded << " in " << historyFile
+                 << "\n";
+        }
+      } catch (std::runtime_error &e) {
+        std::cerr << "Could not record the revision in " << historyFile
+                  << std::endl;
+        std::cerr << "Got: " << e.what() << std::endl;
+        return 1;
+      }
+    }
+
+    for (auto &issue : sg20::validateModuleCollection(MC)) {
+      std::cerr << "Warning: ";
+      issue.dump(std::cerr);
+    }
 
-    if (absl::GetFlag(FLAGS_useHTMLDotGraph)) {
-      sg20::emitHTMLDotGraph(MC,
-                             std::filesystem::path(absl::GetFlag(FLAGS_output)),
-                             absl::GetFlag(FLAGS_includeDependencies));
+    sg20::DotLayoutOptions layoutOptions;
+    layoutOptions.layoutOrder = absl::GetFlag(FLAGS_layoutOrder);
+    layoutOptions.rankSame = absl::GetFlag(FLAGS_rankSame);
+
+    std::optional<sg20::DotStyleSheet> styleSheet;
+    if (auto styleFile = absl::GetFlag(FLAGS_style); !styleFile.empty()) {
+      try {
+        styleSheet = sg20::DotStyleSheet::loadFromFile(styleFile, MC);
+      } catch (std::runtime_error &e) {
+        std::cerr << "Could not load style file " << styleFile << std::endl;
+        std::cerr << "Got: " << e.what() << std::endl;
+        return 1;
+      }
+    }
+    const sg20::DotStyleSheet *style = styleSheet ? &*styleSheet : nullptr;
+
+    auto emitSpecs = absl::GetFlag(FLAGS_emit);
+    if (emitMode) {
+      std::vector<sg20::OutputTarget> targets;
+      for (auto &spec : emitSpecs) {
+        auto target = sg20::parseOutputTarget(spec);
+        if (!target) {
+          std::cerr << "Could not parse output target \"" << spec << "\"\n";
+          return 1;
+        }
+        targets.push_back(*target);
+      }
+      sg20::emitOutputs(MC, targets, layoutOptions, style);
+    } else if (statsMode) {
+      sg20::emitMetrics(sg20::computeMetrics(MC), outputFilename);
+    } else if (scheduleMode) {
+      sg20::ScheduleOptions scheduleOptions;
+      scheduleOptions.tracks = absl::GetFlag(FLAGS_schedule);
+      scheduleOptions.moduleCapacity = absl::GetFlag(FLAGS_moduleCapacity);
+      auto schedule = sg20::computeSchedule(MC, scheduleOptions);
+      // Keep the standard output clean if the schedule is written to it.
+      std::ostream &report =
+          sg20::isStandardOutput(outputFilename) ? std::cerr : std::cout;
+      report << "Critical path: " << schedule.criticalPathLength
+             << " slots, schedule: " << schedule.numSlots << " slots on "
+             << schedule.numTracks << " tracks\n";
+      sg20::emitSchedule(schedule, outputFilename);
+    } else if (svgMode) {
+      sg20::emitSVGGraph(MC, outputFilename);
+    } else if (htmlDotMode) {
+      sg20::emitHTMLDotGraph(MC, outputFilename,
+                             absl::GetFlag(FLAGS_includeDependencies), style);
     } else {
-      sg20::emitFullDotGraph(
-          MC, std::filesystem::path(absl::GetFlag(FLAGS_output)));
+      sg20::emitFullDotGraph(MC, outputFilename, layoutOptions, style);
     }
   } catch (YAML::Exception &e) {
     std::cerr << "Syntax error in YAML " << yamlInputFile << std::endl;
     std::cerr << "Got: " << e.what() << std::endl;
+  } catch (sg20::ParseError &e) {
+    std::cerr << "Syntax error in " << yamlInputFile << std::endl;
+    std::cerr << "Got: " << e.what() << std::endl;
+  } catch (std::runtime_error &e) {
+    std::cerr << "Error: " << e.what() << std::endl;
+    return 1;
   }
 
   return 0;
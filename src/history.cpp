@@ -0,0 +1,680 @@
+#include "sg20_graphgen/history.h"
+#include "sg20_graphgen/serialization.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace sg20 {
+
+static constexpr std::string_view HistoryMagic = "SG20HIS\x01";
+// Length, kind, and checksum of a record.
+static constexpr size_t RecordHeaderSize = 9;
+
+[[noreturn]] static void reportCorruption(std::string_view msg,
+                                          size_t revision) {
+  throw ParseError("History: " + std::string(msg) + " (revision " +
+                   std::to_string(revision) + ")");
+}
+
+namespace {
+
+//===----------------------------------------------------------------------===//
+// Revision state
+
+// Plain copy of a revision that changes are computed against and applied to.
+// Modules and topics are keyed by their IDs, so a revision with duplicate IDs
+// cannot be represented.
+struct RevisionState {
+  struct ModuleState {
+    std::string name;
+    std::vector<int> topics;
+  };
+  struct TopicState {
+    std::string name;
+    // Sorted, like the dependency sets of topics.
+    std::vector<int> deps;
+    std::vector<int> softDeps;
+
+    bool operator==(const TopicState &other) const {
+      return name == other.name && deps == other.deps &&
+             softDeps == other.softDeps;
+    }
+  };
+
+  std::vector<int> moduleOrder;
+  std::unordered_map<int, ModuleState> modules;
+  std::unordered_map<int, TopicState> topics;
+};
+
+RevisionState captureState(const ModuleCollection &moduleCollection) {
+  RevisionState state;
+  for (auto &module : moduleCollection.modules()) {
+    int moduleID = module->getModuleID();
+    auto [moduleIt, inserted] = state.modules.try_emplace(moduleID);
+    if (!inserted) {
+      throw std::runtime_error("Module ID " + std::to_string(moduleID) +
+                               " is used more than once");
+    }
+    auto &moduleState = moduleIt->second;
+    state.moduleOrder.push_back(moduleID);
+    moduleState.name = module->getModuleName();
+
+    for (auto &topic : module->topics()) {
+      auto [it, isNewTopic] = state.topics.try_emplace(topic->getID());
+      if (!isNewTopic) {
+        throw std::runtime_error("Topic ID " + std::to_string(topic->getID()) +
+                                 " is used more than once");
+      }
+      moduleState.topics.push_back(topic->getID());
+      it->second.name = topic->getName();
+      it->second.deps.assign(topic->deps_begin(), topic->deps_end());
+      it->second.softDeps.assign(topic->soft_begin(), topic->soft_end());
+    }
+  }
+  return state;
+}
+
+//===----------------------------------------------------------------------===//
+// Change encoding
+
+// New modules are stored with SetModule, changes of existing ones with
+// ModuleName and ModuleTopics, which stores the edits of the topic list, so
+// moving a topic does not store the topic lists of both modules again.
+enum class ChangeOp : uint8_t {
+  SetModule = 1,
+  RemoveModule = 2,
+  SetTopic = 3,
+  RemoveTopic = 4,
+  ModuleOrder = 5,
+  ModuleName = 6,
+  ModuleTopics = 7,
+};
+
+// Writes the changes as LEB128 varints. IDs are zigzag encoded, sorted
+// dependency lists as the differences between consecutive IDs.
+class ChangeWriter {
+public:
+  void writeOp(ChangeOp op) { out.push_back(static_cast<char>(op)); }
+
+  void writeUnsigned(uint64_t value) {
+    while (value >= 0x80) {
+      out.push_back(static_cast<char>((value & 0x7f) | 0x80));
+      value >>= 7;
+    }
+    out.push_back(static_cast<char>(value));
+  }
+
+  void writeID(int ID) {
+    int64_t value = ID;
+    writeUnsigned((static_cast<uint64_t>(value) << 1) ^
+                  static_cast<uint64_t>(value >> 63));
+  }
+
+  void writeString(std::string_view str) {
+    writeUnsigned(str.size());
+    out.append(str);
+  }
+
+  void writeIDs(const std::vector<int> &IDs) {
+    writeUnsigned(IDs.size());
+    for (int ID : IDs) {
+      writeID(ID);
+    }
+  }
+
+  void writeSortedIDs(const std::vector<int> &IDs) {
+    writeUnsigned(IDs.size());
+    if (IDs.empty()) {
+      return;
+    }
+    writeID(IDs.front());
+    for (size_t index = 1; index < IDs.size(); ++index) {
+      writeUnsigned(static_cast<int64_t>(IDs[index]) - IDs[index - 1]);
+    }
+  }
+
+  std::string take() { return std::move(out); }
+
+private:
+  std::string out;
+};
+
+class ChangeReader {
+public:
+  ChangeReader(std::string_view input, size_t revision)
+      : input(input), revision(revision) {}
+
+  bool atEnd() const { return pos == input.size(); }
+
+  ChangeOp readOp() {
+    need(1);
+    return static_cast<ChangeOp>(input[pos++]);
+  }
+
+  uint64_t readUnsigned() {
+    uint64_t value = 0;
+    for (unsigned shift = 0; shift < 64; shift += 7) {
+      need(1);
+      auto byte = static_cast<uint8_t>(input[pos++]);
+      value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+      if (!(byte & 0x80)) {
+        return value;
+      }
+    }
+    error("varint is too long");
+  }
+
+  int readID() {
+    uint64_t value = readUnsigned();
+    return toID(static_cast<int64_t>(value >> 1) ^
+                -static_cast<int64_t>(value & 1));
+  }
+
+  std::string readString() {
+    uint64_t size = readUnsigned();
+    need(size);
+    std::string str(input.substr(pos, size));
+    pos += size;
+    return str;
+  }
+
+  std::vector<int> readIDs() {
+    std::vector<int> IDs(readCount());
+    for (int &ID : IDs) {
+      ID = readID();
+    }
+    return IDs;
+  }
+
+  std::vector<int> readSortedIDs() {
+    std::vector<int> IDs(readCount());
+    if (IDs.empty()) {
+      return IDs;
+    }
+    IDs.front() = readID();
+    for (size_t index = 1; index < IDs.size(); ++index) {
+      uint64_t difference = readUnsigned();
+      if (difference > UINT32_MAX) {
+        error("ID out of range");
+      }
+      IDs[index] = toID(IDs[index - 1] + static_cast<int64_t>(difference));
+    }
+    return IDs;
+  }
+
+  [[noreturn]] void error(std::string_view msg) const {
+    reportCorruption(msg, revision);
+  }
+
+private:
+  void need(uint64_t bytes) const {
+    if (input.size() - pos < bytes) {
+      error("unexpected end of the record");
+    }
+  }
+
+  // Every element takes at least one byte, which bounds the allocation for
+  // corrupted counts.
+  size_t readCount() {
+    uint64_t count = readUnsigned();
+    need(count);
+    return count;
+  }
+
+  int toID(int64_t value) const {
+    if (value < INT32_MIN || value > INT32_MAX) {
+      error("ID out of range");
+    }
+    return static_cast<int>(value);
+  }
+
+  std::string_view input;
+  size_t pos = 0;
+  size_t revision;
+};
+
+// Writes the edits that turn the previous into the current topic list of a
+// module, as hunks of kept, removed, and inserted topics. Topic IDs are
+// unique, so the kept topics are the longest increasing subsequence of the
+// previous positions of the current topics.
+void writeTopicEdits(ChangeWriter &writer, const std::vector<int> &previous,
+                     const std::vector<int> &current) {
+  std::unordered_map<int, size_t> previousPositions;
+  previousPositions.reserve(previous.size());
+  for (size_t index = 0; index < previous.size(); ++index) {
+    previousPositions.emplace(previous[index], index);
+  }
+
+  // Patience sorting: tails[length - 1] is the index into current of the
+  // smallest end of an increasing subsequence of that length.
+  std::vector<size_t> tails;
+  std::vector<size_t> predecessors(current.size(), SIZE_MAX);
+  std::vector<size_t> positions(current.size(), SIZE_MAX);
+  for (size_t index = 0; index < current.size(); ++index) {
+    auto position = previousPositions.find(current[index]);
+    if (position == previousPositions.end()) {
+      continue;
+    }
+    positions[index] = position->second;
+    auto tail = std::lower_bound(tails.begin(), tails.end(), position->second,
+                                 [&positions](size_t lhs, size_t value) {
+                                   return positions[lhs] < value;
+                                 });
+    if (tail != tails.begin()) {
+      predecessors[index] = *(tail - 1);
+    }
+    if (tail == tails.end()) {
+      tails.push_back(index);
+    } else {
+      *tail = index;
+    }
+  }
+  std::vector<bool> keptPrevious(previous.size());
+  std::vector<bool> keptCurrent(current.size());
+  for (size_t index = tails.empty() ? SIZE_MAX : tails.back();
+       index != SIZE_MAX; index = predecessors[index]) {
+    keptCurrent[index] = true;
+    keptPrevious[positions[index]] = true;
+  }
+
+  struct Hunk {
+    size_t keep = 0;
+    size_t remove = 0;
+    std::vector<int> inserted;
+  };
+  std::vector<Hunk> hunks;
+  size_t previousIndex = 0;
+  size_t currentIndex = 0;
+  while (true) {
+    Hunk hunk;
+    while (previousIndex < previous.size() && currentIndex < current.size() &&
+           keptPrevious[previousIndex] && keptCurrent[currentIndex]) {
+      ++hunk.keep;
+      ++previousIndex;
+      ++currentIndex;
+    }
+    while (previousIndex < previous.size() && !keptPrevious[previousIndex]) {
+      ++hunk.remove;
+      ++previousIndex;
+    }
+    while (currentIndex < current.size() && !keptCurrent[currentIndex]) {
+      hunk.inserted.push_back(current[currentIndex++]);
+    }
+    // The kept topics after the last hunk are implied.
+    if (hunk.remove == 0 && hunk.inserted.empty()) {
+      break;
+    }
+    hunks.push_back(std::move(hunk));
+  }
+
+  writer.writeUnsigned(hunks.size());
+  for (auto &hunk : hunks) {
+    writer.writeUnsigned(hunk.keep);
+    writer.writeUnsigned(hunk.remove);
+    writer.writeIDs(hunk.inserted);
+  }
+}
+
+void readTopicEdits(ChangeReader &reader, std::vector<int> &topics) {
+  std::vector<int> edited;
+  size_t position = 0;
+  for (uint64_t hunks = reader.readUnsigned(); hunks > 0; --hunks) {
+    uint64_t keep = reader.readUnsigned();
+    uint64_t remove = reader.readUnsigned();
+    if (topics.size() - position < keep ||
+        topics.size() - position - keep < remove) {
+      reader.error("topic edit is out of range");
+    }
+    edited.insert(edited.end(), topics.begin() + position,
+                  topics.begin() + position + keep);
+    position += keep + remove;
+    std::vector<int> inserted = reader.readIDs();
+    edited.insert(edited.end(), inserted.begin(), inserted.end());
+  }
+  edited.insert(edited.end(), topics.begin() + position, topics.end());
+  topics = std::move(edited);
+}
+
+// Encodes the changes that turn the previous into the current revision. The
+// changes are empty if both revisions are equal.
+std::string encodeChanges(const RevisionState &previous,
+                          const RevisionState &current) {
+  ChangeWriter writer;
+
+  for (int moduleID : previous.moduleOrder) {
+    for (int topicID : previous.modules.at(moduleID).topics) {
+      if (!current.topics.count(topicID)) {
+        writer.writeOp(ChangeOp::RemoveTopic);
+        writer.writeID(topicID);
+      }
+    }
+    if (!current.modules.count(moduleID)) {
+      writer.writeOp(ChangeOp::RemoveModule);
+      writer.writeID(moduleID);
+    }
+  }
+
+  for (int moduleID : current.moduleOrder) {
+    auto &module = current.modules.at(moduleID);
+    auto previousModule = previous.modules.find(moduleID);
+    if (previousModule == previous.modules.end()) {
+      writer.writeOp(ChangeOp::SetModule);
+      writer.writeID(moduleID);
+      writer.writeString(module.name);
+      writer.writeIDs(module.topics);
+    } else {
+      if (previousModule->second.name != module.name) {
+        writer.writeOp(ChangeOp::ModuleName);
+        writer.writeID(moduleID);
+        writer.writeString(module.name);
+      }
+      if (previousModule->second.topics != module.topics) {
+        writer.writeOp(ChangeOp::ModuleTopics);
+        writer.writeID(moduleID);
+        writeTopicEdits(writer, previousModule->second.topics, module.topics);
+      }
+    }
+
+    for (int topicID : module.topics) {
+      auto &topic = current.topics.at(topicID);
+      auto previousTopic = previous.topics.find(topicID);
+      if (previousTopic == previous.topics.end() ||
+          !(previousTopic->second == topic)) {
+        writer.writeOp(ChangeOp::SetTopic);
+        writer.writeID(topicID);
+        writer.writeString(topic.name);
+        writer.writeSortedIDs(topic.deps);
+        writer.writeSortedIDs(topic.softDeps);
+      }
+    }
+  }
+
+  if (previous.moduleOrder != current.moduleOrder) {
+    writer.writeOp(ChangeOp::ModuleOrder);
+    writer.writeIDs(current.moduleOrder);
+  }
+  return writer.take();
+}
+
+RevisionState::ModuleState &findModule(RevisionState &state,
+                                       ChangeReader &reader) {
+  auto module = state.modules.find(reader.readID());
+  if (module == state.modules.end()) {
+    reader.error("changed module does not exist");
+  }
+  return module->second;
+}
+
+void applyChanges(RevisionState &state, std::string_view changes,
+                  size_t revision) {
+  ChangeReader reader(changes, revision);
+  while (!reader.atEnd()) {
+    switch (reader.readOp()) {
+    case ChangeOp::SetModule: {
+      auto &module = state.modules[reader.readID()];
+      module.name = reader.readString();
+      module.topics = reader.readIDs();
+      break;
+    }
+    case ChangeOp::RemoveModule:
+      if (!state.modules.erase(reader.readID())) {
+        reader.error("removed module does not exist");
+      }
+      break;
+    case ChangeOp::SetTopic: {
+      auto &topic = state.topics[reader.readID()];
+      topic.name = reader.readString();
+      topic.deps = reader.readSortedIDs();
+      topic.softDeps = reader.readSortedIDs();
+      break;
+    }
+    case ChangeOp::RemoveTopic:
+      if (!state.topics.erase(reader.readID())) {
+        reader.error("removed topic does not exist");
+      }
+      break;
+    case ChangeOp::ModuleOrder:
+      state.moduleOrder = reader.readIDs();
+      break;
+    case ChangeOp::ModuleName: {
+      auto &module = findModule(state, reader);
+      module.name = reader.readString();
+      break;
+    }
+    case ChangeOp::ModuleTopics:
+      readTopicEdits(reader, findModule(state, reader).topics);
+      break;
+    default:
+      reader.error("unknown change");
+    }
+  }
+}
+
+// Checks that all modules and topics of the revision were stored.
+void checkState(const RevisionState &state, size_t revision) {
+  for (int moduleID : state.moduleOrder) {
+    auto module = state.modules.find(moduleID);
+    if (module == state.modules.end()) {
+      reportCorruption("module order names a missing module", revision);
+    }
+    for (int topicID : module->second.topics) {
+      if (!state.topics.count(topicID)) {
+        reportCorruption("module names a missing topic", revision);
+      }
+    }
+  }
+}
+
+ModuleCollection buildCollection(const RevisionState &state) {
+  ModuleCollection::Builder builder;
+  for (int moduleID : state.moduleOrder) {
+    auto &moduleState = state.modules.at(moduleID);
+    Module &module = builder.addModule(moduleState.name, moduleID);
+
+    for (int topicID : moduleState.topics) {
+      auto &topicState = state.topics.at(topicID);
+      Topic &topic = builder.addTopic(module, topicState.name, topicID);
+      for (int dep : topicState.deps) {
+        builder.addDependency(topic, dep, DependencyKind::Hard);
+      }
+      for (int dep : topicState.softDeps) {
+        builder.addDependency(topic, dep, DependencyKind::Soft);
+      }
+    }
+  }
+  return builder.finish();
+}
+
+//===----------------------------------------------------------------------===//
+// Record encoding
+
+uint32_t computeChecksum(std::string_view data) {
+  // FNV-1a
+  uint32_t hash = 2166136261u;
+  for (char c : data) {
+    hash = (hash ^ static_cast<uint8_t>(c)) * 16777619u;
+  }
+  return hash;
+}
+
+void writeUInt32(std::string &out, uint32_t value) {
+  for (int shift = 0; shift < 32; shift += 8) {
+    out.push_back(static_cast<char>(value >> shift));
+  }
+}
+
+uint32_t readUInt32(const char *data) {
+  uint32_t value = 0;
+  for (int index = 0; index < 4; ++index) {
+    value |= static_cast<uint32_t>(static_cast<uint8_t>(data[index]))
+             << (8 * index);
+  }
+  return value;
+}
+
+} // namespace
+
+//===----------------------------------------------------------------------===//
+// HistoryStore
+
+HistoryStore::HistoryStore(std::filesystem::path filepath,
+                           HistoryOptions options)
+    : filepath(std::move(filepath)), options(options) {
+  std::error_code error;
+  uint64_t fileSize = std::filesystem::file_size(this->filepath, error);
+  if (error || fileSize == 0) {
+    return; // written on the first append
+  }
+
+  std::ifstream file(this->filepath, std::ios::binary);
+  char magic[HistoryMagic.size()];
+  if (fileSize < HistoryMagic.size() ||
+      !file.read(magic, HistoryMagic.size()) ||
+      std::string_view(magic, HistoryMagic.size()) != HistoryMagic) {
+    throw ParseError("History: " + this->filepath.string() +
+                     " is not a history file");
+  }
+
+  // Only the record headers are read, the changes are read on demand.
+  uint64_t offset = HistoryMagic.size();
+  char header[RecordHeaderSize];
+  while (fileSize - offset >= RecordHeaderSize &&
+         file.read(header, RecordHeaderSize)) {
+    Record record;
+    record.offset = offset;
+    record.length = readUInt32(header);
+    record.kind = static_cast<RecordKind>(header[4]);
+    record.checksum = readUInt32(header + 5);
+    if (fileSize - offset - RecordHeaderSize < record.length) {
+      break; // incomplete record
+    }
+    if (record.kind == RecordKind::Checkpoint) {
+      record.checkpoint = records.size();
+    } else if (record.kind == RecordKind::Delta && !records.empty()) {
+      record.checkpoint = records.back().checkpoint;
+    } else {
+      reportCorruption("invalid record", records.size());
+    }
+    records.push_back(record);
+    offset += RecordHeaderSize + record.length;
+    file.seekg(offset);
+  }
+  validEnd = offset;
+}
+
+std::vector<std::string> HistoryStore::readChanges(size_t revision) const {
+  std::ifstream file(filepath, std::ios::binary);
+  std::vector<std::string> changes;
+  for (size_t index = records[revision].checkpoint; index <= revision;
+       ++index) {
+    const Record &record = records[index];
+    std::string payload(record.length, '\0');
+    file.seekg(record.offset + RecordHeaderSize);
+    if (!file.read(payload.data(), payload.size()) ||
+        computeChecksum(payload) != record.checksum) {
+      reportCorruption("corrupted record", index);
+    }
+    changes.push_back(std::move(payload));
+  }
+  return changes;
+}
+
+size_t HistoryStore::appendRevision(const ModuleCollection &moduleCollection) {
+  moduleCollection.loadAllModules();
+  RevisionState current = captureState(moduleCollection);
+
+  size_t revision = records.size();
+  RevisionState previous;
+  if (revision > 0) {
+    auto changes = readChanges(revision - 1);
+    for (size_t index = 0; index < changes.size(); ++index) {
+      applyChanges(previous, changes[index],
+                   records[revision - 1].checkpoint + index);
+    }
+    checkState(previous, revision - 1);
+  }
+
+  Record record;
+  record.kind = RecordKind::Delta;
+  std::string payload = encodeChanges(previous, current);
+  if (revision > 0) {
+    if (payload.empty()) {
+      return revision - 1;
+    }
+    record.checkpoint = records.back().checkpoint;
+    size_t interval = std::max<size_t>(options.checkpointInterval, 1);
+    // Checkpoints are preferred once the changes are as large as the last one.
+    if (revision - record.checkpoint >= interval ||
+        payload.size() >= records[record.checkpoint].length) {
+      record.kind = RecordKind::Checkpoint;
+    }
+  } else {
+    record.kind = RecordKind::Checkpoint;
+  }
+  if (record.kind == RecordKind::Checkpoint) {
+    record.checkpoint = revision;
+    if (revision > 0) {
+      payload = encodeChanges(RevisionState(), current);
+    }
+  }
+  if (payload.size() > UINT32_MAX) {
+    throw std::runtime_error("Revision is too large for the history");
+  }
+  record.length = payload.size();
+  record.checksum = computeChecksum(payload);
+
+  // The first revision rewrites the file, which may only contain an
+  // incomplete record.
+  std::string data;
+  if (revision == 0) {
+    data.append(HistoryMagic);
+    validEnd = HistoryMagic.size();
+  }
+  record.offset = validEnd;
+  writeUInt32(data, record.length);
+  data.push_back(static_cast<char>(record.kind));
+  writeUInt32(data, record.checksum);
+  data.append(payload);
+
+  // Drop an incomplete record of an earlier, interrupted append.
+  std::error_code error;
+  if (revision > 0 &&
+      std::filesystem::file_size(filepath, error) != validEnd && !error) {
+    std::filesystem::resize_file(filepath, validEnd);
+  }
+  std::ofstream file(filepath, revision > 0
+                                   ? std::ios::binary | std::ios::app
+                                   : std::ios::binary | std::ios::trunc);
+  if (!file.write(data.data(), data.size()) || !file.flush()) {
+    throw std::runtime_error("Could not write history file " +
+                             filepath.string());
+  }
+
+  records.push_back(record);
+  validEnd = record.offset + RecordHeaderSize + record.length;
+  return revision;
+}
+
+ModuleCollection HistoryStore::loadRevision(size_t revision) const {
+  if (revision >= records.size()) {
+    throw std::out_of_range("History has no revision " +
+                            std::to_string(revision));
+  }
+
+  RevisionState state;
+  auto changes = readChanges(revision);
+  size_t checkpoint = records[revision].checkpoint;
+  for (size_t index = 0; index < changes.size(); ++index) {
+    applyChanges(state, changes[index], checkpoint + index);
+  }
+  checkState(state, revision);
+  return buildCollection(state);
+}
+
+} // namespace sg20
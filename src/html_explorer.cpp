@@ -0,0 +1,692 @@
+#include "sg20_graphgen/html_explorer.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace sg20 {
+
+namespace {
+
+//===----------------------------------------------------------------------===//
+// Explorer graph
+
+// Topics numbered densely in collection order, with the dependencies and
+// dependents of every topic. Every entry of a row is the number of the other
+// topic times two, plus one for soft dependencies, and rows are sorted.
+// Dependencies on a topic ID that is used more than once refer to its first
+// topic, dangling dependencies and self loops are dropped.
+struct ExplorerGraph {
+  std::vector<const Module *> modules;
+  std::vector<const Topic *> topics;
+  std::vector<std::vector<int>> dependencies;
+  std::vector<std::vector<int>> dependents;
+  // Topological layer of every topic over its hard dependencies, topics on or
+  // behind a cycle are placed above all other topics.
+  std::vector<int> layers;
+};
+
+int makeEntry(int topic, DependencyKind kind) {
+  return topic * 2 + (kind == DependencyKind::Soft ? 1 : 0);
+}
+
+bool isHardEntry(int entry) { return entry % 2 == 0; }
+
+std::vector<int> computeHardLayers(const ExplorerGraph &graph) {
+  size_t numTopics = graph.topics.size();
+  std::vector<int> layers(numTopics, 0);
+  std::vector<int> pending(numTopics, 0);
+  std::vector<int> queue;
+  queue.reserve(numTopics);
+  for (size_t node = 0; node < numTopics; ++node) {
+    pending[node] = std::count_if(graph.dependencies[node].begin(),
+                                  graph.dependencies[node].end(), isHardEntry);
+    if (pending[node] == 0) {
+      queue.push_back(node);
+    }
+  }
+
+  for (size_t head = 0; head < queue.size(); ++head) {
+    int node = queue[head];
+    for (int entry : graph.dependents[node]) {
+      if (!isHardEntry(entry)) {
+        continue;
+      }
+      int dependent = entry / 2;
+      layers[dependent] = std::max(layers[dependent], layers[node] + 1);
+      if (--pending[dependent] == 0) {
+        queue.push_back(dependent);
+      }
+    }
+  }
+
+  if (queue.size() < numTopics) {
+    int top = *std::max_element(layers.begin(), layers.end()) + 1;
+    for (size_t node = 0; node < numTopics; ++node) {
+      if (pending[node] > 0) {
+        layers[node] = top;
+      }
+    }
+  }
+  return layers;
+}
+
+ExplorerGraph buildExplorerGraph(const ModuleCollection &moduleCollection) {
+  ExplorerGraph graph;
+  std::unordered_map<int, int> topicIndex;
+  graph.modules.reserve(moduleCollection.numModules());
+  graph.topics.reserve(moduleCollection.numTopics());
+  topicIndex.reserve(moduleCollection.numTopics());
+  for (auto &module : moduleCollection.modules()) {
+    for (auto &topic : module->topics()) {
+      topicIndex.emplace(topic->getID(), graph.topics.size());
+      graph.topics.push_back(topic.get());
+    }
+    graph.modules.push_back(module.get());
+  }
+
+  size_t numTopics = graph.topics.size();
+  graph.dependencies.resize(numTopics);
+  graph.dependents.resize(numTopics);
+  for (size_t node = 0; node < numTopics; ++node) {
+    auto addEdges = [&](auto deps, DependencyKind kind) {
+      for (int depID : deps) {
+        auto dep = topicIndex.find(depID);
+        if (dep == topicIndex.end() || dep->second == static_cast<int>(node)) {
+          continue;
+        }
+        graph.dependencies[node].push_back(makeEntry(dep->second, kind));
+        graph.dependents[dep->second].push_back(makeEntry(node, kind));
+      }
+    };
+    addEdges(graph.topics[node]->dependencies(), DependencyKind::Hard);
+    addEdges(graph.topics[node]->softDependencies(), DependencyKind::Soft);
+    // Dependents are appended in topic order and are already sorted.
+    std::sort(graph.dependencies[node].begin(), graph.dependencies[node].end());
+  }
+
+  graph.layers = computeHardLayers(graph);
+  return graph;
+}
+
+//===----------------------------------------------------------------------===//
+// Payload encoding
+
+// Writes LEB128 varints, signed values are zigzag encoded.
+class VarintWriter {
+public:
+  void writeUnsigned(uint64_t value) {
+    while (value >= 0x80) {
+      out.push_back(static_cast<char>((value & 0x7f) | 0x80));
+      value >>= 7;
+    }
+    out.push_back(static_cast<char>(value));
+  }
+
+  void writeSigned(int64_t value) {
+    writeUnsigned((static_cast<uint64_t>(value) << 1) ^
+                  static_cast<uint64_t>(value >> 63));
+  }
+
+  std::string take() { return std::move(out); }
+
+private:
+  std::string out;
+};
+
+// Every ID as the difference to the previous one, IDs are mostly ascending.
+template <typename RangeTy, typename GetIDFn>
+std::string encodeIDs(const RangeTy &range, GetIDFn getID) {
+  VarintWriter writer;
+  int64_t previous = 0;
+  for (auto *element : range) {
+    int64_t ID = getID(*element);
+    writer.writeSigned(ID - previous);
+    previous = ID;
+  }
+  return writer.take();
+}
+
+// Names separated by newlines, which do not occur in the names themselves.
+template <typename RangeTy, typename GetNameFn>
+std::string encodeNames(const RangeTy &range, GetNameFn getName) {
+  std::string names;
+  bool first = true;
+  for (auto *element : range) {
+    if (!first) {
+      names.push_back('\n');
+    }
+    first = false;
+    std::string name = getName(*element);
+    std::replace(name.begin(), name.end(), '\n', ' ');
+    names += name;
+  }
+  return names;
+}
+
+// The total number of entries, followed by every row as its size and its
+// entries. The first entry of a row is relative to the topic of the row,
+// every other one to the entry before it.
+std::string encodeAdjacency(const std::vector<std::vector<int>> &rows) {
+  VarintWriter writer;
+  size_t total = 0;
+  for (auto &row : rows) {
+    total += row.size();
+  }
+  writer.writeUnsigned(total);
+
+  for (size_t node = 0; node < rows.size(); ++node) {
+    writer.writeUnsigned(rows[node].size());
+    int64_t previous = node;
+    for (size_t index = 0; index < rows[node].size(); ++index) {
+      int entry = rows[node][index];
+      int64_t delta = entry / 2 - previous;
+      uint64_t value = index == 0 ? (static_cast<uint64_t>(delta) << 1) ^
+                                        static_cast<uint64_t>(delta >> 63)
+                                  : static_cast<uint64_t>(delta);
+      writer.writeUnsigned(value * 2 + entry % 2);
+      previous = entry / 2;
+    }
+  }
+  return writer.take();
+}
+
+// Encodes the bytes as base64 with padding.
+std::string encodeBase64(std::string_view bytes) {
+  static constexpr char Alphabet[] =
+      "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+  std::string encoded;
+  encoded.reserve((bytes.size() + 2) / 3 * 4);
+  size_t pos = 0;
+  for (; pos + 3 <= bytes.size(); pos += 3) {
+    uint32_t group = static_cast<uint8_t>(bytes[pos]) << 16 |
+                     static_cast<uint8_t>(bytes[pos + 1]) << 8 |
+                     static_cast<uint8_t>(bytes[pos + 2]);
+    encoded.push_back(Alphabet[group >> 18]);
+    encoded.push_back(Alphabet[(group >> 12) & 0x3f]);
+    encoded.push_back(Alphabet[(group >> 6) & 0x3f]);
+    encoded.push_back(Alphabet[group & 0x3f]);
+  }
+  if (size_t rest = bytes.size() - pos; rest > 0) {
+    uint32_t group = static_cast<uint8_t>(bytes[pos]) << 16;
+    if (rest == 2) {
+      group |= static_cast<uint8_t>(bytes[pos + 1]) << 8;
+    }
+    encoded.push_back(Alphabet[group >> 18]);
+    encoded.push_back(Alphabet[(group >> 12) & 0x3f]);
+    encoded.push_back(rest == 2 ? Alphabet[(group >> 6) & 0x3f] : '=');
+    encoded.push_back('=');
+  }
+  return encoded;
+}
+
+//===----------------------------------------------------------------------===//
+// Page
+
+constexpr std::string_view PageHead = R"html(<!DOCTYPE html>
+<html lang="en">
+<head>
+<meta charset="utf-8">
+<title>SG20 explorer</title>
+<style>
+body{margin:0;font-family:sans-serif;font-size:14px}
+header{position:sticky;top:0;z-index:1;display:flex;gap:12px;align-items:center;padding:8px;background:#fff;border-bottom:1px solid #ccc}
+#query{width:24em;padding:4px}
+#info{color:#666}
+main{display:flex;align-items:flex-start}
+#tree{flex:1;padding:8px}
+#panel{position:sticky;top:46px;width:30em;max-height:calc(100vh - 62px);overflow:auto;padding:8px;border-left:1px solid #ccc}
+.module>div{padding:2px 0;font-weight:bold;cursor:pointer}
+.module>div::before{content:"\25b8  "}
+.module.open>div::before{content:"\25be  "}
+ul{margin:0;padding-left:24px;list-style:none}
+li{padding:1px 4px;cursor:pointer}
+li:hover{background:#eee}
+.count{margin-left:6px;font-weight:normal;color:#666}
+.badge{margin-left:6px;padding:0 6px;border-radius:8px;font-weight:normal;background:#fbbf24}
+.badge:empty{display:none}
+.selected{background:#93c5fd}
+.prereq{background:#fde68a}
+.soft{background:#fef3c7}
+.dependent{background:#bbf7d0}
+.more{color:#06c}
+h2{margin:4px 0}
+h3{margin:12px 0 4px}
+</style>
+</head>
+<body>
+<header><b>SG20 explorer</b><input id="query" type="search" placeholder="Search topics and modules"><span id="info"></span></header>
+<main><div id="tree"></div><div id="panel"></div></main>
+)html";
+
+constexpr std::string_view PageScript = R"js(<script>
+"use strict";
+// Maximum number of topics that are shown at once in a module or a list.
+const PageSize = 500;
+
+function decodeBytes(text) {
+  const chars = atob(text), bytes = new Uint8Array(chars.length);
+  for (let i = 0; i < chars.length; ++i) {
+    bytes[i] = chars.charCodeAt(i);
+  }
+  return bytes;
+}
+
+class Reader {
+  constructor(text) { this.bytes = decodeBytes(text); this.pos = 0; }
+  next() {
+    let value = 0, scale = 1, byte;
+    do {
+      byte = this.bytes[this.pos++];
+      value += (byte & 127) * scale;
+      scale *= 128;
+    } while (byte & 128);
+    return value;
+  }
+}
+
+function fromZigzag(value) { return value % 2 ? -(value + 1) / 2 : value / 2; }
+
+function decodeIDs(text, count) {
+  const reader = new Reader(text), IDs = new Int32Array(count);
+  for (let i = 0, ID = 0; i < count; ++i) {
+    ID += fromZigzag(reader.next());
+    IDs[i] = ID;
+  }
+  return IDs;
+}
+
+function decodeNames(text, count) {
+  const names = new TextDecoder().decode(decodeBytes(text)).split("\n");
+  return names.slice(0, count);
+}
+
+function decodeAdjacency(text, count) {
+  const reader = new Reader(text), total = reader.next();
+  const start = new Int32Array(count + 1), target = new Int32Array(total),
+        soft = new Uint8Array(total);
+  let entry = 0;
+  for (let node = 0; node < count; ++node) {
+    start[node] = entry;
+    let previous = node;
+    for (let size = reader.next(), i = 0; i < size; ++i, ++entry) {
+      const value = reader.next(), delta = Math.floor(value / 2);
+      previous += i === 0 ? fromZigzag(delta) : delta;
+      target[entry] = previous;
+      soft[entry] = value % 2;
+    }
+  }
+  start[count] = entry;
+  return {start, target, soft};
+}
+
+const numModules = DATA.numModules, numTopics = DATA.numTopics;
+const moduleNames = decodeNames(DATA.moduleNames, numModules);
+const moduleIDs = decodeIDs(DATA.moduleIDs, numModules);
+const topicNames = decodeNames(DATA.topicNames, numTopics);
+const topicIDs = decodeIDs(DATA.topicIDs, numTopics);
+const moduleStart = new Int32Array(numModules + 1);
+const moduleOf = new Int32Array(numTopics);
+{
+  const reader = new Reader(DATA.moduleSizes);
+  for (let m = 0; m < numModules; ++m) {
+    moduleStart[m + 1] = moduleStart[m] + reader.next();
+    moduleOf.fill(m, moduleStart[m], moduleStart[m + 1]);
+  }
+}
+const layers = new Int32Array(numTopics);
+{
+  const reader = new Reader(DATA.layers);
+  for (let t = 0; t < numTopics; ++t) {
+    layers[t] = reader.next();
+  }
+}
+const deps = decodeAdjacency(DATA.dependencies, numTopics);
+const dependents = decodeAdjacency(DATA.dependents, numTopics);
+const topicIndex = new Map();
+for (let t = numTopics - 1; t >= 0; --t) {
+  topicIndex.set(topicIDs[t], t);
+}
+
+//===--------------------------------------------------------------------===//
+// Module tree
+
+const Selected = 1, Prereq = 2, Soft = 3, Dependent = 4;
+const markClass = ["", "selected", "prereq", "soft", "dependent"];
+const marks = new Uint8Array(numTopics);
+const prereqCounts = new Int32Array(numModules);
+let selected = -1, badged = [];
+
+const tree = document.getElementById("tree");
+const panel = document.getElementById("panel");
+const moduleElements = [];
+{
+  const fragment = document.createDocumentFragment();
+  for (let m = 0; m < numModules; ++m) {
+    const div = document.createElement("div"), head = document.createElement("div");
+    const count = document.createElement("span"), badge = document.createElement("span");
+    const list = document.createElement("ul");
+    div.className = "module";
+    head.dataset.module = m;
+    head.textContent = moduleNames[m];
+    count.className = "count";
+    count.textContent = (moduleStart[m + 1] - moduleStart[m]) + " topics";
+    badge.className = "badge";
+    head.append(count, badge);
+    div.append(head, list);
+    fragment.append(div);
+    moduleElements.push({div, badge, list, shown: 0});
+  }
+  tree.append(fragment);
+}
+document.getElementById("info").textContent =
+    numModules + " modules, " + numTopics + " topics, " + deps.target.length +
+    " dependencies";
+
+function topicItem(t, withModule) {
+  const item = document.createElement("li");
+  item.dataset.topic = t;
+  item.className = markClass[marks[t]];
+  item.textContent = topicNames[t];
+  if (withModule) {
+    const module = document.createElement("span");
+    module.className = "count";
+    module.textContent = moduleNames[moduleOf[t]];
+    item.append(module);
+  }
+  return item;
+}
+
+function moreItem(text, onClick) {
+  const item = document.createElement("li");
+  item.className = "more";
+  item.textContent = text;
+  item.onclick = onClick;
+  return item;
+}
+
+// Shows the first count topics of the module, the others on request.
+function expand(m, count) {
+  const element = moduleElements[m];
+  const begin = moduleStart[m], end = Math.min(moduleStart[m + 1], begin + count);
+  const fragment = document.createDocumentFragment();
+  for (let t = begin; t < end; ++t) {
+    fragment.append(topicItem(t, false));
+  }
+  if (end < moduleStart[m + 1]) {
+    fragment.append(moreItem((moduleStart[m + 1] - end) + " more topics",
+                             () => expand(m, count + PageSize)));
+  }
+  element.list.replaceChildren(fragment);
+  element.div.classList.add("open");
+  element.shown = end - begin;
+}
+
+function collapse(m) {
+  const element = moduleElements[m];
+  element.list.replaceChildren();
+  element.div.classList.remove("open");
+  element.shown = 0;
+}
+
+function reveal(t) {
+  const m = moduleOf[t], offset = t - moduleStart[m];
+  if (offset >= moduleElements[m].shown) {
+    expand(m, offset + PageSize);
+  }
+  moduleElements[m].list.children[offset].scrollIntoView({block: "center"});
+}
+
+function refreshMarks() {
+  for (const element of moduleElements) {
+    if (element.shown === 0) {
+      continue;
+    }
+    for (const item of element.list.children) {
+      if (item.dataset.topic !== undefined) {
+        item.className = markClass[marks[item.dataset.topic]];
+      }
+    }
+  }
+  for (const m of badged) {
+    moduleElements[m].badge.textContent = "";
+  }
+  badged = [];
+  for (let m = 0; m < numModules; ++m) {
+    if (prereqCounts[m] > 0) {
+      moduleElements[m].badge.textContent = prereqCounts[m];
+      badged.push(m);
+    }
+  }
+}
+
+//===--------------------------------------------------------------------===//
+// Selection and search
+
+function appendList(title, topics) {
+  const header = document.createElement("h3"), list = document.createElement("ul");
+  header.textContent = title + " (" + topics.length + ")";
+  for (const t of topics.slice(0, PageSize)) {
+    list.append(topicItem(t, true));
+  }
+  if (topics.length > PageSize) {
+    list.append(moreItem((topics.length - PageSize) + " more", () => {
+      list.lastChild.remove();
+      for (const t of topics.slice(PageSize)) {
+        list.append(topicItem(t, true));
+      }
+    }));
+  }
+  panel.append(header, list);
+}
+
+let selection = null;
+
+function select(t) {
+  marks.fill(0);
+  prereqCounts.fill(0);
+  selected = t;
+  marks[t] = Selected;
+
+  // All transitive hard prerequisites, breadth first.
+  const queue = [t];
+  for (let head = 0; head < queue.length; ++head) {
+    const node = queue[head];
+    for (let e = deps.start[node]; e < deps.start[node + 1]; ++e) {
+      const dep = deps.target[e];
+      if (!deps.soft[e] && !marks[dep]) {
+        marks[dep] = Prereq;
+        queue.push(dep);
+      }
+    }
+  }
+  const prereqs = queue.slice(1), soft = [], needed = [];
+  for (let e = deps.start[t]; e < deps.start[t + 1]; ++e) {
+    const dep = deps.target[e];
+    if (!marks[dep]) {
+      marks[dep] = Soft;
+      soft.push(dep);
+    }
+  }
+  for (let e = dependents.start[t]; e < dependents.start[t + 1]; ++e) {
+    const dependent = dependents.target[e];
+    if (!marks[dependent]) {
+      marks[dependent] = Dependent;
+      needed.push(dependent);
+    }
+  }
+  for (const dep of prereqs.concat(soft)) {
+    prereqCounts[moduleOf[dep]]++;
+  }
+  // Prerequisites in the order in which they can be taught.
+  prereqs.sort((a, b) => layers[a] - layers[b] || a - b);
+
+  selection = {prereqs, soft, needed};
+  refreshMarks();
+  showSelection();
+  history.replaceState(null, "", "#t" + topicIDs[t]);
+}
+
+function showSelection() {
+  panel.replaceChildren();
+  if (selected < 0) {
+    panel.textContent = "Select a topic to highlight its prerequisites.";
+    return;
+  }
+  const title = document.createElement("h2"), module = document.createElement("div");
+  title.textContent = topicNames[selected];
+  module.className = "count";
+  module.textContent = moduleNames[moduleOf[selected]] + " (module " +
+                       moduleIDs[moduleOf[selected]] + "), topic " +
+                       topicIDs[selected] + ", layer " + layers[selected];
+  panel.append(title, module);
+  appendList("Prerequisites", selection.prereqs);
+  appendList("Soft prerequisites", selection.soft);
+  appendList("Needed by", selection.needed);
+}
+
+let lowerTopicNames = null, lowerModuleNames = null;
+
+function search(text) {
+  const query = text.trim().toLowerCase();
+  if (!query) {
+    showSelection();
+    return;
+  }
+  if (!lowerTopicNames) {
+    lowerTopicNames = topicNames.map(name => name.toLowerCase());
+    lowerModuleNames = moduleNames.map(name => name.toLowerCase());
+  }
+
+  // Names that start with the query come first.
+  const matches = (names) => {
+    const prefix = [], infix = [];
+    names.forEach((name, i) => {
+      const pos = name.indexOf(query);
+      if (pos === 0) {
+        prefix.push(i);
+      } else if (pos > 0) {
+        infix.push(i);
+      }
+    });
+    return prefix.concat(infix);
+  };
+
+  panel.replaceChildren();
+  const modules = matches(lowerModuleNames);
+  const header = document.createElement("h3"), list = document.createElement("ul");
+  header.textContent = "Modules (" + modules.length + ")";
+  for (const m of modules.slice(0, PageSize)) {
+    const item = document.createElement("li");
+    item.dataset.module = m;
+    item.textContent = moduleNames[m];
+    list.append(item);
+  }
+  panel.append(header, list);
+  appendList("Topics", matches(lowerTopicNames));
+}
+
+tree.addEventListener("click", (event) => {
+  const target = event.target.closest("[data-topic],[data-module]");
+  if (!target) {
+    return;
+  }
+  if (target.dataset.topic !== undefined) {
+    select(Number(target.dataset.topic));
+  } else {
+    const m = Number(target.dataset.module);
+    if (moduleElements[m].shown) {
+      collapse(m);
+    } else {
+      expand(m, PageSize);
+    }
+  }
+});
+
+panel.addEventListener("click", (event) => {
+  const target = event.target.closest("[data-topic],[data-module]");
+  if (!target) {
+    return;
+  }
+  if (target.dataset.topic !== undefined) {
+    const t = Number(target.dataset.topic);
+    reveal(t);
+    select(t);
+  } else {
+    const m = Number(target.dataset.module);
+    expand(m, PageSize);
+    moduleElements[m].div.scrollIntoView();
+  }
+});
+
+let searchTimer = 0;
+document.getElementById("query").addEventListener("input", (event) => {
+  clearTimeout(searchTimer);
+  searchTimer = setTimeout(() => search(event.target.value), 100);
+});
+
+{
+  const linked = topicIndex.get(Number(location.hash.slice(2)));
+  if (location.hash.startsWith("#t") && linked !== undefined) {
+    reveal(linked);
+    select(linked);
+  } else {
+    showSelection();
+  }
+}
+</script>
+</body>
+</html>
+)js";
+
+} // namespace
+
+//===----------------------------------------------------------------------===//
+// Explorer output
+
+void writeHTMLExplorer(const ModuleCollection &moduleCollection,
+                       OutputSink &out) {
+  ExplorerGraph graph = buildExplorerGraph(moduleCollection);
+
+  VarintWriter moduleSizes;
+  for (const Module *module : graph.modules) {
+    moduleSizes.writeUnsigned(module->numTopics());
+  }
+  VarintWriter layers;
+  for (int layer : graph.layers) {
+    layers.writeUnsigned(layer);
+  }
+
+  auto writeField = [&out](std::string_view name, std::string_view bytes) {
+    out << "  " << name << ": \"" << encodeBase64(bytes) << "\",\n";
+  };
+
+  out << PageHead;
+  out << "<script>\nconst DATA = {\n";
+  out << "  numModules: " << graph.modules.size() << ",\n";
+  out << "  numTopics: " << graph.topics.size() << ",\n";
+  writeField("moduleNames",
+             encodeNames(graph.modules, [](const Module &module) {
+               return module.getModuleName();
+             }));
+  writeField("moduleIDs", encodeIDs(graph.modules, [](const Module &module) {
+               return module.getModuleID();
+             }));
+  writeField("moduleSizes", moduleSizes.take());
+  writeField("topicNames", encodeNames(graph.topics, [](const Topic &topic) {
+               return topic.getName();
+             }));
+  writeField("topicIDs", encodeIDs(graph.topics, [](const Topic &topic) {
+               return topic.getID();
+             }));
+  writeField("layers", layers.take());
+  writeField("dependencies", encodeAdjacency(graph.dependencies));
+  writeField("dependents", encodeAdjacency(graph.dependents));
+  out << "};\n</script>\n";
+  out << PageScript;
+}
+
+} // namespace sg20
@@ -1,11 +1,20 @@
 #include "sg20_graphgen/html_generator.h"
+#include "sg20_graphgen/util.h"
 
 #include "HTML/Element.h"
 
+#include <algorithm>
+#include <cctype>
+#include <map>
+#include <stdexcept>
 #include <utility>
 
 using HTML::Bold;
 using HTML::Col;
+using HTML::Document;
+using HTML::Header1;
+using HTML::Header2;
+using HTML::Link;
 using HTML::List;
 using HTML::ListItem;
 using HTML::Row;
@@ -19,24 +28,9 @@ namespace sg20 {
 // HTML generator functions
 
 Table generateHTMLTable(const ModuleCollection &moduleCollection, int maxRows) {
-  Table newTable;
-
-  Row row;
-  int moduleCounter = 0;
-  for (auto &module : moduleCollection.modules()) {
-    moduleCounter += 1;
-
-    row << generateHTMLCol(*module);
-    if (moduleCounter % maxRows == 0) { // persist in table and create next row
-      newTable << move(row);
-      row = Row();
-    }
-  }
-  if (moduleCounter % maxRows != 0) {
-    newTable << move(row);
-  }
-
-  return newTable;
+  HTMLTableEmitter tableEmitter(maxRows);
+  traverseModuleCollection(moduleCollection, tableEmitter);
+  return tableEmitter.takeTable();
 }
 
 Col generateHTMLCol(const Module &module) {
@@ -54,10 +48,222 @@ Col generateHTMLCol(const Module &module) {
   return newColumn;
 }
 
+Table generateHTMLTable(const ModuleCollection &moduleCollection,
+                        const std::vector<const Module *> &modules,
+                        int maxRows, bool moduleAnchors) {
+  HTMLTableEmitter tableEmitter(maxRows, moduleAnchors);
+  tableEmitter.beginCollection(moduleCollection);
+  for (const Module *module : modules) {
+    detail::traverseModule(*module, tableEmitter);
+  }
+  tableEmitter.endCollection(moduleCollection);
+  return tableEmitter.takeTable();
+}
+
+std::string getModuleAnchor(const Module &module) {
+  return absl::StrCat("module_", module.getModuleID());
+}
+
+//===----------------------------------------------------------------------===//
+// Split HTML output
+
+static std::filesystem::path
+getPageFileName(const std::filesystem::path &indexFile,
+                const std::string &suffix) {
+  std::string extension = indexFile.extension().string();
+  return absl::StrCat(indexFile.stem().string(), "_", suffix,
+                      extension.empty() ? ".html" : extension);
+}
+
+std::vector<HTMLPage>
+splitModulesIntoPages(const ModuleCollection &moduleCollection,
+                      size_t numPages, const std::filesystem::path &indexFile) {
+  numPages = std::max<size_t>(1, numPages);
+
+  // The heading of a module counts like one of its topics.
+  size_t totalSize = 0;
+  for (auto &module : moduleCollection.modules()) {
+    totalSize += module->numTopics() + 1;
+  }
+
+  std::vector<HTMLPage> pages;
+  size_t doneSize = 0;
+  for (auto &module : moduleCollection.modules()) {
+    if (pages.size() < numPages &&
+        doneSize >= pages.size() * totalSize / numPages) {
+      std::string number = std::to_string(pages.size() + 1);
+      pages.push_back({absl::StrCat("Page ", number),
+                       getPageFileName(indexFile, number),
+                       {}});
+    }
+    pages.back().modules.push_back(module.get());
+    doneSize += module->numTopics() + 1;
+  }
+
+  for (auto &page : pages) {
+    absl::StrAppend(&page.title, ": ", page.modules.front()->getModuleName(),
+                    " - ", page.modules.back()->getModuleName());
+  }
+  return pages;
+}
+
+std::vector<HTMLPage>
+splitModulesByLetter(const ModuleCollection &moduleCollection,
+                     const std::filesystem::path &indexFile) {
+  // Letters sort before "other", so the pages are in alphabetical order.
+  std::map<std::string, std::vector<const Module *>> modulesByLetter;
+  for (auto &module : moduleCollection.modules()) {
+    std::string name = module->getModuleName();
+    unsigned char first = name.empty() ? 0 : name.front();
+    std::string letter = std::isalnum(first)
+                             ? std::string(1, std::toupper(first))
+                             : std::string("other");
+    modulesByLetter[letter].push_back(module.get());
+  }
+
+  std::vector<HTMLPage> pages;
+  pages.reserve(modulesByLetter.size());
+  for (auto &[letter, modules] : modulesByLetter) {
+    pages.push_back({letter, getPageFileName(indexFile, letter),
+                     std::move(modules)});
+  }
+  return pages;
+}
+
+Document generateHTMLPage(const ModuleCollection &moduleCollection,
+                          const HTMLPage &page,
+                          const std::filesystem::path &indexFile,
+                          int maxRows) {
+  Document document(page.title);
+  document << Link("Index", indexFile.filename().string());
+  document << Header1(page.title);
+  document << generateHTMLTable(moduleCollection, page.modules, maxRows,
+                                /*moduleAnchors=*/true);
+  return document;
+}
+
+Document generateHTMLIndex(const std::vector<HTMLPage> &pages) {
+  Document document("SG20 modules");
+  document << Header1("SG20 modules");
+  for (auto &page : pages) {
+    std::string pageFile = page.fileName.string();
+    Header2 header("");
+    header << Link(page.title, pageFile);
+    document << move(header);
+
+    List moduleList;
+    for (const Module *module : page.modules) {
+      ListItem item;
+      item << Link(module->getModuleName(),
+                   absl::StrCat(pageFile, "#", getModuleAnchor(*module)));
+      moduleList << move(item);
+    }
+    document << move(moduleList);
+  }
+  return document;
+}
+
+void emitSplitHTMLTables(const ModuleCollection &moduleCollection,
+                         const std::vector<HTMLPage> &pages,
+                         const std::filesystem::path &indexFile,
+                         int maxRows) {
+  std::filesystem::path directory = indexFile.parent_path();
+  // Not thrown from the worker threads, the first failed page is reported.
+  std::vector<char> failed(pages.size());
+  parallelFor(pages.size(), [&](size_t page) {
+    OutputSink pageFile(directory / pages[page].fileName);
+    OutputSinkStream pageStream(pageFile);
+    pageStream << generateHTMLPage(moduleCollection, pages[page], indexFile,
+                                   maxRows);
+    pageFile.flush();
+    failed[page] = !pageFile.good();
+  });
+  for (size_t page = 0; page < pages.size(); ++page) {
+    if (failed[page]) {
+      throw std::runtime_error("Could not write " +
+                               (directory / pages[page].fileName).string());
+    }
+  }
+
+  OutputSink indexOutput(indexFile);
+  OutputSinkStream indexStream(indexOutput);
+  indexStream << generateHTMLIndex(pages);
+  indexOutput.finish(indexFile);
+}
+
+//===----------------------------------------------------------------------===//
+// Schedule output
+
+Table generateScheduleHTMLTable(const Schedule &schedule) {
+  std::vector<std::vector<const Schedule::TopicSlot *>> slots(
+      schedule.numSlots,
+      std::vector<const Schedule::TopicSlot *>(schedule.numTracks));
+  for (auto &topicSlot : schedule.topics) {
+    slots[topicSlot.slot][topicSlot.track] = &topicSlot;
+  }
+
+  Table table;
+  table.addAttribute("border", "1");
+  {
+    Row header;
+    Col slotCol;
+    slotCol << Bold("Slot");
+    header << move(slotCol);
+    for (int track = 1; track <= schedule.numTracks; ++track) {
+      Col trackCol;
+      trackCol << Bold(absl::StrCat("Track ", track));
+      header << move(trackCol);
+    }
+    table << move(header);
+  }
+
+  for (size_t slot = 0; slot < slots.size(); ++slot) {
+    Row row;
+    row << Col(std::to_string(slot + 1));
+    for (const Schedule::TopicSlot *topicSlot : slots[slot]) {
+      if (topicSlot) {
+        row << Col(absl::StrCat(topicSlot->module->getModuleName(), ": ",
+                                topicSlot->topic->getName()));
+      } else {
+        row << Col();
+      }
+    }
+    table << move(row);
+  }
+  return table;
+}
+
+Document generateScheduleHTMLPage(const Schedule &schedule) {
+  Document document("SG20 teaching schedule");
+  document << Header1("SG20 teaching schedule");
+
+  document << Header2(absl::StrCat("Critical path (",
+                                   schedule.criticalPathLength, " slots)"));
+  List criticalPath(/*ordered=*/true);
+  for (const Topic *topic : schedule.criticalPath) {
+    criticalPath << ListItem(topic->getName());
+  }
+  document << move(criticalPath);
+
+  document << Header2(absl::StrCat("Schedule (", schedule.numSlots,
+                                   " slots, ", schedule.numTracks,
+                                   " tracks)"));
+  document << generateScheduleHTMLTable(schedule);
+  return document;
+}
+
 //===----------------------------------------------------------------------===//
 // Dot HTML generator functions
 
 Table generateDotHTMLTable(const Module &module) {
+  Table newTable = generateDotHTMLTableHeader(module);
+  for (auto &topic : module.topics()) {
+    newTable << generateDotHTMLTopicRow(*topic);
+  }
+  return newTable;
+}
+
+Table generateDotHTMLTableHeader(const Module &module) {
   Table newTable;
   newTable.addAttribute("border", "0");
 
@@ -68,18 +274,17 @@ Table generateDotHTMLTable(const Module &module) {
   row << std::move(col);
 
   newTable << std::move(row);
-
-  for (auto &topic : module.topics()) {
-    row = Row();
-    Col col = Col(topic->getName());
-    col.addAttribute("border", "0");
-    col.addAttribute("align", "left");
-    col.addAttribute("port", topic->getID());
-    row << std::move(col);
-    newTable << std::move(row);
-  }
-
   return newTable;
 }
 
+Row generateDotHTMLTopicRow(const Topic &topic) {
+  Row row;
+  Col col = Col(topic.getName());
+  col.addAttribute("border", "0");
+  col.addAttribute("align", "left");
+  col.addAttribute("port", topic.getID());
+  row << std::move(col);
+  return row;
+}
+
 } // namespace sg20
@@ -0,0 +1,418 @@
+#include "sg20_graphgen/serialization.h"
+
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace sg20 {
+
+namespace {
+
+// Recursive descent parser that only understands the module schema and hands
+// every topic and dependency straight to the collection builder.
+class JSONReader {
+public:
+  JSONReader(std::string_view input)
+      : begin(input.data()), cur(input.data()),
+        end(input.data() + input.size()) {}
+
+  ModuleCollection read() {
+    bool foundModules = false;
+    parseObject([this, &foundModules](std::string_view key) {
+      if (key == "Modules") {
+        parseArray([this]() { parseModule(); });
+        foundModules = true;
+      } else {
+        skipValue(0);
+      }
+    });
+
+    skipWhitespace();
+    if (cur != end) {
+      error("unexpected data after the document");
+    }
+    if (!foundModules) {
+      error("missing Modules");
+    }
+    return builder.finish();
+  }
+
+private:
+  struct ParsedTopic {
+    std::string name;
+    std::optional<int> tid;
+    std::vector<int> deps;
+    std::vector<int> softDeps;
+  };
+
+  static constexpr int MaxNestingDepth = 256;
+
+  [[noreturn]] void error(std::string_view msg) const {
+    size_t line = 1 + std::count(begin, cur, '\n');
+    throw ParseError("JSON: " + std::string(msg) + " (line " +
+                     std::to_string(line) + ")");
+  }
+
+  void skipWhitespace() {
+    while (cur != end &&
+           (*cur == ' ' || *cur == '\n' || *cur == '\r' || *cur == '\t')) {
+      ++cur;
+    }
+  }
+
+  bool consumeIf(char c) {
+    skipWhitespace();
+    if (cur != end && *cur == c) {
+      ++cur;
+      return true;
+    }
+    return false;
+  }
+
+  void expect(char c) {
+    if (!consumeIf(c)) {
+      error(std::string("expected '") + c + "'");
+    }
+  }
+
+  // Calls handleKey for every key of the object, which needs to consume the
+  // corresponding value.
+  template <typename KeyHandlerTy> void parseObject(KeyHandlerTy handleKey) {
+    expect('{');
+    if (consumeIf('}')) {
+      return;
+    }
+    do {
+      std::string key = std::move(keyBuffer);
+      parseString(key);
+      expect(':');
+      handleKey(std::string_view(key));
+      keyBuffer = std::move(key);
+    } while (consumeIf(','));
+    expect('}');
+  }
+
+  // Calls handleElement for every element of the array, which needs to consume
+  // the element.
+  template <typename ElementHandlerTy>
+  void parseArray(ElementHandlerTy handleElement) {
+    expect('[');
+    if (consumeIf(']')) {
+      return;
+    }
+    do {
+      handleElement();
+    } while (consumeIf(','));
+    expect(']');
+  }
+
+  // Topics and dependencies go straight to the builder as soon as the name
+  // and ID of their module or topic are known, which is the case for all files
+  // written by the emitters. Otherwise they are buffered until the end of the
+  // object.
+  void parseModule() {
+    std::string name;
+    bool hasName = false;
+    std::optional<int> mid;
+    Module *module = nullptr;
+    topics.clear();
+
+    parseObject([&](std::string_view key) {
+      if (key == "name" || key == "mid") {
+        if (module) {
+          error("module name or mid after its topics");
+        }
+        if (key == "name") {
+          parseString(name);
+          hasName = true;
+        } else {
+          mid = parseInt();
+        }
+      } else if (key == "sub") {
+        if (!module && hasName && mid) {
+          module = &builder.addModule(std::move(name), *mid);
+        }
+        parseArray([this, module]() { parseTopic(module); });
+      } else {
+        skipValue(0);
+      }
+    });
+    if (!hasName || !mid) {
+      error("module is missing name or mid");
+    }
+
+    if (!module) {
+      module = &builder.addModule(std::move(name), *mid);
+    }
+    for (auto &parsedTopic : topics) {
+      Topic &topic = builder.addTopic(*module, std::move(parsedTopic.name),
+                                      *parsedTopic.tid);
+      for (int dep : parsedTopic.deps) {
+        builder.addDependency(topic, dep, DependencyKind::Hard);
+      }
+      for (int dep : parsedTopic.softDeps) {
+        builder.addDependency(topic, dep, DependencyKind::Soft);
+      }
+    }
+  }
+
+  // Adds the topic to the module, or buffers it if the module is not known
+  // yet.
+  void parseTopic(Module *module) {
+    ParsedTopic &parsed = module ? topicBuffer : topics.emplace_back();
+    parsed.name.clear();
+    parsed.tid.reset();
+    parsed.deps.clear();
+    parsed.softDeps.clear();
+    bool hasName = false;
+    Topic *topic = nullptr;
+
+    auto parseDeps = [&](std::vector<int> &buffer, DependencyKind kind) {
+      if (!topic && module && hasName && parsed.tid) {
+        topic = &builder.addTopic(*module, std::move(parsed.name), *parsed.tid);
+      }
+      parseArray([&]() {
+        int dep = parseInt();
+        if (topic) {
+          builder.addDependency(*topic, dep, kind);
+        } else {
+          buffer.push_back(dep);
+        }
+      });
+    };
+    parseObject([&](std::string_view key) {
+      if (key == "name" || key == "tid") {
+        if (topic) {
+          error("topic name or tid after its dependencies");
+        }
+        if (key == "name") {
+          parseString(parsed.name);
+          hasName = true;
+        } else {
+          parsed.tid = parseInt();
+        }
+      } else if (key == "dep") {
+        parseDeps(parsed.deps, DependencyKind::Hard);
+      } else if (key == "softdep") {
+        parseDeps(parsed.softDeps, DependencyKind::Soft);
+      } else {
+        skipValue(0);
+      }
+    });
+    if (!hasName || !parsed.tid) {
+      error("topic is missing name or tid");
+    }
+
+    if (module && !topic) {
+      topic = &builder.addTopic(*module, std::move(parsed.name), *parsed.tid);
+    }
+    if (module) {
+      for (int dep : parsed.deps) {
+        builder.addDependency(*topic, dep, DependencyKind::Hard);
+      }
+      for (int dep : parsed.softDeps) {
+        builder.addDependency(*topic, dep, DependencyKind::Soft);
+      }
+    }
+  }
+
+  int parseInt() {
+    skipWhitespace();
+    int value = 0;
+    auto [next, ec] = std::from_chars(cur, end, value);
+    if (ec != std::errc() ||
+        (next != end && (*next == '.' || *next == 'e' || *next == 'E'))) {
+      error("expected an integer");
+    }
+    cur = next;
+    return value;
+  }
+
+  void parseString(std::string &out) {
+    skipWhitespace();
+    if (cur == end || *cur != '"') {
+      error("expected a string");
+    }
+    ++cur;
+    out.clear();
+
+    while (true) {
+      // Copy everything up to the next quote or escape in one go.
+      const char *chunkEnd = cur;
+      while (chunkEnd != end && *chunkEnd != '"' && *chunkEnd != '\\') {
+        ++chunkEnd;
+      }
+      out.append(cur, chunkEnd);
+      cur = chunkEnd;
+      if (cur == end) {
+        error("unterminated string");
+      }
+      if (*cur++ == '"') {
+        return;
+      }
+      parseEscape(out);
+    }
+  }
+
+  void parseEscape(std::string &out) {
+    if (cur == end) {
+      error("unterminated string");
+    }
+    switch (char c = *cur++) {
+    case '"':
+    case '\\':
+    case '/':
+      out += c;
+      return;
+    case 'b':
+      out += '\b';
+      return;
+    case 'f':
+      out += '\f';
+      return;
+    case 'n':
+      out += '\n';
+      return;
+    case 'r':
+      out += '\r';
+      return;
+    case 't':
+      out += '\t';
+      return;
+    case 'u':
+      break;
+    default:
+      error("invalid escape sequence");
+    }
+
+    uint32_t codePoint = parseHex4();
+    if (codePoint >= 0xD800 && codePoint <= 0xDBFF) {
+      if (end - cur < 6 || cur[0] != '\\' || cur[1] != 'u') {
+        error("invalid surrogate pair");
+      }
+      cur += 2;
+      uint32_t low = parseHex4();
+      if (low < 0xDC00 || low > 0xDFFF) {
+        error("invalid surrogate pair");
+      }
+      codePoint = 0x10000 + ((codePoint - 0xD800) << 10) + (low - 0xDC00);
+    }
+    appendUTF8(out, codePoint);
+  }
+
+  uint32_t parseHex4() {
+    if (end - cur < 4) {
+      error("invalid unicode escape");
+    }
+    uint32_t value = 0;
+    for (int i = 0; i < 4; ++i) {
+      char c = *cur++;
+      value <<= 4;
+      if (c >= '0' && c <= '9') {
+        value |= c - '0';
+      } else if (c >= 'a' && c <= 'f') {
+        value |= c - 'a' + 10;
+      } else if (c >= 'A' && c <= 'F') {
+        value |= c - 'A' + 10;
+      } else {
+        error("invalid unicode escape");
+      }
+    }
+    return value;
+  }
+
+  static void appendUTF8(std::string &out, uint32_t codePoint) {
+    if (codePoint < 0x80) {
+      out += static_cast<char>(codePoint);
+    } else if (codePoint < 0x800) {
+      out += static_cast<char>(0xC0 | (codePoint >> 6));
+      out += static_cast<char>(0x80 | (codePoint & 0x3F));
+    } else if (codePoint < 0x10000) {
+      out += static_cast<char>(0xE0 | (codePoint >> 12));
+      out += static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F));
+      out += static_cast<char>(0x80 | (codePoint & 0x3F));
+    } else {
+      out += static_cast<char>(0xF0 | (codePoint >> 18));
+      out += static_cast<char>(0x80 | ((codePoint >> 12) & 0x3F));
+      out += static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F));
+      out += static_cast<char>(0x80 | (codePoint & 0x3F));
+    }
+  }
+
+  void skipLiteral(std::string_view literal) {
+    if (static_cast<size_t>(end - cur) < literal.size() ||
+        std::memcmp(cur, literal.data(), literal.size()) != 0) {
+      error("unexpected token");
+    }
+    cur += literal.size();
+  }
+
+  void skipNumber() {
+    const char *start = cur;
+    while (cur != end && (std::isdigit(static_cast<unsigned char>(*cur)) ||
+                          *cur == '-' || *cur == '+' || *cur == '.' ||
+                          *cur == 'e' || *cur == 'E')) {
+      ++cur;
+    }
+    if (cur == start) {
+      error("unexpected token");
+    }
+  }
+
+  void skipValue(int depth) {
+    if (depth > MaxNestingDepth) {
+      error("nesting too deep");
+    }
+
+    skipWhitespace();
+    if (cur == end) {
+      error("unexpected end of input");
+    }
+    switch (*cur) {
+    case '{':
+      parseObject([this, depth](std::string_view) { skipValue(depth + 1); });
+      return;
+    case '[':
+      parseArray([this, depth]() { skipValue(depth + 1); });
+      return;
+    case '"':
+      parseString(skipBuffer);
+      return;
+    case 't':
+      skipLiteral("true");
+      return;
+    case 'f':
+      skipLiteral("false");
+      return;
+    case 'n':
+      skipLiteral("null");
+      return;
+    default:
+      skipNumber();
+    }
+  }
+
+  const char *begin;
+  const char *cur;
+  const char *end;
+
+  ModuleCollection::Builder builder;
+  // Topics of a module whose name or mid comes after them.
+  std::vector<ParsedTopic> topics;
+  ParsedTopic topicBuffer;
+  std::string keyBuffer;
+  std::string skipBuffer;
+};
+
+} // namespace
+
+ModuleCollection loadModulesFromJSON(std::string_view input) {
+  return JSONReader(input).read();
+}
+
+} // namespace sg20
@@ -0,0 +1,492 @@
+#include "sg20_graphgen/layout.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <numeric>
+#include <string>
+#include <utility>
+
+namespace sg20 {
+
+namespace {
+
+// Dependency edges between densely numbered topics in compressed rows.
+class Adjacency {
+public:
+  Adjacency(size_t numNodes, const std::vector<std::pair<int, int>> &edges,
+            bool reversed)
+      : offsets(numNodes + 1, 0), targets(edges.size()) {
+    for (auto [from, to] : edges) {
+      offsets[(reversed ? to : from) + 1] += 1;
+    }
+    std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+    std::vector<size_t> next(offsets.begin(), offsets.end() - 1);
+    for (auto [from, to] : edges) {
+      targets[next[reversed ? to : from]++] = reversed ? from : to;
+    }
+  }
+
+  auto neighbours(int node) const {
+    return make_range(targets.begin() + offsets[node],
+                      targets.begin() + offsets[node + 1]);
+  }
+  size_t numNeighbours(int node) const {
+    return offsets[node + 1] - offsets[node];
+  }
+
+private:
+  std::vector<size_t> offsets;
+  std::vector<int> targets;
+};
+
+// Computes the length of the longest dependency path starting at every topic.
+// If only cycles are left, the first unplaced topic is placed and its edges to
+// unplaced topics are ignored.
+std::vector<int> computeLayers(size_t numNodes, const Adjacency &deps,
+                               const Adjacency &dependents) {
+  std::vector<int> layers(numNodes, 0);
+  std::vector<size_t> unplacedDeps(numNodes);
+  std::vector<bool> placed(numNodes, false);
+  std::vector<int> worklist;
+  for (size_t node = 0; node < numNodes; ++node) {
+    unplacedDeps[node] = deps.numNeighbours(node);
+    if (unplacedDeps[node] == 0) {
+      worklist.push_back(node);
+    }
+  }
+
+  size_t cycleCandidate = 0;
+  for (size_t numPlaced = 0; numPlaced < numNodes;) {
+    if (worklist.empty()) {
+      while (placed[cycleCandidate]) {
+        ++cycleCandidate;
+      }
+      worklist.push_back(cycleCandidate);
+    }
+    int node = worklist.back();
+    worklist.pop_back();
+    if (placed[node]) {
+      continue;
+    }
+    placed[node] = true;
+    ++numPlaced;
+
+    for (int dependent : dependents.neighbours(node)) {
+      if (placed[dependent]) {
+        continue; // edge of a broken cycle
+      }
+      layers[dependent] = std::max(layers[dependent], layers[node] + 1);
+      if (--unplacedDeps[dependent] == 0) {
+        worklist.push_back(dependent);
+      }
+    }
+  }
+
+  return layers;
+}
+
+// Counts the pairs of the sequence that are out of order with merge sort.
+size_t countInversions(std::vector<int> &values, std::vector<int> &scratch,
+                       size_t begin, size_t end) {
+  if (end - begin < 2) {
+    return 0;
+  }
+  size_t middle = begin + (end - begin) / 2;
+  size_t inversions = countInversions(values, scratch, begin, middle) +
+                      countInversions(values, scratch, middle, end);
+  size_t left = begin;
+  size_t right = middle;
+  size_t out = begin;
+  while (left < middle && right < end) {
+    if (values[right] < values[left]) {
+      inversions += middle - left;
+      scratch[out++] = values[right++];
+    } else {
+      scratch[out++] = values[left++];
+    }
+  }
+  std::copy(values.begin() + left, values.begin() + middle,
+            scratch.begin() + out);
+  std::copy(values.begin() + right, values.begin() + end,
+            scratch.begin() + out + (middle - left));
+  std::copy(scratch.begin() + begin, scratch.begin() + end,
+            values.begin() + begin);
+  return inversions;
+}
+
+// Counts the crossings between edges that connect adjacent layers. Longer
+// edges are ignored, which makes this an estimate of what dot sees. The layers
+// are counted in parallel.
+size_t countCrossings(const std::vector<std::vector<int>> &layerTopics,
+                      const std::vector<int> &layers, const Adjacency &deps,
+                      const std::vector<int> &position) {
+  std::vector<size_t> layerCrossings(layerTopics.size(), 0);
+  parallelFor(layerTopics.size(), [&](size_t layer) {
+    if (layer == 0) {
+      return;
+    }
+    // Walking the sources in layer order and their targets in position order
+    // orders the edges by source, then two edges cross iff their targets are
+    // inverted.
+    std::vector<int> targets;
+    for (int node : layerTopics[layer]) {
+      size_t firstTarget = targets.size();
+      for (int dep : deps.neighbours(node)) {
+        if (layers[dep] + 1 == static_cast<int>(layer)) {
+          targets.push_back(position[dep]);
+        }
+      }
+      std::sort(targets.begin() + firstTarget, targets.end());
+    }
+    std::vector<int> scratch(targets.size());
+    layerCrossings[layer] =
+        countInversions(targets, scratch, 0, targets.size());
+  });
+  return std::accumulate(layerCrossings.begin(), layerCrossings.end(),
+                         size_t{0});
+}
+
+// Sizes of the drawing in pixels.
+constexpr double Margin = 16;
+constexpr double CharWidth = 7;
+constexpr double TopicPadding = 10;
+constexpr double MinTopicWidth = 40;
+constexpr double TopicHeight = 28;
+constexpr double TopicGap = 12;
+constexpr double LayerGap = 48;
+constexpr double ModulePadding = 12;
+constexpr double ModuleLabelHeight = 20;
+constexpr double ModuleGap = 24;
+
+double estimateTextWidth(const std::string &text) {
+  return text.size() * CharWidth + 2 * TopicPadding;
+}
+
+// Calls fn(begin, end) for every run of topics of the same module in layer.
+template <typename FnTy>
+void forEachModuleBlock(const std::vector<int> &layer,
+                        const std::vector<int> &moduleOfTopic, FnTy fn) {
+  for (size_t begin = 0; begin < layer.size();) {
+    size_t end = begin + 1;
+    while (end < layer.size() &&
+           moduleOfTopic[layer[end]] == moduleOfTopic[layer[begin]]) {
+      ++end;
+    }
+    fn(begin, end);
+    begin = end;
+  }
+}
+
+} // namespace
+
+LayoutOrder computeLayoutOrder(const ModuleCollection &moduleCollection,
+                               int sweeps) {
+  // Number modules and topics densely in collection order. Dependencies on a
+  // topic ID that is used more than once refer to its first topic.
+  std::vector<const Module *> modules;
+  std::vector<const Topic *> topics;
+  std::unordered_map<int, int> topicIndex;
+  LayoutGraph graph;
+  modules.reserve(moduleCollection.numModules());
+  topics.reserve(moduleCollection.numTopics());
+  graph.moduleOfTopic.reserve(moduleCollection.numTopics());
+  topicIndex.reserve(moduleCollection.numTopics());
+  for (auto &module : moduleCollection.modules()) {
+    for (auto &topic : module->topics()) {
+      topicIndex.emplace(topic->getID(), topics.size());
+      topics.push_back(topic.get());
+      graph.moduleOfTopic.push_back(modules.size());
+    }
+    modules.push_back(module.get());
+  }
+  graph.numModules = modules.size();
+
+  // Dangling dependencies and self loops do not affect the layout.
+  for (size_t node = 0; node < topics.size(); ++node) {
+    auto addEdge = [&](int depID) {
+      auto dep = topicIndex.find(depID);
+      if (dep != topicIndex.end() && dep->second != static_cast<int>(node)) {
+        graph.edges.emplace_back(node, dep->second);
+      }
+    };
+    for (auto dep : topics[node]->dependencies()) {
+      addEdge(dep);
+    }
+    for (auto dep : topics[node]->softDependencies()) {
+      addEdge(dep);
+    }
+  }
+  topicIndex.clear();
+
+  LayoutRanking ranking = rankLayoutGraph(std::move(graph), sweeps);
+  LayoutOrder order;
+  order.modules.reserve(modules.size());
+  for (size_t module = 0; module < modules.size(); ++module) {
+    order.modules.push_back({modules[module], {}});
+    order.modules.back().topics.reserve(ranking.moduleTopics[module].size());
+  }
+  order.layers.reserve(topics.size());
+  for (size_t module = 0; module < modules.size(); ++module) {
+    for (int node : ranking.moduleTopics[module]) {
+      order.modules[module].topics.push_back(topics[node]);
+      order.layers.emplace(topics[node]->getID(), ranking.layers[node]);
+    }
+  }
+  return order;
+}
+
+LayoutRanking rankLayoutGraph(LayoutGraph graph, int sweeps) {
+  const std::vector<int> &moduleOfTopic = graph.moduleOfTopic;
+  size_t numModules = graph.numModules;
+  size_t numTopics = moduleOfTopic.size();
+  std::vector<std::pair<int, int>> &edges = graph.edges;
+  Adjacency deps(numTopics, edges, /*reversed=*/false);
+  Adjacency dependents(numTopics, edges, /*reversed=*/true);
+  edges.clear();
+  edges.shrink_to_fit();
+
+  std::vector<int> layers = computeLayers(numTopics, deps, dependents);
+  int numLayers =
+      numTopics > 0 ? *std::max_element(layers.begin(), layers.end()) + 1 : 0;
+  std::vector<std::vector<int>> layerTopics(numLayers);
+  for (size_t node = 0; node < numTopics; ++node) {
+    layerTopics[layers[node]].push_back(node);
+  }
+
+  // Position of every topic within its layer.
+  std::vector<int> position(numTopics);
+  auto updatePositions = [&position](const std::vector<int> &layer) {
+    for (size_t i = 0; i < layer.size(); ++i) {
+      position[layer[i]] = i;
+    }
+  };
+  for (auto &layer : layerTopics) {
+    updatePositions(layer);
+  }
+
+  std::vector<std::vector<int>> bestLayerTopics = layerTopics;
+  size_t bestCrossings = countCrossings(layerTopics, layers, deps, position);
+  std::vector<double> barycenter(numTopics);
+  for (int sweep = 0; sweep < sweeps && bestCrossings > 0; ++sweep) {
+    // Upward sweeps place topics close to their dependencies, downward sweeps
+    // close to their dependents. Relative positions are used, so positions on
+    // layers of different sizes are comparable.
+    bool upwards = sweep % 2 == 0;
+    const Adjacency &neighbours = upwards ? deps : dependents;
+    for (int step = 0; step < numLayers; ++step) {
+      auto &layer = layerTopics[upwards ? step : numLayers - 1 - step];
+      for (int node : layer) {
+        double sum = 0;
+        for (int neighbour : neighbours.neighbours(node)) {
+          sum += static_cast<double>(position[neighbour]) /
+                 layerTopics[layers[neighbour]].size();
+        }
+        size_t count = neighbours.numNeighbours(node);
+        barycenter[node] = count > 0 ? sum / count
+                                     : static_cast<double>(position[node]) /
+                                           layer.size();
+      }
+      // Topics of a module stay together, as they are in the same cluster.
+      std::stable_sort(layer.begin(), layer.end(), [&](int lhs, int rhs) {
+        return std::make_pair(moduleOfTopic[lhs], barycenter[lhs]) <
+               std::make_pair(moduleOfTopic[rhs], barycenter[rhs]);
+      });
+      updatePositions(layer);
+    }
+
+    size_t crossings = countCrossings(layerTopics, layers, deps, position);
+    if (crossings < bestCrossings) {
+      bestCrossings = crossings;
+      bestLayerTopics = layerTopics;
+    }
+  }
+
+  LayoutRanking ranking;
+  ranking.moduleTopics.resize(numModules);
+  // Dot places dependents above their dependencies, so the topics are ordered
+  // from the highest layer to the lowest.
+  for (int layer = numLayers - 1; layer >= 0; --layer) {
+    for (int node : bestLayerTopics[layer]) {
+      ranking.moduleTopics[moduleOfTopic[node]].push_back(node);
+    }
+  }
+  ranking.layers = std::move(layers);
+  return ranking;
+}
+
+GraphLayout computeGraphLayout(const LayoutOrder &order, int iterations) {
+  // Number the topics densely in layout order, so the topics of every layer
+  // are grouped by module.
+  std::vector<const Topic *> topics;
+  std::vector<int> moduleOfTopic;
+  std::unordered_map<int, int> topicIndex;
+  for (size_t module = 0; module < order.modules.size(); ++module) {
+    for (const Topic *topic : order.modules[module].topics) {
+      topicIndex.emplace(topic->getID(), topics.size());
+      topics.push_back(topic);
+      moduleOfTopic.push_back(module);
+    }
+  }
+  size_t numModules = order.modules.size();
+  size_t numTopics = topics.size();
+
+  // Topics are pulled towards their dependencies and their dependents alike.
+  std::vector<std::pair<int, int>> edges;
+  for (size_t node = 0; node < numTopics; ++node) {
+    auto addEdge = [&](int depID) {
+      auto dep = topicIndex.find(depID);
+      if (dep != topicIndex.end() && dep->second != static_cast<int>(node)) {
+        edges.emplace_back(node, dep->second);
+        edges.emplace_back(dep->second, node);
+      }
+    };
+    for (auto dep : topics[node]->dependencies()) {
+      addEdge(dep);
+    }
+    for (auto dep : topics[node]->softDependencies()) {
+      addEdge(dep);
+    }
+  }
+  Adjacency neighbours(numTopics, edges, /*reversed=*/false);
+  edges.clear();
+  edges.shrink_to_fit();
+
+  int numLayers = 0;
+  for (const Topic *topic : topics) {
+    numLayers = std::max(numLayers, order.getLayer(topic->getID()) + 1);
+  }
+  // Rows are numbered from the top, which holds the highest layer.
+  std::vector<int> row(numTopics);
+  std::vector<std::vector<int>> rowTopics(numLayers);
+  std::vector<double> width(numTopics);
+  for (size_t node = 0; node < numTopics; ++node) {
+    row[node] = numLayers - 1 - order.getLayer(topics[node]->getID());
+    rowTopics[row[node]].push_back(node);
+    width[node] =
+        std::max(MinTopicWidth, estimateTextWidth(topics[node]->getName()));
+  }
+
+  // Every module gets a column that fits its widest row.
+  std::vector<double> columnLeft(numModules);
+  std::vector<double> columnWidth(numModules);
+  for (size_t module = 0; module < numModules; ++module) {
+    columnWidth[module] = estimateTextWidth(
+        order.modules[module].module->getModuleName());
+  }
+  for (auto &topicsOfRow : rowTopics) {
+    forEachModuleBlock(topicsOfRow, moduleOfTopic, [&](size_t begin,
+                                                       size_t end) {
+      double blockWidth = (end - begin - 1) * TopicGap;
+      for (size_t i = begin; i < end; ++i) {
+        blockWidth += width[topicsOfRow[i]];
+      }
+      double &column = columnWidth[moduleOfTopic[topicsOfRow[begin]]];
+      column = std::max(column, blockWidth);
+    });
+  }
+  double left = Margin;
+  for (size_t module = 0; module < numModules; ++module) {
+    columnLeft[module] = left + ModulePadding;
+    left += columnWidth[module] + 2 * ModulePadding + ModuleGap;
+  }
+
+  // Places the topics of a block at their desired centers, or as close as
+  // possible while keeping their order and staying inside the column.
+  auto placeBlock = [&](const std::vector<int> &topicsOfRow, size_t begin,
+                        size_t end, const std::vector<double> &desired,
+                        std::vector<double> &center) {
+    int module = moduleOfTopic[topicsOfRow[begin]];
+    double minLeft = columnLeft[module];
+    for (size_t i = begin; i < end; ++i) {
+      int node = topicsOfRow[i];
+      center[node] = std::max(desired[i - begin], minLeft + width[node] / 2);
+      minLeft = center[node] + width[node] / 2 + TopicGap;
+    }
+    double maxRight = columnLeft[module] + columnWidth[module];
+    for (size_t i = end; i-- > begin;) {
+      int node = topicsOfRow[i];
+      center[node] = std::min(center[node], maxRight - width[node] / 2);
+      maxRight = center[node] - width[node] / 2 - TopicGap;
+    }
+  };
+
+  // Start with every block centered in its column.
+  std::vector<double> center(numTopics);
+  for (auto &topicsOfRow : rowTopics) {
+    forEachModuleBlock(topicsOfRow, moduleOfTopic, [&](size_t begin,
+                                                       size_t end) {
+      int module = moduleOfTopic[topicsOfRow[begin]];
+      double columnCenter = columnLeft[module] + columnWidth[module] / 2;
+      std::vector<double> desired(end - begin, columnCenter);
+      placeBlock(topicsOfRow, begin, end, desired, center);
+    });
+  }
+
+  // Every iteration moves the topics of all rows at once towards the centers
+  // of their neighbours in the previous iteration, so the rows are independent.
+  std::vector<double> previous;
+  for (int iteration = 0; iteration < iterations; ++iteration) {
+    previous = center;
+    parallelFor(rowTopics.size(), [&](size_t rowIndex) {
+      const std::vector<int> &topicsOfRow = rowTopics[rowIndex];
+      std::vector<double> desired;
+      forEachModuleBlock(topicsOfRow, moduleOfTopic, [&](size_t begin,
+                                                         size_t end) {
+        desired.clear();
+        for (size_t i = begin; i < end; ++i) {
+          int node = topicsOfRow[i];
+          double sum = 0;
+          for (int neighbour : neighbours.neighbours(node)) {
+            sum += previous[neighbour];
+          }
+          size_t count = neighbours.numNeighbours(node);
+          desired.push_back(count > 0 ? sum / count : previous[node]);
+        }
+        placeBlock(topicsOfRow, begin, end, desired, center);
+      });
+    });
+  }
+
+  auto rowTop = [](int row) {
+    return Margin + ModuleLabelHeight + ModulePadding +
+           row * (TopicHeight + LayerGap);
+  };
+
+  GraphLayout layout;
+  layout.topicBoxes.reserve(numTopics);
+  for (size_t node = 0; node < numTopics; ++node) {
+    layout.topicBoxes.emplace(
+        topics[node]->getID(),
+        GraphLayout::Box{center[node] - width[node] / 2, rowTop(row[node]),
+                         width[node], TopicHeight});
+  }
+
+  // Clusters span the rows of their topics, empty modules only hold a label.
+  layout.moduleBoxes.reserve(numModules);
+  size_t node = 0;
+  for (size_t module = 0; module < numModules; ++module) {
+    int firstRow = numLayers;
+    int lastRow = 0;
+    for (; node < numTopics && moduleOfTopic[node] == static_cast<int>(module);
+         ++node) {
+      firstRow = std::min(firstRow, row[node]);
+      lastRow = std::max(lastRow, row[node]);
+    }
+    double top = firstRow < numLayers
+                     ? rowTop(firstRow) - ModuleLabelHeight - ModulePadding
+                     : Margin;
+    double bottom = firstRow < numLayers
+                        ? rowTop(lastRow) + TopicHeight + ModulePadding
+                        : Margin + ModuleLabelHeight + ModulePadding;
+    layout.moduleBoxes.push_back({columnLeft[module] - ModulePadding, top,
+                                  columnWidth[module] + 2 * ModulePadding,
+                                  bottom - top});
+    layout.height = std::max(layout.height, bottom + Margin);
+  }
+  layout.width = std::max(left - ModuleGap + Margin, 2 * Margin);
+  layout.height = std::max(layout.height, 2 * Margin);
+
+  return layout;
+}
+
+} // namespace sg20
@@ -0,0 +1,379 @@
+#include "sg20_graphgen/metrics.h"
+#include "sg20_graphgen/emitters.h"
+
+#include "absl/strings/str_cat.h"
+
+#include <algorithm>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+
+namespace sg20 {
+
+namespace {
+
+// Counts of one thread, they are merged after the pass.
+struct Accumulator {
+  size_t hardEdges = 0;
+  size_t softEdges = 0;
+  size_t danglingEdges = 0;
+  size_t crossModuleHardEdges = 0;
+  size_t crossModuleSoftEdges = 0;
+  std::vector<size_t> inDegrees;
+  std::vector<size_t> outDegrees;
+};
+
+void countDegree(std::vector<size_t> &degrees, size_t degree) {
+  if (degrees.size() <= degree) {
+    degrees.resize(degree + 1, 0);
+  }
+  ++degrees[degree];
+}
+
+void mergeDegrees(std::vector<size_t> &degrees,
+                  const std::vector<size_t> &other) {
+  if (degrees.size() < other.size()) {
+    degrees.resize(other.size(), 0);
+  }
+  for (size_t degree = 0; degree < other.size(); ++degree) {
+    degrees[degree] += other[degree];
+  }
+}
+
+// Dependencies of the topics of a module on the topics of another module.
+struct ModuleLink {
+  int target;
+  size_t numEdges;
+  bool hard;
+};
+
+// Returns the number of topics of the longest chain of the dependency edges
+// between the densely numbered topics. If only cycles are left, the first
+// unplaced topic is placed and its edges to unplaced topics are ignored.
+size_t computeLongestChain(size_t numNodes,
+                           const std::vector<std::pair<int, int>> &edges) {
+  if (numNodes == 0) {
+    return 0;
+  }
+  std::vector<size_t> unplacedDeps(numNodes, 0);
+  std::vector<std::vector<int>> dependents(numNodes);
+  for (auto [node, dep] : edges) {
+    ++unplacedDeps[node];
+    dependents[dep].push_back(node);
+  }
+
+  std::vector<size_t> chain(numNodes, 1);
+  std::vector<bool> placed(numNodes, false);
+  std::vector<int> worklist;
+  for (size_t node = 0; node < numNodes; ++node) {
+    if (unplacedDeps[node] == 0) {
+      worklist.push_back(node);
+    }
+  }
+  size_t cycleCandidate = 0;
+  size_t longest = 0;
+  for (size_t numPlaced = 0; numPlaced < numNodes;) {
+    if (worklist.empty()) {
+      while (placed[cycleCandidate]) {
+        ++cycleCandidate;
+      }
+      worklist.push_back(cycleCandidate);
+    }
+    int node = worklist.back();
+    worklist.pop_back();
+    if (placed[node]) {
+      continue;
+    }
+    placed[node] = true;
+    ++numPlaced;
+    longest = std::max(longest, chain[node]);
+
+    for (int dependent : dependents[node]) {
+      if (placed[dependent]) {
+        continue; // edge of a broken cycle
+      }
+      chain[dependent] = std::max(chain[dependent], chain[node] + 1);
+      if (--unplacedDeps[dependent] == 0) {
+        worklist.push_back(dependent);
+      }
+    }
+  }
+  return longest;
+}
+
+// Counts the strongly connected components of more than one module with
+// Tarjan's algorithm, iteratively to not overflow the stack on long chains.
+void countModuleCycles(const std::vector<std::vector<int>> &targets,
+                       CollectionMetrics &metrics) {
+  size_t numModules = targets.size();
+  std::vector<int> index(numModules, -1);
+  std::vector<int> lowLink(numModules, 0);
+  std::vector<bool> onStack(numModules, false);
+  std::vector<int> stack;
+  // Pairs of a module and the position of its next target.
+  std::vector<std::pair<int, size_t>> callStack;
+  int nextIndex = 0;
+  auto visit = [&](int module) {
+    index[module] = lowLink[module] = nextIndex++;
+    stack.push_back(module);
+    onStack[module] = true;
+    callStack.emplace_back(module, 0);
+  };
+
+  for (size_t root = 0; root < numModules; ++root) {
+    if (index[root] != -1) {
+      continue;
+    }
+    visit(root);
+    while (!callStack.empty()) {
+      int module = callStack.back().first;
+      size_t next = callStack.back().second++;
+      if (next < targets[module].size()) {
+        int target = targets[module][next];
+        if (index[target] == -1) {
+          visit(target);
+        } else if (onStack[target]) {
+          lowLink[module] = std::min(lowLink[module], index[target]);
+        }
+        continue;
+      }
+
+      callStack.pop_back();
+      if (!callStack.empty()) {
+        int parent = callStack.back().first;
+        lowLink[parent] = std::min(lowLink[parent], lowLink[module]);
+      }
+      if (lowLink[module] != index[module]) {
+        continue;
+      }
+      size_t componentSize = 0;
+      int member;
+      do {
+        member = stack.back();
+        stack.pop_back();
+        onStack[member] = false;
+        ++componentSize;
+      } while (member != module);
+      if (componentSize > 1) {
+        ++metrics.moduleCycles;
+        metrics.modulesInCycles += componentSize;
+      }
+    }
+  }
+}
+
+} // namespace
+
+CollectionMetrics computeMetrics(const ModuleCollection &moduleCollection) {
+  // Lazy loading is not synchronized between the threads.
+  moduleCollection.loadAllModules();
+
+  CollectionMetrics metrics;
+  std::vector<const Module *> modules;
+  std::unordered_map<const Module *, int> moduleIndex;
+  modules.reserve(moduleCollection.numModules());
+  moduleIndex.reserve(moduleCollection.numModules());
+  for (auto &module : moduleCollection.modules()) {
+    moduleIndex.emplace(module.get(), modules.size());
+    modules.push_back(module.get());
+  }
+  size_t numModules = modules.size();
+  metrics.modules.resize(numModules);
+  std::vector<std::vector<ModuleLink>> links(numModules);
+
+  // Every thread walks a contiguous range of modules. Per module results are
+  // only written by the thread of the module.
+  size_t numThreads = std::min<size_t>(
+      numModules, std::max(1u, std::thread::hardware_concurrency()));
+  std::vector<Accumulator> accumulators(numThreads);
+  parallelFor(numThreads, [&](size_t thread) {
+    Accumulator &acc = accumulators[thread];
+    std::unordered_map<int, int> localIndex;
+    std::vector<std::pair<int, int>> localEdges;
+    std::vector<std::pair<int, bool>> targets;
+    for (size_t m = thread * numModules / numThreads;
+         m < (thread + 1) * numModules / numThreads; ++m) {
+      const Module &module = *modules[m];
+      CollectionMetrics::ModuleMetrics &moduleMetrics = metrics.modules[m];
+      moduleMetrics.moduleID = module.getModuleID();
+      moduleMetrics.name = module.getModuleName();
+      moduleMetrics.numTopics = module.numTopics();
+
+      localIndex.clear();
+      localEdges.clear();
+      targets.clear();
+      for (auto &topic : module.topics()) {
+        localIndex.emplace(topic->getID(), localIndex.size());
+      }
+      int node = 0;
+      for (auto &topic : module.topics()) {
+        size_t outDegree = 0;
+        auto countDependency = [&](int dep, bool hard) {
+          const Module *depModule = moduleCollection.getModuleFromTopicID(dep);
+          if (!depModule) {
+            ++acc.danglingEdges;
+            return;
+          }
+          ++outDegree;
+          ++(hard ? acc.hardEdges : acc.softEdges);
+          if (depModule != &module) {
+            ++(hard ? acc.crossModuleHardEdges : acc.crossModuleSoftEdges);
+            targets.emplace_back(moduleIndex.at(depModule), hard);
+            return;
+          }
+          // Topics with an ID that is used more than once in the module are
+          // chained through the first one.
+          auto local = localIndex.find(dep);
+          if (hard && local != localIndex.end() && local->second != node) {
+            localEdges.emplace_back(node, local->second);
+          }
+        };
+        for (int dep : topic->dependencies()) {
+          countDependency(dep, true);
+        }
+        for (int dep : topic->softDependencies()) {
+          countDependency(dep, false);
+        }
+        countDegree(acc.outDegrees, outDegree);
+        countDegree(acc.inDegrees,
+                    topic->numDependents() + topic->numSoftDependents());
+        ++node;
+      }
+      moduleMetrics.longestChain =
+          computeLongestChain(module.numTopics(), localEdges);
+
+      std::sort(targets.begin(), targets.end());
+      for (auto [target, hard] : targets) {
+        if (links[m].empty() || links[m].back().target != target) {
+          links[m].push_back({target, 0, false});
+        }
+        ++links[m].back().numEdges;
+        links[m].back().hard |= hard;
+      }
+    }
+  });
+
+  for (auto &acc : accumulators) {
+    metrics.hardEdges += acc.hardEdges;
+    metrics.softEdges += acc.softEdges;
+    metrics.danglingEdges += acc.danglingEdges;
+    metrics.crossModuleHardEdges += acc.crossModuleHardEdges;
+    metrics.crossModuleSoftEdges += acc.crossModuleSoftEdges;
+    mergeDegrees(metrics.inDegrees, acc.inDegrees);
+    mergeDegrees(metrics.outDegrees, acc.outDegrees);
+  }
+
+  std::vector<std::vector<int>> hardTargets(numModules);
+  for (size_t m = 0; m < numModules; ++m) {
+    metrics.numTopics += metrics.modules[m].numTopics;
+    metrics.modules[m].fanOut = links[m].size();
+    for (auto &link : links[m]) {
+      metrics.modules[m].outgoingEdges += link.numEdges;
+      metrics.modules[link.target].fanIn += 1;
+      metrics.modules[link.target].incomingEdges += link.numEdges;
+      if (link.hard) {
+        hardTargets[m].push_back(link.target);
+      }
+    }
+  }
+  countModuleCycles(hardTargets, metrics);
+  return metrics;
+}
+
+//===----------------------------------------------------------------------===//
+// Output
+
+// Returns the ratio of cross-module hard to soft dependencies, or an empty
+// string if there are no soft ones.
+static std::string getHardSoftRatio(const CollectionMetrics &metrics) {
+  if (metrics.crossModuleSoftEdges == 0) {
+    return "";
+  }
+  return absl::StrCat(static_cast<double>(metrics.crossModuleHardEdges) /
+                      metrics.crossModuleSoftEdges);
+}
+
+void writeMetricsReport(const CollectionMetrics &metrics, OutputSink &out) {
+  std::string ratio = getHardSoftRatio(metrics);
+  out << "Modules: " << metrics.modules.size()
+      << ", topics: " << metrics.numTopics << "\n"
+      << "Dependencies: " << metrics.hardEdges << " hard, "
+      << metrics.softEdges << " soft, " << metrics.danglingEdges
+      << " dangling\n"
+      << "Cross-module dependencies: " << metrics.crossModuleHardEdges
+      << " hard, " << metrics.crossModuleSoftEdges << " soft, hard/soft ratio "
+      << (ratio.empty() ? "n/a" : ratio) << "\n"
+      << "Module cycles: " << metrics.moduleCycles << ", "
+      << metrics.modulesInCycles << " modules on cycles\n";
+
+  out << "\nModules:\n";
+  for (auto &module : metrics.modules) {
+    out << "  " << module.name << " (" << module.moduleID
+        << "): " << module.numTopics << " topics, fan-in " << module.fanIn
+        << ", fan-out " << module.fanOut << ", " << module.incomingEdges
+        << " incoming, " << module.outgoingEdges
+        << " outgoing, longest chain " << module.longestChain << "\n";
+  }
+
+  // Only degrees that occur are listed.
+  out << "\nDegree distribution (degree: topics with that in-degree, "
+         "out-degree):\n";
+  size_t maxDegree = std::max(metrics.inDegrees.size(),
+                              metrics.outDegrees.size());
+  auto getCount = [](const std::vector<size_t> &degrees, size_t degree) {
+    return degree < degrees.size() ? degrees[degree] : 0;
+  };
+  for (size_t degree = 0; degree < maxDegree; ++degree) {
+    size_t in = getCount(metrics.inDegrees, degree);
+    size_t outCount = getCount(metrics.outDegrees, degree);
+    if (in == 0 && outCount == 0) {
+      continue;
+    }
+    out << "  " << degree << ": " << in << ", " << outCount << "\n";
+  }
+}
+
+static void writeJSONArray(const std::vector<size_t> &values,
+                           OutputSink &out) {
+  out << "[";
+  std::string_view sep = "";
+  for (size_t value : values) {
+    out << sep << value;
+    sep = ", ";
+  }
+  out << "]";
+}
+
+void writeMetricsJSON(const CollectionMetrics &metrics, OutputSink &out) {
+  std::string ratio = getHardSoftRatio(metrics);
+  out << "{\"modules\": " << metrics.modules.size()
+      << ",\n\"topics\": " << metrics.numTopics
+      << ",\n\"hardEdges\": " << metrics.hardEdges
+      << ",\n\"softEdges\": " << metrics.softEdges
+      << ",\n\"danglingEdges\": " << metrics.danglingEdges
+      << ",\n\"crossModuleHardEdges\": " << metrics.crossModuleHardEdges
+      << ",\n\"crossModuleSoftEdges\": " << metrics.crossModuleSoftEdges
+      << ",\n\"crossModuleHardSoftRatio\": "
+      << (ratio.empty() ? "null" : ratio)
+      << ",\n\"moduleCycles\": " << metrics.moduleCycles
+      << ",\n\"modulesInCycles\": " << metrics.modulesInCycles
+      << ",\n\"moduleMetrics\": [";
+  std::string_view sep = "\n";
+  for (auto &module : metrics.modules) {
+    out << sep << "{\"name\": " << escapeJSONString(module.name)
+        << ", \"mid\": " << module.moduleID
+        << ", \"topics\": " << module.numTopics
+        << ", \"fanIn\": " << module.fanIn << ", \"fanOut\": " << module.fanOut
+        << ", \"incomingEdges\": " << module.incomingEdges
+        << ", \"outgoingEdges\": " << module.outgoingEdges
+        << ", \"longestChain\": " << module.longestChain << "}";
+    sep = ",\n";
+  }
+  out << "\n],\n\"inDegrees\": ";
+  writeJSONArray(metrics.inDegrees, out);
+  out << ",\n\"outDegrees\": ";
+  writeJSONArray(metrics.outDegrees, out);
+  out << "}\n";
+}
+
+} // namespace sg20
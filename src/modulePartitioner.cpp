@@ -0,0 +1,102 @@
+#include "sg20_graphgen/modules.h"
+#include "sg20_graphgen/output_sink.h"
+#include "sg20_graphgen/partition.h"
+#include "sg20_graphgen/serialization.h"
+
+#include "yaml-cpp/exceptions.h"
+
+#include "absl/flags/flag.h"
+#include "absl/flags/parse.h"
+#include "absl/flags/usage.h"
+#include "absl/strings/str_cat.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <iostream>
+#include <stdexcept>
+
+ABSL_FLAG(std::string, graph_yaml, "sg20_graph.yaml",
+          "path to the yaml specification file.");
+ABSL_FLAG(std::string, output, "sg20_partition.txt",
+          "filename for the proposal. Files ending in .yaml, .json, .msgpack, "
+          "or .mpk get the repartitioned collection, all others a yamlEditor "
+          "script that applies the proposal.");
+ABSL_FLAG(int, parts, 0,
+          "Number of modules to propose, 0 to keep the number of modules.");
+ABSL_FLAG(double, imbalance, 0.05,
+          "Allowed excess of the largest module over the average number of "
+          "topics per module.");
+ABSL_FLAG(bool, fromScratch, false,
+          "Partition the topics from scratch instead of starting from the "
+          "current modules.");
+
+static bool isCollectionFile(const std::filesystem::path &filepath) {
+  auto extension = filepath.extension();
+  return extension == ".yaml" || extension == ".yml" || extension == ".json" ||
+         extension == ".msgpack" || extension == ".mpk";
+}
+
+int main(int argc, char *argv[]) {
+  absl::SetProgramUsageMessage(absl::StrCat(
+      "Propose a reassignment of SG20 topics to modules with balanced sizes "
+      "and few dependencies between modules.\n\n",
+      "Example usage: ", argv[0],
+      " --output partition.txt && yamlEditor --output new.yaml < "
+      "partition.txt"));
+  absl::ParseCommandLine(argc, argv);
+
+  auto yamlInputFile = std::filesystem::path(absl::GetFlag(FLAGS_graph_yaml));
+  if (!std::filesystem::exists(yamlInputFile)) {
+    std::cerr << "Yaml input file does not exist."
+              << "\n";
+    return 1;
+  }
+
+  try {
+    auto MC = sg20::ModuleCollection::loadModulesFromFile(yamlInputFile);
+
+    sg20::PartitionOptions options;
+    options.numParts = absl::GetFlag(FLAGS_parts);
+    options.imbalance = absl::GetFlag(FLAGS_imbalance);
+    options.keepModules = !absl::GetFlag(FLAGS_fromScratch);
+    auto proposal = sg20::computePartition(MC, options);
+
+    size_t movedTopics = std::count_if(
+        proposal.topics.begin(), proposal.topics.end(), [&](auto &topic) {
+          return proposal.parts[topic.part].moduleID != topic.moduleID;
+        });
+    int largestModule = 0;
+    for (auto &part : proposal.parts) {
+      largestModule = std::max(largestModule, part.numTopics);
+    }
+    std::cout << "Dependencies between modules: " << proposal.cutBefore
+              << " -> " << proposal.cutAfter << "\n";
+    std::cout << "Moved topics: " << movedTopics << " of "
+              << proposal.topics.size() << ", largest module: "
+              << largestModule << " topics\n";
+
+    std::filesystem::path outputFilename(absl::GetFlag(FLAGS_output));
+    if (isCollectionFile(outputFilename)) {
+      sg20::applyPartition(MC, proposal);
+      std::cout << "Storing modules into " << outputFilename << "\n";
+      sg20::ModuleCollection::storeModulesToFile(MC, outputFilename);
+    } else {
+      std::cout << "Storing yamlEditor script into " << outputFilename << "\n";
+      sg20::OutputSink outputFile(outputFilename);
+      sg20::OutputSinkStream outputStream(outputFile);
+      sg20::writePartitionScript(proposal, outputStream);
+      outputFile.finish(outputFilename);
+    }
+  } catch (YAML::Exception &e) {
+    std::cerr << "Syntax error in YAML " << yamlInputFile << std::endl;
+    std::cerr << "Got: " << e.what() << std::endl;
+  } catch (sg20::ParseError &e) {
+    std::cerr << "Syntax error in " << yamlInputFile << std::endl;
+    std::cerr << "Got: " << e.what() << std::endl;
+  } catch (std::runtime_error &e) {
+    std::cerr << "Error: " << e.what() << std::endl;
+    return 1;
+  }
+
+  return 0;
+}
@@ -1,4 +1,7 @@
 #include "sg20_graphgen/modules.h"
+#include "sg20_graphgen/emitters.h"
+#include "sg20_graphgen/serialization.h"
+#include "sg20_graphgen/traversal.h"
 #include "sg20_graphgen/util.h"
 
 #include "yaml-cpp/emitter.h"
@@ -7,10 +10,16 @@
 #include "yaml-cpp/yaml.h"
 
 #include <algorithm>
-#include <cassert>
+#include <charconv>
 #include <fstream>
 #include <iostream>
 #include <memory>
+#include <optional>
+#include <stdexcept>
+#include <string_view>
+#include <thread>
+#include <tuple>
+#include <unordered_set>
 
 namespace sg20 {
 
@@ -21,12 +30,24 @@ void Topic::dump(std::ostream &out) {
     out << sep << dep;
     sep = ", ";
   }
-  out << "] - SoftDeps";
+  out << "] - SoftDeps: [";
   sep = "";
   for (auto dep : softDeps) {
     out << sep << dep;
     sep = ", ";
   }
+  out << "] - Dependents: [";
+  sep = "";
+  for (auto dep : revDeps) {
+    out << sep << dep;
+    sep = ", ";
+  }
+  out << "] - SoftDependents: [";
+  sep = "";
+  for (auto dep : revSoftDeps) {
+    out << sep << dep;
+    sep = ", ";
+  }
   out << "]\n";
 }
 
@@ -51,6 +72,7 @@ Topic *Module::getTopicByID(int topicID) const {
 }
 
 void Module::removeTopic(const std::string_view topicName) {
+  loadTopics();
   auto delTopicIter = std::find_if(
       topics_list.begin(), topics_list.end(),
       [topicName](auto &topic) { return topic->getName() == topicName; });
@@ -59,6 +81,45 @@ void Module::removeTopic(const std::string_view topicName) {
   }
 }
 
+void Module::removeTopic(int topicID) {
+  loadTopics();
+  auto delTopicIter = std::find_if(
+      topics_list.begin(), topics_list.end(),
+      [topicID](auto &topic) { return topic->getID() == topicID; });
+  if (delTopicIter != topics_list.end()) {
+    topics_list.erase(delTopicIter);
+  }
+}
+
+std::unique_ptr<Topic> Module::takeTopic(int topicID) {
+  loadTopics();
+  auto takeTopicIter = std::find_if(
+      topics_list.begin(), topics_list.end(),
+      [topicID](auto &topic) { return topic->getID() == topicID; });
+  if (takeTopicIter == topics_list.end()) {
+    return nullptr;
+  }
+  std::unique_ptr<Topic> topic = std::move(*takeTopicIter);
+  topics_list.erase(takeTopicIter);
+  return topic;
+}
+
+std::vector<std::unique_ptr<Topic>>
+Module::takeTopics(const std::function<bool(const Topic &)> &takeIf) {
+  loadTopics();
+  std::vector<std::unique_ptr<Topic>> taken;
+  auto kept = topics_list.begin();
+  for (auto &topic : topics_list) {
+    if (takeIf(*topic)) {
+      taken.push_back(std::move(topic));
+    } else {
+      *kept++ = std::move(topic);
+    }
+  }
+  topics_list.erase(kept, topics_list.end());
+  return taken;
+}
+
 void Module::dump(std::ostream &out) {
   out << "ModuleName: " << getModuleName() << " ID: " << getModuleID() << "\n";
   out << "  Topics: \n";
@@ -69,133 +130,880 @@ void Module::dump(std::ostream &out) {
   out << "\n";
 }
 
+std::string readFileContents(const std::filesystem::path &filepath) {
+  std::ifstream inputFile(filepath, std::ios::binary);
+  if (!inputFile) {
+    throw ParseError("Could not open " + filepath.string());
+  }
+
+  std::string contents;
+  contents.resize(std::filesystem::file_size(filepath));
+  inputFile.read(contents.data(), contents.size());
+  contents.resize(inputFile.gcount());
+  return contents;
+}
+
+static bool isJSONFile(const std::filesystem::path &filepath) {
+  return filepath.extension() == ".json";
+}
+
+static bool isMsgPackFile(const std::filesystem::path &filepath) {
+  return filepath.extension() == ".msgpack" || filepath.extension() == ".mpk";
+}
+
+// Throws a ParseError if the node is neither a sequence nor empty. Iterating
+// over other nodes silently yields nothing, which would drop parts of the file.
+static void checkYAMLSequence(const YAML::Node &node, std::string_view key) {
+  if (!node.IsSequence() && !node.IsNull()) {
+    throw ParseError("YAML file broken, " + std::string(key) +
+                     " is not a sequence (line " +
+                     std::to_string(node.Mark().line + 1) + ")");
+  }
+}
+
+static void checkYAMLMap(const YAML::Node &node, std::string_view what) {
+  if (!node.IsMap()) {
+    throw ParseError("YAML file broken, " + std::string(what) +
+                     " is not a map (line " +
+                     std::to_string(node.Mark().line + 1) + ")");
+  }
+}
+
+// Reads the topics of a yaml module. addTopic(name, ID) adds a topic and
+// returns it, addDependency(topic, depID, kind) adds one of its dependencies.
+template <typename AddTopicFnTy, typename AddDependencyFnTy>
+static void readYAMLTopics(const YAML::Node &yamlModule, AddTopicFnTy addTopic,
+                           AddDependencyFnTy addDependency) {
+  auto sub = yamlModule["sub"];
+  if (!sub) {
+    return;
+  }
+  checkYAMLSequence(sub, "sub");
+  for (auto subval : sub) {
+    checkYAMLMap(subval, "topic");
+    Topic &newTopic =
+        addTopic(subval["name"].as<std::string>(), subval["tid"].as<int>());
+    if (auto deps = subval["dep"]) {
+      checkYAMLSequence(deps, "dep");
+      for (auto yamldepID : deps) {
+        addDependency(newTopic, yamldepID.as<int>(), DependencyKind::Hard);
+      }
+    }
+    if (auto softDeps = subval["softdep"]) {
+      checkYAMLSequence(softDeps, "softdep");
+      for (auto yamldepID : softDeps) {
+        addDependency(newTopic, yamldepID.as<int>(), DependencyKind::Soft);
+      }
+    }
+  }
+}
+
+static std::optional<ModuleCollection>
+loadYAMLModulesInParallel(std::string_view contents, bool alwaysSplit);
+
 ModuleCollection
 ModuleCollection::loadModulesFromFile(std::filesystem::path filepath) {
-  ModuleCollection newMCollection;
-  YAML::Node file = YAML::LoadFile(filepath);
+  if (isJSONFile(filepath)) {
+    return loadModulesFromJSON(readFileContents(filepath));
+  }
+  if (isMsgPackFile(filepath)) {
+    return loadModulesFromMsgPack(readFileContents(filepath));
+  }
+  return loadModulesFromYAML(readFileContents(filepath));
+}
 
+ModuleCollection loadModulesFromYAML(std::string_view input,
+                                     YAMLSplitting splitting) {
+  if (splitting != YAMLSplitting::Never) {
+    if (auto collection = loadYAMLModulesInParallel(
+            input, splitting == YAMLSplitting::Always)) {
+      return std::move(*collection);
+    }
+  }
+
+  ModuleCollection::Builder builder;
+  YAML::Node file = YAML::Load(std::string(input));
+  checkYAMLMap(file, "file");
   auto yamlModules = file["Modules"];
-  assert(yamlModules.IsSequence() &&
-         "YAML file brocken, modules was not a sequence");
+  if (!yamlModules || !yamlModules.IsSequence()) {
+    throw ParseError("YAML file broken, Modules is not a sequence");
+  }
 
   for (auto yamlModule : yamlModules) {
-    newMCollection.modules_storage.push_back(std::make_unique<Module>(
-        yamlModule["name"].as<std::string>(), yamlModule["mid"].as<int>()));
-    auto module = newMCollection.modules_storage.back().get();
-
-    auto sub = yamlModule["sub"];
-    for (auto subval : sub) {
-      Topic &newTopic = module->addTopic(subval["name"].as<std::string>(),
-                                         subval["tid"].as<int>());
-      if (subval["dep"]) {
-        for (auto yamldepID : subval["dep"]) {
-          newTopic.addDependency(yamldepID.as<int>());
-        }
+    checkYAMLMap(yamlModule, "module");
+    Module &module = builder.addModule(yamlModule["name"].as<std::string>(),
+                                       yamlModule["mid"].as<int>());
+    readYAMLTopics(
+        yamlModule,
+        [&](std::string name, int topicID) -> Topic & {
+          return builder.addTopic(module, std::move(name), topicID);
+        },
+        [&](Topic &topic, int depID, DependencyKind kind) {
+          builder.addDependency(topic, depID, kind);
+        });
+  }
+
+  return builder.finish();
+}
+
+void ModuleCollection::storeModulesToFile(const ModuleCollection &MC,
+                                          std::filesystem::path filepath) {
+  // The file may be the source of a lazily loaded collection.
+  MC.loadAllModules();
+
+  OutputSink outputFile(filepath);
+  if (isJSONFile(filepath)) {
+    JSONEmitter jsonEmitter(outputFile);
+    traverseModuleCollection(MC, jsonEmitter);
+  } else if (isMsgPackFile(filepath)) {
+    MsgPackEmitter msgPackEmitter(outputFile);
+    traverseModuleCollection(MC, msgPackEmitter);
+  } else {
+    YAMLEmitter yamlEmitter(outputFile);
+    traverseModuleCollection(MC, yamlEmitter);
+  }
+  outputFile.finish(filepath);
+}
+
+//===----------------------------------------------------------------------===//
+// Yaml module scanning
+
+namespace {
+
+// Part of a yaml file with one item of the Modules sequence.
+struct ScannedModule {
+  std::string_view text;
+  // Start of the item up to its topics, i.e., the name and the ID.
+  std::string_view header;
+};
+
+struct ScannedFile {
+  std::vector<ScannedModule> modules;
+  // Topic IDs with the index of their module, in file order.
+  std::vector<std::pair<int, uint32_t>> topicModules;
+};
+
+size_t getIndentation(std::string_view line) {
+  size_t indentation = line.find_first_not_of(' ');
+  return indentation == std::string_view::npos ? line.size() : indentation;
+}
+
+bool isBlankOrComment(std::string_view line) {
+  size_t indentation = getIndentation(line);
+  return indentation == line.size() || line[indentation] == '#' ||
+         line[indentation] == '\r';
+}
+
+bool isSequenceItem(std::string_view line, size_t indentation) {
+  return indentation < line.size() && line[indentation] == '-' &&
+         (indentation + 1 == line.size() || line[indentation + 1] == ' ' ||
+          line[indentation + 1] == '\r');
+}
+
+// Returns the key part of a line of a block mapping, without the indentation
+// and sequence item markers.
+std::string_view getKeyPart(std::string_view line) {
+  size_t start = getIndentation(line);
+  while (isSequenceItem(line, start)) {
+    start = line.find_first_not_of(' ', start + 1);
+    if (start == std::string_view::npos) {
+      return {};
+    }
+  }
+  return line.substr(start);
+}
+
+bool startsWith(std::string_view str, std::string_view prefix) {
+  return str.substr(0, prefix.size()) == prefix;
+}
+
+// Whether the line has a "key:" of a block mapping. Other lines that are not
+// sequence items continue a multi-line scalar.
+bool hasMappingKey(std::string_view keyPart) {
+  for (size_t colon = keyPart.find(':'); colon != std::string_view::npos;
+       colon = keyPart.find(':', colon + 1)) {
+    if (colon + 1 == keyPart.size() || keyPart[colon + 1] == ' ' ||
+        keyPart[colon + 1] == '\r') {
+      return true;
+    }
+  }
+  return false;
+}
+
+// Splits the yaml file into the items of its top-level Modules sequence by
+// indentation only, and collects the topic IDs of every item. Returns
+// std::nullopt for layouts this simple scan cannot handle, e.g., flow style
+// modules or topics, and if the rest of the file is broken, so the complete
+// load reports the error.
+std::optional<ScannedFile> scanYAMLModules(std::string_view contents) {
+  ScannedFile scanned;
+  size_t pos = 0;
+  auto nextLine = [&contents, &pos](std::string_view &line) {
+    if (pos >= contents.size()) {
+      return false;
+    }
+    size_t end = contents.find('\n', pos);
+    end = end == std::string_view::npos ? contents.size() : end;
+    line = contents.substr(pos, end - pos);
+    pos = end + 1;
+    return true;
+  };
+
+  std::string_view line;
+  bool foundModules = false;
+  while (!foundModules && nextLine(line)) {
+    if (startsWith(line, "Modules:")) {
+      if (!isBlankOrComment(line.substr(8))) {
+        return std::nullopt; // flow style sequence
       }
-      if (subval["softdep"]) {
-        for (auto yamldepID : subval["softdep"]) {
-          newTopic.addSoftDependency(yamldepID.as<int>());
-        }
+      foundModules = true;
+    }
+  }
+  if (!foundModules) {
+    return std::nullopt;
+  }
+
+  std::optional<size_t> itemIndentation;
+  size_t itemStart = 0;
+  size_t headerEnd = 0;
+  bool inHeader = false;
+  auto finishItem = [&](size_t itemEnd) {
+    std::string_view text = contents.substr(itemStart, itemEnd - itemStart);
+    scanned.modules.push_back(
+        {text, inHeader ? text : text.substr(0, headerEnd - itemStart)});
+  };
+
+  size_t lineStart = pos;
+  while (nextLine(line)) {
+    if (isBlankOrComment(line)) {
+      lineStart = pos;
+      continue;
+    }
+
+    size_t indentation = getIndentation(line);
+    if (!itemIndentation) {
+      if (!isSequenceItem(line, indentation)) {
+        return std::nullopt;
       }
+      itemIndentation = indentation;
+    } else if (indentation < *itemIndentation ||
+               (indentation == *itemIndentation &&
+                !isSequenceItem(line, indentation))) {
+      break; // end of the Modules sequence
+    } else if (indentation == *itemIndentation) {
+      finishItem(lineStart);
     }
+
+    if (indentation == *itemIndentation) {
+      itemStart = lineStart;
+      inHeader = true;
+    }
+
+    std::string_view keyPart = getKeyPart(line);
+    if (startsWith(keyPart, "{") || startsWith(keyPart, "[")) {
+      return std::nullopt; // flow style module or topic
+    }
+    if (!isSequenceItem(line, indentation) && !hasMappingKey(keyPart)) {
+      return std::nullopt; // may continue across a module boundary
+    }
+    if (startsWith(keyPart, "sub:")) {
+      if (!isBlankOrComment(keyPart.substr(4))) {
+        return std::nullopt; // flow style topic list
+      }
+      if (inHeader && lineStart != itemStart) {
+        headerEnd = lineStart;
+        inHeader = false;
+      }
+    }
+    if (startsWith(keyPart, "tid:")) {
+      std::string_view value = keyPart.substr(4);
+      value.remove_prefix(std::min(value.size(), getIndentation(value)));
+      int topicID = 0;
+      auto [end, error] =
+          std::from_chars(value.data(), value.data() + value.size(), topicID);
+      if (error != std::errc() ||
+          !isBlankOrComment(value.substr(end - value.data()))) {
+        return std::nullopt;
+      }
+      scanned.topicModules.emplace_back(topicID, scanned.modules.size());
+    }
+    lineStart = pos;
   }
+  if (!itemIndentation) {
+    return scanned;
+  }
+  size_t sequenceEnd = std::min(lineStart, contents.size());
+  finishItem(sequenceEnd);
 
-  return newMCollection;
+  // The lines around the sequence may still break the file, e.g., a line
+  // that ends the sequence early. Check them with a single placeholder item.
+  size_t sequenceStart = scanned.modules.front().text.data() - contents.data();
+  std::string skeleton(contents.substr(0, sequenceStart));
+  skeleton.append(*itemIndentation, ' ').append("- ~\n");
+  skeleton.append(contents.substr(sequenceEnd));
+  try {
+    const YAML::Node file = YAML::Load(skeleton);
+    if (!file.IsMap() || !file["Modules"] || !file["Modules"].IsSequence() ||
+        file["Modules"].size() != 1) {
+      return std::nullopt;
+    }
+  } catch (YAML::Exception &) {
+    return std::nullopt;
+  }
+  return scanned;
 }
 
-void ModuleCollection::storeModulesToFile(const ModuleCollection &MC,
-                                          std::filesystem::path filepath) {
-  YAML::Emitter yamlOut;
-  yamlOut << YAML::BeginDoc;
-  {
-    YAMLMap modulesMap(yamlOut);
-    yamlOut << "Modules";
-    yamlOut << YAML::BeginSeq;
-    for (auto &module : MC.modules()) {
-      YAMLMap moduleMap(yamlOut);
-
-      yamlOut << "name" << module->getModuleName();
-      yamlOut << "mid" << module->getModuleID();
-      yamlOut << "sub" << YAML::BeginSeq;
+} // namespace
 
-      for (auto &topic : module->topics()) {
-        YAMLMap yamlTopicMap(yamlOut);
+//===----------------------------------------------------------------------===//
+// Parallel yaml loading
 
-        yamlOut << "name" << topic->getName();
-        yamlOut << "tid" << topic->getID();
+// Splits the Modules sequence into chunks of consecutive modules, which are
+// parsed on all hardware threads and spliced into the collection in file
+// order. Returns std::nullopt on a single hardware thread, if the file cannot
+// be split, or if one of the chunks has an error, so the complete load can
+// report it.
+static std::optional<ModuleCollection>
+loadYAMLModulesInParallel(std::string_view contents, bool alwaysSplit) {
+  size_t numThreads = std::max(std::thread::hardware_concurrency(), 1u);
+  if (numThreads <= 1 && !alwaysSplit) {
+    return std::nullopt; // nothing to gain from splitting
+  }
+  auto scanned = scanYAMLModules(contents);
+  if (!scanned || scanned->modules.empty()) {
+    return std::nullopt;
+  }
 
-        if (topic->numDependencies()) {
-          yamlOut << "dep";
+  // A few chunks per thread even out differences in parsing speed, but
+  // chunks should not get so small that the per-document overhead shows.
+  constexpr size_t minChunkSize = 64 * 1024;
+  size_t chunkSize = std::max(minChunkSize, contents.size() / (4 * numThreads));
 
-          yamlOut << YAML::BeginSeq;
-          for (auto dep : topic->dependencies()) {
-            yamlOut << dep;
-          }
-          yamlOut << YAML::EndSeq;
-        }
+  struct Chunk {
+    std::string_view text;
+    size_t numModules = 0;
+    bool failed = false;
+    std::vector<std::unique_ptr<Module>> modules;
+    std::vector<std::tuple<Topic *, int, DependencyKind>> deps;
+  };
+  std::vector<Chunk> chunks;
+  for (auto &scannedModule : scanned->modules) {
+    if (chunks.empty() || chunks.back().text.size() >= chunkSize) {
+      chunks.emplace_back();
+      chunks.back().text = scannedModule.text;
+    } else {
+      std::string_view &text = chunks.back().text;
+      text = std::string_view(text.data(), scannedModule.text.data() +
+                                               scannedModule.text.size() -
+                                               text.data());
+    }
+    ++chunks.back().numModules;
+  }
 
-        if (topic->numSoftDependencies()) {
-          yamlOut << "softdep";
-          yamlOut << YAML::BeginSeq;
-          for (auto dep : topic->softDependencies()) {
-            yamlOut << dep;
-          }
-          yamlOut << YAML::EndSeq;
+  parallelFor(chunks.size(), [&chunks](size_t index) {
+    Chunk &chunk = chunks[index];
+    try {
+      YAML::Node yamlModules = YAML::Load(std::string(chunk.text));
+      if (!yamlModules.IsSequence() ||
+          yamlModules.size() != chunk.numModules) {
+        chunk.failed = true;
+        return;
+      }
+      for (auto yamlModule : yamlModules) {
+        checkYAMLMap(yamlModule, "module");
+        auto &module = chunk.modules.emplace_back(std::make_unique<Module>(
+            yamlModule["name"].as<std::string>(), yamlModule["mid"].as<int>()));
+        readYAMLTopics(
+            yamlModule,
+            [&](std::string name, int topicID) -> Topic & {
+              return module->addTopic(std::move(name), topicID);
+            },
+            [&](Topic &topic, int depID, DependencyKind kind) {
+              chunk.deps.emplace_back(&topic, depID, kind);
+            });
+      }
+    } catch (YAML::Exception &) {
+      chunk.failed = true;
+    } catch (ParseError &) {
+      chunk.failed = true;
+    }
+  });
+
+  ModuleCollection::Builder builder;
+  for (auto &chunk : chunks) {
+    if (chunk.failed) {
+      return std::nullopt;
+    }
+    for (auto &module : chunk.modules) {
+      builder.addModule(std::move(module));
+    }
+    for (auto &[topic, depID, kind] : chunk.deps) {
+      builder.addDependency(*topic, depID, kind);
+    }
+  }
+  return builder.finish();
+}
+
+//===----------------------------------------------------------------------===//
+// Module by module yaml loading
+
+static std::unique_ptr<Module> readYAMLModule(const YAML::Node &yamlModule) {
+  checkYAMLMap(yamlModule, "module");
+  auto module = std::make_unique<Module>(yamlModule["name"].as<std::string>(),
+                                         yamlModule["mid"].as<int>());
+  readYAMLTopics(
+      yamlModule,
+      [&](std::string name, int topicID) -> Topic & {
+        return module->addTopic(std::move(name), topicID);
+      },
+      [](Topic &topic, int depID, DependencyKind kind) {
+        if (kind == DependencyKind::Hard) {
+          topic.addDependency(depID);
+        } else {
+          topic.addSoftDependency(depID);
         }
+      });
+  return module;
+}
+
+void forEachYAMLModule(
+    std::string_view contents,
+    const std::function<void(const Module &, std::string_view)> &readModule,
+    const std::function<void(std::string_view)> &parsePart) {
+  if (auto scanned = scanYAMLModules(contents)) {
+    scanned->topicModules.clear();
+    scanned->topicModules.shrink_to_fit();
+    for (auto &scannedModule : scanned->modules) {
+      if (parsePart) {
+        parsePart(scannedModule.text);
+      }
+      YAML::Node yamlModules = YAML::Load(std::string(scannedModule.text));
+      if (!yamlModules.IsSequence() || yamlModules.size() != 1) {
+        throw ParseError("YAML file broken, could not split the Modules "
+                         "sequence at module boundaries");
       }
-      yamlOut << YAML::EndSeq;
+      readModule(*readYAMLModule(yamlModules[0]), scannedModule.text);
     }
-    yamlOut << YAML::EndSeq;
+    return;
   }
-  yamlOut << YAML::EndDoc;
 
-  assert(yamlOut.good() && "Generated YAML was wrongly formated.");
+  if (parsePart) {
+    parsePart(contents);
+  }
+  YAML::Node file = YAML::Load(std::string(contents));
+  checkYAMLMap(file, "file");
+  auto yamlModules = file["Modules"];
+  if (!yamlModules || !yamlModules.IsSequence()) {
+    throw ParseError("YAML file broken, Modules is not a sequence");
+  }
+  for (auto yamlModule : yamlModules) {
+    readModule(*readYAMLModule(yamlModule), {});
+  }
+}
+
+//===----------------------------------------------------------------------===//
+// ModuleCollection::LazyLoader
+
+// Keeps the yaml source of the modules whose topics were not accessed yet, and
+// links their topics into the collection when they are.
+class ModuleCollection::LazyLoader {
+public:
+  LazyLoader(std::string contents) : contents(std::move(contents)) {}
+
+  // Creates the modules of the file without their topics. Returns false if
+  // the file has to be loaded completely.
+  bool addModules(ModuleCollection &moduleCollection) {
+    collection = &moduleCollection;
+    auto scanned = scanYAMLModules(contents);
+    if (!scanned) {
+      return false;
+    }
+
+    for (auto &scannedModule : scanned->modules) {
+      YAML::Node header = YAML::Load(std::string(scannedModule.header));
+      if (!header.IsSequence() || header.size() != 1 || !header[0]["name"] ||
+          !header[0]["mid"]) {
+        return false;
+      }
+      Module &module = collection->appendModule(
+          std::make_unique<Module>(header[0]["name"].as<std::string>(),
+                                   header[0]["mid"].as<int>()));
+      collection->moduleIDs.reserve(header[0]["mid"].as<int>());
+      uint32_t index = sources.size();
+      module.setTopicLoader([this, index](Module &) { loadModule(index); });
+      sources.push_back({&module, scannedModule.text});
+    }
+
+    // Stable, so the first module using a topic ID comes first, like in the
+    // topic index of completely loaded collections.
+    topicModules = std::move(scanned->topicModules);
+    std::stable_sort(topicModules.begin(), topicModules.end(),
+                     [](auto &lhs, auto &rhs) { return lhs.first < rhs.first; });
+    for (auto &[topicID, module] : topicModules) {
+      collection->topicIDs.reserve(topicID);
+    }
+    return true;
+  }
+
+  // Loads the module that contains the topic. Returns false if no module
+  // contains it or the module was already loaded.
+  bool loadModuleOfTopic(int topicID) {
+    auto owner = findOwner(topicID);
+    if (!owner || sources[*owner].module->areTopicsLoaded()) {
+      return false;
+    }
+    ensureLoaded(*owner);
+    return true;
+  }
 
-  std::ofstream outputFile(filepath);
-  outputFile << yamlOut.c_str();
+  void loadAll() {
+    for (uint32_t index = 0; index < sources.size(); ++index) {
+      ensureLoaded(index);
+    }
+  }
+
+  ModuleCollection *collection = nullptr;
+
+private:
+  struct ModuleSource {
+    Module *module;
+    std::string_view text;
+  };
+
+  struct PendingDependency {
+    Topic *topic;
+    DependencyKind kind;
+  };
+
+  std::optional<uint32_t> findOwner(int topicID) const {
+    auto owner = std::lower_bound(
+        topicModules.begin(), topicModules.end(), topicID,
+        [](auto &entry, int topicID) { return entry.first < topicID; });
+    if (owner == topicModules.end() || owner->first != topicID) {
+      return std::nullopt;
+    }
+    return owner->second;
+  }
+
+  void ensureLoaded(uint32_t index) {
+    Module &module = *sources[index].module;
+    if (!module.areTopicsLoaded()) {
+      module.setTopicLoader(nullptr);
+      loadModule(index);
+    }
+  }
+
+  static void link(Topic &topic, Topic &target, DependencyKind kind) {
+    if (kind == DependencyKind::Hard) {
+      topic.addDependency(target);
+    } else {
+      topic.addSoftDependency(target);
+    }
+  }
+
+  void loadModule(uint32_t index) {
+    Module &module = *sources[index].module;
+    YAML::Node yamlModules = YAML::Load(std::string(sources[index].text));
+    readYAMLTopics(
+        yamlModules[0],
+        [&](std::string name, int topicID) -> Topic & {
+          Topic &newTopic = module.addTopic(std::move(name), topicID);
+          if (findOwner(topicID) != index) {
+            return newTopic; // duplicate of a topic ID used before
+          }
+          collection->topicIndex.try_emplace(topicID,
+                                             TopicLocation{&module, &newTopic});
+          // Link the dependencies of loaded topics that were waiting for it.
+          if (auto waiting = pendingDeps.find(topicID);
+              waiting != pendingDeps.end()) {
+            for (auto &[topic, kind] : waiting->second) {
+              link(*topic, newTopic, kind);
+            }
+            pendingDeps.erase(waiting);
+          }
+          return newTopic;
+        },
+        [&](Topic &topic, int depID, DependencyKind kind) {
+          auto dep = collection->topicIndex.find(depID);
+          if (dep != collection->topicIndex.end()) {
+            link(topic, *dep->second.topic, kind);
+            return;
+          }
+          if (kind == DependencyKind::Hard) {
+            topic.addDependency(depID);
+          } else {
+            topic.addSoftDependency(depID);
+          }
+          if (findOwner(depID)) {
+            pendingDeps[depID].push_back({&topic, kind});
+          }
+        });
+  }
+
+  const std::string contents;
+  std::vector<ModuleSource> sources;
+  std::vector<std::pair<int, uint32_t>> topicModules;
+  std::unordered_map<int, std::vector<PendingDependency>> pendingDeps;
+};
+
+ModuleCollection
+ModuleCollection::loadModulesLazilyFromFile(std::filesystem::path filepath) {
+  if (isJSONFile(filepath) || isMsgPackFile(filepath)) {
+    return loadModulesFromFile(filepath);
+  }
+
+  ModuleCollection collection;
+  auto loader = std::make_unique<LazyLoader>(readFileContents(filepath));
+  try {
+    if (!loader->addModules(collection)) {
+      return loadModulesFromFile(filepath);
+    }
+  } catch (YAML::Exception &) {
+    // Let the complete load report the error.
+    return loadModulesFromFile(filepath);
+  }
+  collection.lazyLoader = std::move(loader);
+  return collection;
 }
 
-Module *ModuleCollection::getModuleFromTopicID(int topicID) const {
+ModuleCollection::ModuleCollection() = default;
+
+ModuleCollection::ModuleCollection(ModuleCollection &&other) noexcept
+    : modules_storage(std::move(other.modules_storage)),
+      moduleIndex(std::move(other.moduleIndex)),
+      topicIndex(std::move(other.topicIndex)),
+      lazyLoader(std::move(other.lazyLoader)),
+      moduleIDs(std::move(other.moduleIDs)),
+      topicIDs(std::move(other.topicIDs)) {
+  if (lazyLoader) {
+    lazyLoader->collection = this;
+  }
+}
+
+ModuleCollection &
+ModuleCollection::operator=(ModuleCollection &&other) noexcept {
+  modules_storage = std::move(other.modules_storage);
+  moduleIndex = std::move(other.moduleIndex);
+  topicIndex = std::move(other.topicIndex);
+  lazyLoader = std::move(other.lazyLoader);
+  moduleIDs = std::move(other.moduleIDs);
+  topicIDs = std::move(other.topicIDs);
+  if (lazyLoader) {
+    lazyLoader->collection = this;
+  }
+  return *this;
+}
+
+ModuleCollection::~ModuleCollection() = default;
+
+void ModuleCollection::loadAllModules() const {
+  if (lazyLoader) {
+    lazyLoader->loadAll();
+    lazyLoader.reset();
+  }
+}
+
+ModuleCollection ModuleCollection::clone() const {
+  // Topics are copied with their dependencies and dependents, so nothing has
+  // to be linked again.
+  ModuleCollection copy;
+  copy.topicIndex.reserve(topicIndex.size());
   for (auto &module : modules()) {
-    auto *topic = module->findTopic(topicID);
-    if (topic) {
-      return module.get();
+    auto moduleCopy = std::make_unique<Module>(module->getModuleName(),
+                                               module->getModuleID());
+    for (auto &topic : module->topics()) {
+      Topic &topicCopy = moduleCopy->addTopic(std::make_unique<Topic>(*topic));
+      copy.topicIndex.try_emplace(topic->getID(),
+                                  TopicLocation{moduleCopy.get(), &topicCopy});
     }
+    copy.appendModule(std::move(moduleCopy));
   }
-  return nullptr;
+  copy.moduleIDs = moduleIDs;
+  copy.topicIDs = topicIDs;
+  return copy;
 }
 
-Module *ModuleCollection::getModuleFromName(std::string_view moduleName) const {
-  for (auto &module : modules()) {
-    if (module->getModuleName().compare(0, moduleName.length(), moduleName) ==
-        0) {
-      return module.get();
+//===----------------------------------------------------------------------===//
+// ModuleCollection::Builder
+
+Module &ModuleCollection::Builder::addModule(std::string moduleName,
+                                             int moduleID) {
+  collection.moduleIDs.reserve(moduleID);
+  return collection.appendModule(
+      std::make_unique<Module>(std::move(moduleName), moduleID));
+}
+
+Module &
+ModuleCollection::Builder::addModule(std::unique_ptr<Module> module) {
+  for (auto &topic : module->topics()) {
+    collection.topicIndex.try_emplace(topic->getID(),
+                                      TopicLocation{module.get(), topic.get()});
+    recordTopicID(topic->getID());
+  }
+  collection.moduleIDs.reserve(module->getModuleID());
+  return collection.appendModule(std::move(module));
+}
+
+Topic &ModuleCollection::Builder::addTopic(Module &module,
+                                           std::string topicName, int topicID) {
+  Topic &newTopic = module.addTopic(std::move(topicName), topicID);
+  collection.topicIndex.try_emplace(topicID, TopicLocation{&module, &newTopic});
+  recordTopicID(topicID);
+  return newTopic;
+}
+
+void ModuleCollection::Builder::recordTopicID(int topicID) {
+  collection.topicIDs.reserve(topicID);
+  minTopicID = std::min(minTopicID, topicID);
+  maxTopicID = std::max(maxTopicID, topicID);
+}
+
+ModuleCollection ModuleCollection::Builder::finish() {
+  // With dense IDs, as written by all emitters, the dependencies are resolved
+  // through an array indexed by ID instead of a hash lookup each.
+  std::vector<Topic *> topicsByID;
+  size_t numTopics = collection.topicIndex.size();
+  if (numTopics > 0 && minTopicID >= 0 &&
+      static_cast<size_t>(maxTopicID) < 2 * numTopics + 1024) {
+    topicsByID.resize(static_cast<size_t>(maxTopicID) + 1, nullptr);
+    for (auto &[topicID, location] : collection.topicIndex) {
+      topicsByID[topicID] = location.topic;
+    }
+  }
+  auto findTopic = [&](int topicID) -> Topic * {
+    if (topicsByID.empty()) {
+      return collection.getTopicFromID(topicID);
     }
+    return topicID >= 0 && static_cast<size_t>(topicID) < topicsByID.size()
+               ? topicsByID[topicID]
+               : nullptr;
+  };
+
+  for (auto &[topic, depID, kind] : pendingDeps) {
+    Topic *depTopic = findTopic(depID);
+    if (!depTopic) {
+      // New topics must not take the ID of a missing dependency.
+      collection.topicIDs.reserve(depID);
+    }
+    if (kind == DependencyKind::Hard) {
+      if (depTopic) {
+        topic->addDependency(*depTopic);
+      } else {
+        topic->addDependency(depID);
+      }
+    } else {
+      if (depTopic) {
+        topic->addSoftDependency(*depTopic);
+      } else {
+        topic->addSoftDependency(depID);
+      }
+    }
+  }
+  pendingDeps.clear();
+
+  return std::move(collection);
+}
+
+Module *ModuleCollection::getModuleFromTopicID(int topicID) const {
+  auto found = topicIndex.find(topicID);
+  if (found == topicIndex.end() && lazyLoader &&
+      lazyLoader->loadModuleOfTopic(topicID)) {
+    found = topicIndex.find(topicID);
+  }
+  if (found != topicIndex.end()) {
+    return found->second.module;
   }
   return nullptr;
 }
 
-Module *ModuleCollection::getModuleFromID(int moduleID) const {
+Topic *ModuleCollection::getTopicFromID(int topicID) const {
+  auto found = topicIndex.find(topicID);
+  if (found == topicIndex.end() && lazyLoader &&
+      lazyLoader->loadModuleOfTopic(topicID)) {
+    found = topicIndex.find(topicID);
+  }
+  if (found != topicIndex.end()) {
+    return found->second.topic;
+  }
+  return nullptr;
+}
+
+Module *ModuleCollection::getModuleFromName(std::string_view moduleName) const {
+  // An exact match wins over modules whose name only starts with moduleName.
+  Module *prefixMatch = nullptr;
   for (auto &module : modules()) {
-    if (module->getModuleID() == moduleID) {
+    if (module->getModuleName() == moduleName) {
       return module.get();
     }
+    if (!prefixMatch && module->getModuleName().compare(
+                            0, moduleName.length(), moduleName) == 0) {
+      prefixMatch = module.get();
+    }
   }
-  return nullptr;
+  return prefixMatch;
+}
+
+Module *ModuleCollection::getModuleFromID(int moduleID) const {
+  auto found = moduleIndex.find(moduleID);
+  return found != moduleIndex.end() ? found->second : nullptr;
 }
 
 Module &ModuleCollection::addModule(std::string moduleName) {
-  modules_storage.push_back(
-      std::make_unique<Module>(std::move(moduleName), getNextFreeModuleID()));
-  return *modules_storage.back().get();
+  return appendModule(
+      std::make_unique<Module>(std::move(moduleName), moduleIDs.allocate()));
+}
+
+Module &ModuleCollection::appendModule(std::unique_ptr<Module> module) {
+  moduleIndex.try_emplace(module->getModuleID(), module.get());
+  modules_storage.push_back(std::move(module));
+  return *modules_storage.back();
 }
 
 void ModuleCollection::deleteModule(int moduleID) {
+  if (Module *module = getModuleFromID(moduleID)) {
+    deleteModule(*module);
+  }
+}
+
+void ModuleCollection::deleteModule(Module &module) {
+  // Unlinking needs the reverse edges from all modules.
+  loadAllModules();
   auto delModuleIter = std::find_if(
       modules_storage.begin(), modules_storage.end(),
-      [moduleID](auto &module) { return module->getModuleID() == moduleID; });
-  if (delModuleIter != modules_storage.end()) {
-    modules_storage.erase(delModuleIter);
+      [&module](auto &candidate) { return candidate.get() == &module; });
+  if (delModuleIter == modules_storage.end()) {
+    return;
+  }
+
+  int moduleID = module.getModuleID();
+  for (auto &topic : module.topics()) {
+    unlinkTopic(*topic);
+  }
+  std::vector<int> unindexedIDs;
+  for (auto &topic : module.topics()) {
+    auto indexed = topicIndex.find(topic->getID());
+    if (indexed != topicIndex.end() && indexed->second.topic == topic.get()) {
+      topicIndex.erase(indexed);
+      unindexedIDs.push_back(topic->getID());
+    }
+  }
+  bool wasIndexed = getModuleFromID(moduleID) == &module;
+  modules_storage.erase(delModuleIter);
+  reindexTopicIDs(unindexedIDs);
+
+  // Another module with the same ID takes over the index entry, the ID is
+  // only free if there is none.
+  if (wasIndexed) {
+    moduleIndex.erase(moduleID);
+    for (auto &candidate : modules()) {
+      if (candidate->getModuleID() == moduleID) {
+        moduleIndex.emplace(moduleID, candidate.get());
+        break;
+      }
+    }
+    if (!moduleIndex.count(moduleID)) {
+      moduleIDs.release(moduleID);
+    }
   }
 }
 
@@ -211,38 +1019,210 @@ Topic *ModuleCollection::addTopicToModule(std::string topicName,
 
 Topic *ModuleCollection::addTopicToModule(std::string topicName,
                                           Module &module) {
-  return &module.addTopic(std::move(topicName), getNextFreeTopicID());
+  Topic &newTopic = module.addTopic(std::move(topicName), topicIDs.allocate());
+  topicIndex.try_emplace(newTopic.getID(), TopicLocation{&module, &newTopic});
+  return &newTopic;
 }
 
-int ModuleCollection::getNextFreeModuleID() const {
-  if (modules_storage.size() == 0) {
-    return 1;
+void ModuleCollection::deleteTopic(int topicID) {
+  loadAllModules();
+  auto indexed = topicIndex.find(topicID);
+  if (indexed != topicIndex.end()) {
+    deleteTopic(*indexed->second.module, *indexed->second.topic);
   }
-  auto &module = *std::max_element(
-      modules_begin(), modules_end(), [](auto &module1, auto &module2) {
-        return module1->getModuleID() < module2->getModuleID();
-      });
-  return module->getModuleID() + 1;
 }
 
-int ModuleCollection::getNextFreeTopicID() const {
-  int maxID = 0;
+void ModuleCollection::deleteTopic(Module &module, Topic &topic) {
+  loadAllModules();
+  int topicID = topic.getID();
+  unlinkTopic(topic);
+  // Topics with an ID used before are not indexed, their ID stays in use.
+  auto indexed = topicIndex.find(topicID);
+  bool wasIndexed =
+      indexed != topicIndex.end() && indexed->second.topic == &topic;
+  if (wasIndexed) {
+    topicIndex.erase(indexed);
+  }
+  // Other topics of the module may have the same ID.
+  module.takeTopics(
+      [&topic](const Topic &candidate) { return &candidate == &topic; });
+  if (wasIndexed) {
+    reindexTopicIDs({topicID});
+  }
+}
 
+void ModuleCollection::reindexTopicIDs(const std::vector<int> &unindexedIDs) {
+  std::unordered_set<int> unclaimed(unindexedIDs.begin(), unindexedIDs.end());
+  // Only topics that share their ID with another one are not indexed, so
+  // without such topics no other topic can have one of the IDs.
+  if (numTopics() > topicIndex.size()) {
+    for (auto &module : modules()) {
+      for (auto &topic : module->topics()) {
+        if (unclaimed.erase(topic->getID())) {
+          topicIndex.emplace(topic->getID(),
+                             TopicLocation{module.get(), topic.get()});
+        }
+      }
+      if (unclaimed.empty()) {
+        break;
+      }
+    }
+  }
+  for (int topicID : unclaimed) {
+    topicIDs.release(topicID);
+  }
+}
+
+Topic *ModuleCollection::moveTopic(int topicID, Module &target) {
+  auto indexed = topicIndex.find(topicID);
+  if (indexed == topicIndex.end() && lazyLoader &&
+      lazyLoader->loadModuleOfTopic(topicID)) {
+    indexed = topicIndex.find(topicID);
+  }
+  if (indexed == topicIndex.end()) {
+    return nullptr;
+  }
+
+  auto [module, topic] = indexed->second;
+  moveTopic(*module, *topic, target);
+  return topic;
+}
+
+void ModuleCollection::moveTopic(Module &source, Topic &topic,
+                                 Module &target) {
+  if (&source == &target) {
+    return;
+  }
+  auto taken = source.takeTopics(
+      [&topic](const Topic &candidate) { return &candidate == &topic; });
+  for (auto &takenTopic : taken) {
+    target.addTopic(std::move(takenTopic));
+  }
+  auto indexed = topicIndex.find(topic.getID());
+  if (indexed != topicIndex.end() && indexed->second.topic == &topic) {
+    indexed->second.module = &target;
+  }
+}
+
+void ModuleCollection::moveTopics(
+    const std::vector<std::pair<int, Module *>> &moves) {
+  loadAllModules();
+
+  std::vector<TopicMove> topicMoves;
+  topicMoves.reserve(moves.size());
+  for (auto &[topicID, target] : moves) {
+    auto indexed = topicIndex.find(topicID);
+    if (indexed != topicIndex.end()) {
+      topicMoves.push_back(
+          {indexed->second.module, indexed->second.topic, target});
+    }
+  }
+  moveTopics(topicMoves);
+}
+
+void ModuleCollection::moveTopics(const std::vector<TopicMove> &moves) {
+  loadAllModules();
+
+  std::unordered_map<const Topic *, Module *> targets;
+  std::unordered_set<const Module *> sources;
+  for (auto &move : moves) {
+    if (move.source == move.target) {
+      continue;
+    }
+    sources.insert(move.source);
+    targets[move.topic] = move.target;
+    auto indexed = topicIndex.find(move.topic->getID());
+    if (indexed != topicIndex.end() && indexed->second.topic == move.topic) {
+      indexed->second.module = move.target;
+    }
+  }
+
+  // Topics appended to a module that is handled later stay in it, as their
+  // target is that module.
   for (auto &module : modules()) {
-    if (module->numTopics() == 0) {
+    if (!sources.count(module.get())) {
       continue;
     }
-    auto &localMaxTopic =
-        *std::max_element(module->topics_begin(), module->topics_end(),
-                          [](auto &topic1, auto &topic2) {
-                            return topic1->getID() < topic2->getID();
-                          });
-    if (localMaxTopic->getID() > maxID) {
-      maxID = localMaxTopic->getID();
+    auto taken = module->takeTopics([&](const Topic &topic) {
+      auto target = targets.find(&topic);
+      return target != targets.end() && target->second != module.get();
+    });
+    for (auto &topic : taken) {
+      targets[topic.get()]->addTopic(std::move(topic));
     }
   }
+}
 
-  return maxID + 1;
+void ModuleCollection::compactIDs() {
+  loadAllModules();
+
+  // Dependencies resolve to the first topic with an ID, like the topic index.
+  std::unordered_map<int, int> newTopicIDs;
+  newTopicIDs.reserve(topicIndex.size());
+  int numTopics = 0;
+  for (auto &module : modules()) {
+    for (auto &topic : module->topics()) {
+      newTopicIDs.try_emplace(topic->getID(), ++numTopics);
+    }
+  }
+  auto mapDependency = [&newTopicIDs, &numTopics](int depID) {
+    // Missing topics are appended, so they do not clash with existing ones.
+    auto [it, inserted] = newTopicIDs.try_emplace(depID, numTopics + 1);
+    if (inserted) {
+      ++numTopics;
+    }
+    return it->second;
+  };
+
+  Builder builder;
+  int nextModuleID = 0;
+  int nextTopicID = 0;
+  for (auto &module : modules()) {
+    Module &newModule =
+        builder.addModule(module->getModuleName(), ++nextModuleID);
+    for (auto &topic : module->topics()) {
+      Topic &newTopic =
+          builder.addTopic(newModule, topic->getName(), ++nextTopicID);
+      for (int dep : topic->dependencies()) {
+        builder.addDependency(newTopic, mapDependency(dep),
+                              DependencyKind::Hard);
+      }
+      for (int dep : topic->softDependencies()) {
+        builder.addDependency(newTopic, mapDependency(dep),
+                              DependencyKind::Soft);
+      }
+    }
+  }
+  *this = builder.finish();
+}
+
+void ModuleCollection::unlinkTopic(Topic &topic) {
+  // Copy the edge lists, as unlinking modifies them while we iterate.
+  std::vector<int> dependents(topic.rev_deps_begin(), topic.rev_deps_end());
+  std::vector<int> softDependents(topic.rev_soft_begin(), topic.rev_soft_end());
+  std::vector<int> deps(topic.deps_begin(), topic.deps_end());
+  std::vector<int> softDeps(topic.soft_begin(), topic.soft_end());
+
+  for (int srcID : dependents) {
+    if (Topic *src = getTopicFromID(srcID)) {
+      src->removeDependency(topic);
+    }
+  }
+  for (int srcID : softDependents) {
+    if (Topic *src = getTopicFromID(srcID)) {
+      src->removeSoftDependency(topic);
+    }
+  }
+  for (int depID : deps) {
+    if (Topic *dep = getTopicFromID(depID)) {
+      topic.removeDependency(*dep);
+    }
+  }
+  for (int depID : softDeps) {
+    if (Topic *dep = getTopicFromID(depID)) {
+      topic.removeSoftDependency(*dep);
+    }
+  }
 }
 
 } // namespace sg20
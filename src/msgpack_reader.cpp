@@ -0,0 +1,376 @@
+#include "sg20_graphgen/serialization.h"
+
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace sg20 {
+
+namespace {
+
+// Reads the MessagePack encoding of the module schema, see MsgPackEmitter.
+class MsgPackReader {
+public:
+  MsgPackReader(std::string_view input)
+      : begin(reinterpret_cast<const uint8_t *>(input.data())), cur(begin),
+        end(begin + input.size()) {}
+
+  ModuleCollection read() {
+    bool foundModules = false;
+    for (size_t i = 0, e = readMapHeader(); i < e; ++i) {
+      if (readString() == "Modules") {
+        for (size_t j = 0, f = readArrayHeader(); j < f; ++j) {
+          parseModule();
+        }
+        foundModules = true;
+      } else {
+        skipValue(0);
+      }
+    }
+
+    if (cur != end) {
+      error("unexpected data after the document");
+    }
+    if (!foundModules) {
+      error("missing Modules");
+    }
+    return builder.finish();
+  }
+
+private:
+  struct ParsedTopic {
+    std::string name;
+    std::optional<int> tid;
+    std::vector<int> deps;
+    std::vector<int> softDeps;
+  };
+
+  static constexpr int MaxNestingDepth = 256;
+
+  [[noreturn]] void error(std::string_view msg) const {
+    throw ParseError("MessagePack: " + std::string(msg) + " (offset " +
+                     std::to_string(cur - begin) + ")");
+  }
+
+  void need(size_t bytes) const {
+    if (static_cast<size_t>(end - cur) < bytes) {
+      error("unexpected end of input");
+    }
+  }
+
+  uint8_t readByte() {
+    need(1);
+    return *cur++;
+  }
+
+  uint64_t readBigEndian(size_t bytes) {
+    need(bytes);
+    uint64_t value = 0;
+    for (size_t i = 0; i < bytes; ++i) {
+      value = (value << 8) | *cur++;
+    }
+    return value;
+  }
+
+  size_t readMapHeader() {
+    uint8_t tag = readByte();
+    if ((tag & 0xF0) == 0x80) {
+      return tag & 0x0F;
+    }
+    if (tag == 0xDE) {
+      return readBigEndian(2);
+    }
+    if (tag == 0xDF) {
+      return readBigEndian(4);
+    }
+    error("expected a map");
+  }
+
+  size_t readArrayHeader() {
+    uint8_t tag = readByte();
+    if ((tag & 0xF0) == 0x90) {
+      return tag & 0x0F;
+    }
+    if (tag == 0xDC) {
+      return readBigEndian(2);
+    }
+    if (tag == 0xDD) {
+      return readBigEndian(4);
+    }
+    error("expected an array");
+  }
+
+  // The returned view points into the input buffer.
+  std::string_view readString() {
+    uint8_t tag = readByte();
+    size_t length;
+    if ((tag & 0xE0) == 0xA0) {
+      length = tag & 0x1F;
+    } else if (tag == 0xD9) {
+      length = readBigEndian(1);
+    } else if (tag == 0xDA) {
+      length = readBigEndian(2);
+    } else if (tag == 0xDB) {
+      length = readBigEndian(4);
+    } else {
+      error("expected a string");
+    }
+    need(length);
+    std::string_view str(reinterpret_cast<const char *>(cur), length);
+    cur += length;
+    return str;
+  }
+
+  int readInt() {
+    uint8_t tag = readByte();
+    int64_t value;
+    if (tag <= 0x7F) {
+      value = tag;
+    } else if (tag >= 0xE0) {
+      value = static_cast<int8_t>(tag);
+    } else if (tag >= 0xCC && tag <= 0xCF) {
+      uint64_t unsignedValue = readBigEndian(size_t(1) << (tag - 0xCC));
+      if (unsignedValue >
+          static_cast<uint64_t>(std::numeric_limits<int>::max())) {
+        error("integer out of range");
+      }
+      value = static_cast<int64_t>(unsignedValue);
+    } else if (tag >= 0xD0 && tag <= 0xD3) {
+      size_t bytes = size_t(1) << (tag - 0xD0);
+      uint64_t raw = readBigEndian(bytes);
+      // sign extend
+      unsigned shift = 64 - 8 * bytes;
+      value = static_cast<int64_t>(raw << shift) >> shift;
+    } else {
+      error("expected an integer");
+    }
+
+    if (value < std::numeric_limits<int>::min() ||
+        value > std::numeric_limits<int>::max()) {
+      error("integer out of range");
+    }
+    return static_cast<int>(value);
+  }
+
+  // Topics and dependencies go straight to the builder as soon as the name
+  // and ID of their module or topic are known, which is the case for all files
+  // written by MsgPackEmitter. Otherwise they are buffered until the end of the
+  // map.
+  void parseModule() {
+    std::string_view name;
+    bool hasName = false;
+    std::optional<int> mid;
+    Module *module = nullptr;
+    topics.clear();
+
+    for (size_t i = 0, e = readMapHeader(); i < e; ++i) {
+      std::string_view key = readString();
+      if (key == "name" || key == "mid") {
+        if (module) {
+          error("module name or mid after its topics");
+        }
+        if (key == "name") {
+          name = readString();
+          hasName = true;
+        } else {
+          mid = readInt();
+        }
+      } else if (key == "sub") {
+        if (!module && hasName && mid) {
+          module = &builder.addModule(std::string(name), *mid);
+        }
+        for (size_t j = 0, f = readArrayHeader(); j < f; ++j) {
+          parseTopic(module);
+        }
+      } else {
+        skipValue(0);
+      }
+    }
+    if (!hasName || !mid) {
+      error("module is missing name or mid");
+    }
+
+    if (!module) {
+      module = &builder.addModule(std::string(name), *mid);
+    }
+    for (auto &parsedTopic : topics) {
+      Topic &topic = builder.addTopic(*module, std::move(parsedTopic.name),
+                                      *parsedTopic.tid);
+      for (int dep : parsedTopic.deps) {
+        builder.addDependency(topic, dep, DependencyKind::Hard);
+      }
+      for (int dep : parsedTopic.softDeps) {
+        builder.addDependency(topic, dep, DependencyKind::Soft);
+      }
+    }
+  }
+
+  // Adds the topic to the module, or buffers it if the module is not known
+  // yet.
+  void parseTopic(Module *module) {
+    std::string_view name;
+    bool hasName = false;
+    std::optional<int> tid;
+    Topic *topic = nullptr;
+    depBuffer.clear();
+    softDepBuffer.clear();
+
+    for (size_t i = 0, e = readMapHeader(); i < e; ++i) {
+      std::string_view key = readString();
+      if (key == "name" || key == "tid") {
+        if (topic) {
+          error("topic name or tid after its dependencies");
+        }
+        if (key == "name") {
+          name = readString();
+          hasName = true;
+        } else {
+          tid = readInt();
+        }
+      } else if (key == "dep" || key == "softdep") {
+        DependencyKind kind =
+            key == "dep" ? DependencyKind::Hard : DependencyKind::Soft;
+        if (!topic && module && hasName && tid) {
+          topic = &builder.addTopic(*module, std::string(name), *tid);
+        }
+        std::vector<int> &buffer =
+            kind == DependencyKind::Hard ? depBuffer : softDepBuffer;
+        for (size_t j = 0, f = readArrayHeader(); j < f; ++j) {
+          int dep = readInt();
+          if (topic) {
+            builder.addDependency(*topic, dep, kind);
+          } else {
+            buffer.push_back(dep);
+          }
+        }
+      } else {
+        skipValue(0);
+      }
+    }
+    if (!hasName || !tid) {
+      error("topic is missing name or tid");
+    }
+
+    if (!module) {
+      topics.push_back({std::string(name), tid, depBuffer, softDepBuffer});
+      return;
+    }
+    if (!topic) {
+      topic = &builder.addTopic(*module, std::string(name), *tid);
+    }
+    for (int dep : depBuffer) {
+      builder.addDependency(*topic, dep, DependencyKind::Hard);
+    }
+    for (int dep : softDepBuffer) {
+      builder.addDependency(*topic, dep, DependencyKind::Soft);
+    }
+  }
+
+  void skipBytes(uint64_t bytes) {
+    need(bytes);
+    cur += bytes;
+  }
+
+  void skipValue(int depth) {
+    if (depth > MaxNestingDepth) {
+      error("nesting too deep");
+    }
+
+    uint8_t tag = readByte();
+    if (tag <= 0x7F || tag >= 0xE0 || tag == 0xC0 || tag == 0xC2 ||
+        tag == 0xC3) {
+      return; // fixint, nil, bool
+    }
+    if ((tag & 0xF0) == 0x80 || tag == 0xDE || tag == 0xDF) {
+      --cur;
+      for (size_t i = 0, e = readMapHeader(); i < e; ++i) {
+        skipValue(depth + 1);
+        skipValue(depth + 1);
+      }
+      return;
+    }
+    if ((tag & 0xF0) == 0x90 || tag == 0xDC || tag == 0xDD) {
+      --cur;
+      for (size_t i = 0, e = readArrayHeader(); i < e; ++i) {
+        skipValue(depth + 1);
+      }
+      return;
+    }
+    if ((tag & 0xE0) == 0xA0) {
+      skipBytes(tag & 0x1F);
+      return;
+    }
+
+    switch (tag) {
+    case 0xC4: // bin 8
+    case 0xD9: // str 8
+      skipBytes(readBigEndian(1));
+      return;
+    case 0xC5: // bin 16
+    case 0xDA: // str 16
+      skipBytes(readBigEndian(2));
+      return;
+    case 0xC6: // bin 32
+    case 0xDB: // str 32
+      skipBytes(readBigEndian(4));
+      return;
+    case 0xC7: // ext 8
+      skipBytes(readBigEndian(1) + 1);
+      return;
+    case 0xC8: // ext 16
+      skipBytes(readBigEndian(2) + 1);
+      return;
+    case 0xC9: // ext 32
+      skipBytes(readBigEndian(4) + 1);
+      return;
+    case 0xCA: // float 32
+      skipBytes(4);
+      return;
+    case 0xCB: // float 64
+      skipBytes(8);
+      return;
+    case 0xCC: // uint 8-64
+    case 0xCD:
+    case 0xCE:
+    case 0xCF:
+      skipBytes(size_t(1) << (tag - 0xCC));
+      return;
+    case 0xD0: // int 8-64
+    case 0xD1:
+    case 0xD2:
+    case 0xD3:
+      skipBytes(size_t(1) << (tag - 0xD0));
+      return;
+    case 0xD4: // fixext 1-16
+    case 0xD5:
+    case 0xD6:
+    case 0xD7:
+    case 0xD8:
+      skipBytes(1 + (size_t(1) << (tag - 0xD4)));
+      return;
+    default:
+      error("invalid type tag");
+    }
+  }
+
+  const uint8_t *begin;
+  const uint8_t *cur;
+  const uint8_t *end;
+
+  ModuleCollection::Builder builder;
+  // Topics of a module whose name or mid comes after them.
+  std::vector<ParsedTopic> topics;
+  // Dependencies of a topic whose name or tid comes after them.
+  std::vector<int> depBuffer;
+  std::vector<int> softDepBuffer;
+};
+
+} // namespace
+
+ModuleCollection loadModulesFromMsgPack(std::string_view input) {
+  return MsgPackReader(input).read();
+}
+
+} // namespace sg20
@@ -0,0 +1,119 @@
+#include "sg20_graphgen/output_sink.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <iostream>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+namespace sg20 {
+
+// Buffers smaller than this would not fit the formatted integers.
+static constexpr size_t MinBufferSize = 64;
+
+OutputSink::OutputSink(const std::filesystem::path &path, size_t bufferSize)
+    : buffer(new char[std::max(bufferSize, MinBufferSize)]),
+      capacity(std::max(bufferSize, MinBufferSize)) {
+  if (isStandardOutput(path)) {
+    // Keep the order with everything written to std::cout before.
+    std::cout.flush();
+    fd = STDOUT_FILENO;
+    return;
+  }
+
+  fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0666);
+  ownsFD = fd >= 0;
+  failed = fd < 0;
+}
+
+OutputSink::OutputSink(int fd, size_t bufferSize)
+    : fd(fd), buffer(new char[std::max(bufferSize, MinBufferSize)]),
+      capacity(std::max(bufferSize, MinBufferSize)) {}
+
+OutputSink::OutputSink(std::ostream &stream, size_t bufferSize)
+    : stream(&stream), buffer(new char[std::max(bufferSize, MinBufferSize)]),
+      capacity(std::max(bufferSize, MinBufferSize)) {}
+
+OutputSink::~OutputSink() {
+  flush();
+  if (ownsFD) {
+    ::close(fd);
+  }
+}
+
+void OutputSink::flush() {
+  if (used == 0) {
+    return;
+  }
+  iovec vector = {buffer.get(), used};
+  writeVectors(&vector, 1);
+  used = 0;
+}
+
+void OutputSink::finish(const std::filesystem::path &path) {
+  flush();
+  if (failed) {
+    throw std::runtime_error(
+        "Could not write " +
+        (isStandardOutput(path) ? "the standard output" : path.string()));
+  }
+}
+
+void OutputSink::writeSlow(std::string_view str) {
+  if (str.size() >= capacity / 2) {
+    iovec vectors[2] = {{buffer.get(), used},
+                        {const_cast<char *>(str.data()), str.size()}};
+    writeVectors(vectors, 2);
+    used = 0;
+    return;
+  }
+
+  // Fill up the buffer, the rest fits after flushing it.
+  size_t head = capacity - used;
+  std::memcpy(buffer.get() + used, str.data(), head);
+  used = capacity;
+  flush();
+  std::memcpy(buffer.get(), str.data() + head, str.size() - head);
+  used = str.size() - head;
+}
+
+void OutputSink::writeVectors(iovec *vectors, int count) {
+  if (failed) {
+    return;
+  }
+  if (stream) {
+    for (int index = 0; index < count; ++index) {
+      stream->write(static_cast<const char *>(vectors[index].iov_base),
+                    vectors[index].iov_len);
+    }
+    failed = !stream->good();
+    return;
+  }
+
+  // writev may write less than requested, e.g., into pipes, so the vectors
+  // are advanced past the written bytes until everything is written.
+  while (count > 0) {
+    ssize_t written = ::writev(fd, vectors, count);
+    if (written < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      failed = true;
+      return;
+    }
+    while (count > 0 && static_cast<size_t>(written) >= vectors->iov_len) {
+      written -= vectors->iov_len;
+      ++vectors;
+      --count;
+    }
+    if (count > 0) {
+      vectors->iov_base = static_cast<char *>(vectors->iov_base) + written;
+      vectors->iov_len -= written;
+    }
+  }
+}
+
+} // namespace sg20
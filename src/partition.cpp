@@ -0,0 +1,755 @@
+#include "sg20_graphgen/partition.h"
+#include "sg20_graphgen/util.h"
+
+#include "absl/strings/str_cat.h"
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <queue>
+#include <random>
+#include <tuple>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+
+namespace sg20 {
+
+namespace {
+
+// Undirected graph in compressed sparse row format. Parallel edges are merged
+// into one edge with the sum of their weights.
+struct Graph {
+  struct Edge {
+    int target;
+    int weight;
+  };
+
+  std::vector<int> nodeWeights;
+  std::vector<size_t> offsets;
+  std::vector<Edge> edges;
+
+  size_t numNodes() const { return nodeWeights.size(); }
+  auto neighbors(int node) const {
+    return make_range(edges.begin() + offsets[node],
+                      edges.begin() + offsets[node + 1]);
+  }
+};
+
+template <typename FnTy> void forEachNode(size_t n, bool parallel, FnTy fn) {
+  if (parallel) {
+    parallelFor(n, fn);
+  } else {
+    for (size_t node = 0; node < n; ++node) {
+      fn(node);
+    }
+  }
+}
+
+// Sorts the edges of every node by target and merges parallel edges. Node u
+// starts with numEdges[u] edges at offsets[u], the edges are compacted
+// afterwards.
+void mergeParallelEdges(Graph &graph, std::vector<size_t> &numEdges) {
+  parallelFor(graph.numNodes(), [&](size_t node) {
+    auto first = graph.edges.begin() + graph.offsets[node];
+    auto last = first + numEdges[node];
+    std::sort(first, last,
+              [](auto &lhs, auto &rhs) { return lhs.target < rhs.target; });
+    auto merged = first;
+    for (auto edge = first; edge != last; ++edge) {
+      if (merged != first && (merged - 1)->target == edge->target) {
+        (merged - 1)->weight += edge->weight;
+      } else {
+        *merged++ = *edge;
+      }
+    }
+    numEdges[node] = merged - first;
+  });
+
+  size_t compacted = 0;
+  for (size_t node = 0; node < graph.numNodes(); ++node) {
+    size_t begin = graph.offsets[node];
+    graph.offsets[node] = compacted;
+    std::move(graph.edges.begin() + begin,
+              graph.edges.begin() + begin + numEdges[node],
+              graph.edges.begin() + compacted);
+    compacted += numEdges[node];
+  }
+  graph.offsets[graph.numNodes()] = compacted;
+  graph.edges.resize(compacted);
+  graph.edges.shrink_to_fit();
+}
+
+int64_t computeCut(const Graph &graph, const std::vector<int> &part) {
+  int64_t cut = 0;
+  for (size_t node = 0; node < graph.numNodes(); ++node) {
+    for (auto &edge : graph.neighbors(node)) {
+      if (part[edge.target] != part[node]) {
+        cut += edge.weight;
+      }
+    }
+  }
+  return cut / 2;
+}
+
+//===----------------------------------------------------------------------===//
+// Coarsening
+
+struct CoarseLevel {
+  Graph graph;
+  // Coarse node of every node of the next finer level.
+  std::vector<int> coarseNodes;
+  // Label of every coarse node, if the matching was restricted by labels.
+  std::vector<int> labels;
+};
+
+// Contracts a heavy edge matching of the graph. Nodes are only matched with
+// nodes of the same label, if labels are given, and if their combined weight
+// does not exceed maxNodeWeight. Nodes without edges are matched with each
+// other.
+CoarseLevel coarsen(const Graph &graph, const std::vector<int> &labels,
+                    int maxNodeWeight, std::mt19937 &rng) {
+  size_t numNodes = graph.numNodes();
+  std::vector<int> order(numNodes);
+  std::iota(order.begin(), order.end(), 0);
+  std::shuffle(order.begin(), order.end(), rng);
+
+  auto haveSameLabel = [&labels](int lhs, int rhs) {
+    return labels.empty() || labels[lhs] == labels[rhs];
+  };
+  CoarseLevel level;
+  level.coarseNodes.assign(numNodes, -1);
+  std::vector<std::pair<int, int>> members;
+  std::unordered_map<int, int> unmatchedIsolated; // by label
+  for (int node : order) {
+    if (level.coarseNodes[node] >= 0) {
+      continue;
+    }
+    int mate = -1;
+    int mateEdgeWeight = 0;
+    for (auto &edge : graph.neighbors(node)) {
+      int candidate = edge.target;
+      if (level.coarseNodes[candidate] >= 0 ||
+          !haveSameLabel(node, candidate) ||
+          graph.nodeWeights[node] + graph.nodeWeights[candidate] >
+              maxNodeWeight) {
+        continue;
+      }
+      if (edge.weight > mateEdgeWeight ||
+          (edge.weight == mateEdgeWeight &&
+           graph.nodeWeights[candidate] < graph.nodeWeights[mate])) {
+        mate = candidate;
+        mateEdgeWeight = edge.weight;
+      }
+    }
+
+    if (mate < 0 && graph.offsets[node] == graph.offsets[node + 1]) {
+      int label = labels.empty() ? 0 : labels[node];
+      auto isolated = unmatchedIsolated.try_emplace(label, node);
+      if (isolated.second) {
+        continue; // wait for another isolated node with the same label
+      }
+      mate = isolated.first->second;
+      unmatchedIsolated.erase(isolated.first);
+      if (graph.nodeWeights[node] + graph.nodeWeights[mate] > maxNodeWeight) {
+        level.coarseNodes[mate] = members.size();
+        members.emplace_back(mate, -1);
+        mate = -1;
+      }
+    }
+
+    level.coarseNodes[node] = members.size();
+    if (mate >= 0) {
+      level.coarseNodes[mate] = members.size();
+    }
+    members.emplace_back(node, mate);
+  }
+  for (auto [label, node] : unmatchedIsolated) {
+    level.coarseNodes[node] = members.size();
+    members.emplace_back(node, -1);
+  }
+
+  // Every coarse node gets room for the edges of its members, which are then
+  // renamed, stripped of the contracted edge, and merged.
+  size_t numCoarseNodes = members.size();
+  Graph &coarse = level.graph;
+  coarse.nodeWeights.resize(numCoarseNodes);
+  coarse.offsets.resize(numCoarseNodes + 1);
+  std::vector<size_t> numEdges(numCoarseNodes);
+  size_t numCoarseEdges = 0;
+  for (size_t coarseNode = 0; coarseNode < numCoarseNodes; ++coarseNode) {
+    auto [first, second] = members[coarseNode];
+    coarse.nodeWeights[coarseNode] = graph.nodeWeights[first];
+    coarse.offsets[coarseNode] = numCoarseEdges;
+    numCoarseEdges += graph.offsets[first + 1] - graph.offsets[first];
+    if (second >= 0) {
+      coarse.nodeWeights[coarseNode] += graph.nodeWeights[second];
+      numCoarseEdges += graph.offsets[second + 1] - graph.offsets[second];
+    }
+  }
+  coarse.offsets[numCoarseNodes] = numCoarseEdges;
+  coarse.edges.resize(numCoarseEdges);
+
+  parallelFor(numCoarseNodes, [&](size_t coarseNode) {
+    size_t edge = coarse.offsets[coarseNode];
+    for (int member : {members[coarseNode].first, members[coarseNode].second}) {
+      if (member < 0) {
+        continue;
+      }
+      for (auto &fineEdge : graph.neighbors(member)) {
+        int target = level.coarseNodes[fineEdge.target];
+        if (target != static_cast<int>(coarseNode)) {
+          coarse.edges[edge++] = {target, fineEdge.weight};
+        }
+      }
+    }
+    numEdges[coarseNode] = edge - coarse.offsets[coarseNode];
+  });
+  mergeParallelEdges(coarse, numEdges);
+
+  if (!labels.empty()) {
+    level.labels.resize(numCoarseNodes);
+    for (size_t coarseNode = 0; coarseNode < numCoarseNodes; ++coarseNode) {
+      level.labels[coarseNode] = labels[members[coarseNode].first];
+    }
+  }
+  return level;
+}
+
+//===----------------------------------------------------------------------===//
+// Refinement
+
+// Partition of a graph into k parts, of which none may be heavier than
+// maxPartWeight.
+class Partition {
+public:
+  Partition(const Graph &graph, std::vector<int> part, int numParts,
+            int64_t maxPartWeight)
+      : graph(graph), part(std::move(part)), partWeights(numParts, 0),
+        maxPartWeight(maxPartWeight) {
+    for (size_t node = 0; node < graph.numNodes(); ++node) {
+      partWeights[this->part[node]] += graph.nodeWeights[node];
+    }
+  }
+
+  std::vector<int> takeParts() { return std::move(part); }
+
+  // Moves nodes out of the parts that are too heavy, preferring the nodes
+  // that cut the fewest edges when moved.
+  void rebalance();
+
+  // Runs k-way Fiduccia-Mattheyses passes until a pass does not reduce the
+  // cut. In every pass, each node moves at most once, to the neighboring part
+  // with the highest gain, also if the gain is negative. The pass is rolled
+  // back to the smallest cut it reached.
+  void refine(int maxPasses, bool parallel);
+
+private:
+  struct Move {
+    int64_t gain;
+    int target; // -1 if the node cannot move
+  };
+
+  // Returns the best move of the node to a neighboring part that has room for
+  // it. If there is none, the target is -1 and the gain is the one of a move
+  // to a part without edges to the node.
+  Move findBestMove(int node) const;
+  void moveNode(int node, int target) {
+    partWeights[part[node]] -= graph.nodeWeights[node];
+    partWeights[target] += graph.nodeWeights[node];
+    part[node] = target;
+  }
+  bool hasRoom(int targetPart, int node) const {
+    return partWeights[targetPart] + graph.nodeWeights[node] <= maxPartWeight;
+  }
+
+  const Graph &graph;
+  std::vector<int> part;
+  std::vector<int64_t> partWeights;
+  int64_t maxPartWeight;
+};
+
+Partition::Move Partition::findBestMove(int node) const {
+  // Edge weights to every part, the counters are reused by all calls of a
+  // thread and reset after each one.
+  thread_local std::vector<int64_t> connectivity;
+  thread_local std::vector<int> touchedParts;
+  connectivity.resize(std::max(connectivity.size(), partWeights.size()));
+
+  for (auto &edge : graph.neighbors(node)) {
+    int targetPart = part[edge.target];
+    if (connectivity[targetPart] == 0) {
+      touchedParts.push_back(targetPart);
+    }
+    connectivity[targetPart] += edge.weight;
+  }
+
+  int ownPart = part[node];
+  int64_t ownConnectivity = connectivity[ownPart];
+  int bestTarget = -1;
+  int64_t bestConnectivity = 0;
+  for (int targetPart : touchedParts) {
+    if (targetPart == ownPart || !hasRoom(targetPart, node)) {
+      continue;
+    }
+    if (bestTarget < 0 || connectivity[targetPart] > bestConnectivity ||
+        (connectivity[targetPart] == bestConnectivity &&
+         partWeights[targetPart] < partWeights[bestTarget])) {
+      bestTarget = targetPart;
+      bestConnectivity = connectivity[targetPart];
+    }
+  }
+  for (int targetPart : touchedParts) {
+    connectivity[targetPart] = 0;
+  }
+  touchedParts.clear();
+
+  return {bestConnectivity - ownConnectivity, bestTarget};
+}
+
+void Partition::rebalance() {
+  if (std::all_of(partWeights.begin(), partWeights.end(),
+                  [this](int64_t weight) { return weight <= maxPartWeight; })) {
+    return;
+  }
+
+  // Nodes that cannot move to a neighboring part move to the lightest part,
+  // which is found with a queue of the part weights. Entries whose part
+  // changed its weight are stale and replaced when they come up.
+  using PartEntry = std::pair<int64_t, int>; // weight, part
+  std::priority_queue<PartEntry, std::vector<PartEntry>, std::greater<>>
+      lightParts;
+  for (size_t lightPart = 0; lightPart < partWeights.size(); ++lightPart) {
+    lightParts.emplace(partWeights[lightPart], lightPart);
+  }
+  auto findMove = [&](int node) {
+    Move move = findBestMove(node);
+    while (move.target < 0) {
+      auto [weight, lightest] = lightParts.top();
+      if (weight == partWeights[lightest]) {
+        if (lightest != part[node] && hasRoom(lightest, node)) {
+          move.target = lightest;
+        }
+        break;
+      }
+      lightParts.pop();
+      lightParts.emplace(partWeights[lightest], lightest);
+    }
+    return move;
+  };
+
+  std::vector<std::vector<int>> heavyNodes(partWeights.size());
+  for (size_t node = 0; node < graph.numNodes(); ++node) {
+    if (partWeights[part[node]] > maxPartWeight) {
+      heavyNodes[part[node]].push_back(node);
+    }
+  }
+
+  using QueueEntry = std::tuple<int64_t, int, int>; // gain, node, target
+  for (size_t heavyPart = 0; heavyPart < partWeights.size(); ++heavyPart) {
+    std::priority_queue<QueueEntry> queue;
+    for (int node : heavyNodes[heavyPart]) {
+      Move move = findMove(node);
+      if (move.target >= 0) {
+        queue.emplace(move.gain, node, move.target);
+      }
+    }
+    while (partWeights[heavyPart] > maxPartWeight && !queue.empty()) {
+      auto [gain, node, target] = queue.top();
+      queue.pop();
+      Move move = findMove(node);
+      if (move.target < 0) {
+        continue;
+      }
+      if (move.gain != gain || move.target != target) {
+        queue.emplace(move.gain, node, move.target); // stale entry
+        continue;
+      }
+      moveNode(node, target);
+      lightParts.emplace(partWeights[target], target);
+    }
+  }
+}
+
+void Partition::refine(int maxPasses, bool parallel) {
+  size_t numNodes = graph.numNodes();
+  // Passes end after this many moves without a smaller cut.
+  size_t maxMovesWithoutGain = std::max<size_t>(100, numNodes / 100);
+
+  using QueueEntry = std::tuple<int64_t, int, int>; // gain, node, target
+  std::vector<Move> initialMoves(numNodes);
+  std::vector<char> locked(numNodes);
+  std::vector<std::pair<int, int>> moves; // node, previous part
+  for (int pass = 0; pass < maxPasses; ++pass) {
+    forEachNode(numNodes, parallel, [&](size_t node) {
+      initialMoves[node] = findBestMove(node);
+    });
+    std::priority_queue<QueueEntry> queue;
+    for (size_t node = 0; node < numNodes; ++node) {
+      if (initialMoves[node].target >= 0) {
+        queue.emplace(initialMoves[node].gain, node,
+                      initialMoves[node].target);
+      }
+    }
+
+    std::fill(locked.begin(), locked.end(), 0);
+    moves.clear();
+    int64_t totalGain = 0;
+    int64_t bestGain = 0;
+    size_t bestMoves = 0;
+    while (!queue.empty() && moves.size() - bestMoves < maxMovesWithoutGain) {
+      auto [gain, node, target] = queue.top();
+      queue.pop();
+      if (locked[node]) {
+        continue;
+      }
+      Move move = findBestMove(node);
+      if (move.target < 0) {
+        continue;
+      }
+      if (move.gain != gain || move.target != target) {
+        queue.emplace(move.gain, node, move.target); // stale entry
+        continue;
+      }
+
+      moves.emplace_back(node, part[node]);
+      moveNode(node, target);
+      locked[node] = 1;
+      totalGain += gain;
+      if (totalGain > bestGain) {
+        bestGain = totalGain;
+        bestMoves = moves.size();
+      }
+
+      for (auto &edge : graph.neighbors(node)) {
+        if (!locked[edge.target]) {
+          Move neighborMove = findBestMove(edge.target);
+          if (neighborMove.target >= 0) {
+            queue.emplace(neighborMove.gain, edge.target, neighborMove.target);
+          }
+        }
+      }
+    }
+
+    while (moves.size() > bestMoves) {
+      moveNode(moves.back().first, moves.back().second);
+      moves.pop_back();
+    }
+    if (bestGain == 0) {
+      break;
+    }
+  }
+}
+
+//===----------------------------------------------------------------------===//
+// Initial partitioning
+
+// Grows the parts one after the other from a random node, always adding the
+// node with the most edges into the part, until the part has its share of the
+// total weight. The last part gets all remaining nodes.
+std::vector<int> growPartition(const Graph &graph, int numParts,
+                               std::mt19937 &rng) {
+  size_t numNodes = graph.numNodes();
+  std::vector<int> part(numNodes, -1);
+  std::vector<int> seeds(numNodes);
+  std::iota(seeds.begin(), seeds.end(), 0);
+  std::shuffle(seeds.begin(), seeds.end(), rng);
+  auto nextSeed = seeds.begin();
+
+  int64_t remainingWeight = std::accumulate(
+      graph.nodeWeights.begin(), graph.nodeWeights.end(), int64_t{0});
+  std::vector<int64_t> connectivity(numNodes, 0);
+  std::vector<int> touched;
+  for (int growing = 0; growing + 1 < numParts; ++growing) {
+    int64_t targetWeight = remainingWeight / (numParts - growing);
+    int64_t weight = 0;
+    std::priority_queue<std::pair<int64_t, int>> queue;
+    while (weight < targetWeight) {
+      if (queue.empty()) {
+        while (nextSeed != seeds.end() && part[*nextSeed] >= 0) {
+          ++nextSeed;
+        }
+        if (nextSeed == seeds.end()) {
+          break;
+        }
+        queue.emplace(0, *nextSeed);
+      }
+      auto [nodeConnectivity, node] = queue.top();
+      queue.pop();
+      if (part[node] >= 0 || nodeConnectivity != connectivity[node]) {
+        continue; // already added, or stale entry
+      }
+
+      part[node] = growing;
+      weight += graph.nodeWeights[node];
+      for (auto &edge : graph.neighbors(node)) {
+        if (part[edge.target] < 0) {
+          if (connectivity[edge.target] == 0) {
+            touched.push_back(edge.target);
+          }
+          connectivity[edge.target] += edge.weight;
+          queue.emplace(connectivity[edge.target], edge.target);
+        }
+      }
+    }
+    remainingWeight -= weight;
+    for (int node : touched) {
+      connectivity[node] = 0;
+    }
+    touched.clear();
+  }
+
+  for (int &nodePart : part) {
+    if (nodePart < 0) {
+      nodePart = numParts - 1;
+    }
+  }
+  return part;
+}
+
+// Grows and refines several initial partitions in parallel and keeps the one
+// with the smallest cut.
+std::vector<int> computeInitialPartition(const Graph &graph, int numParts,
+                                         int64_t maxPartWeight,
+                                         int refinementPasses) {
+  constexpr size_t numTries = 8;
+  std::vector<std::vector<int>> tries(numTries);
+  std::vector<int64_t> cuts(numTries);
+  parallelFor(numTries, [&](size_t seed) {
+    std::mt19937 rng(seed);
+    Partition partition(graph, growPartition(graph, numParts, rng), numParts,
+                        maxPartWeight);
+    partition.rebalance();
+    partition.refine(refinementPasses, /*parallel=*/false);
+    tries[seed] = partition.takeParts();
+    cuts[seed] = computeCut(graph, tries[seed]);
+  });
+  return std::move(
+      tries[std::min_element(cuts.begin(), cuts.end()) - cuts.begin()]);
+}
+
+//===----------------------------------------------------------------------===//
+// Module assignment
+
+// Assigns every part to the module that holds the most of its topics, in the
+// order of the largest overlaps, so each module gets at most one part.
+std::vector<int> matchPartsToModules(const std::vector<int> &moduleOfNode,
+                                     const std::vector<int> &part,
+                                     int numParts, int numModules) {
+  std::vector<int64_t> pairs(part.size());
+  for (size_t node = 0; node < part.size(); ++node) {
+    pairs[node] = int64_t{moduleOfNode[node]} * numParts + part[node];
+  }
+  std::sort(pairs.begin(), pairs.end());
+
+  std::vector<std::pair<size_t, int64_t>> overlaps; // topics, module and part
+  for (size_t begin = 0; begin < pairs.size();) {
+    size_t end = begin;
+    while (end < pairs.size() && pairs[end] == pairs[begin]) {
+      ++end;
+    }
+    overlaps.emplace_back(end - begin, pairs[begin]);
+    begin = end;
+  }
+  std::sort(overlaps.begin(), overlaps.end(), [](auto &lhs, auto &rhs) {
+    return std::tie(rhs.first, lhs.second) < std::tie(lhs.first, rhs.second);
+  });
+
+  std::vector<int> moduleOfPart(numParts, -1);
+  std::vector<bool> hasPart(numModules, false);
+  for (auto [topics, modulePart] : overlaps) {
+    int module = modulePart / numParts;
+    int partIndex = modulePart % numParts;
+    if (moduleOfPart[partIndex] < 0 && !hasPart[module]) {
+      moduleOfPart[partIndex] = module;
+      hasPart[module] = true;
+    }
+  }
+  return moduleOfPart;
+}
+
+} // namespace
+
+PartitionProposal computePartition(const ModuleCollection &moduleCollection,
+                                   const PartitionOptions &options) {
+  PartitionProposal proposal;
+  std::vector<const Module *> modules;
+  std::vector<const Topic *> topics;
+  std::vector<int> moduleOfNode;
+  std::unordered_map<int, int> nodeOfTopic;
+  for (auto &module : moduleCollection.modules()) {
+    for (auto &topic : module->topics()) {
+      if (nodeOfTopic.emplace(topic->getID(), proposal.topics.size()).second) {
+        proposal.topics.push_back({topic->getID(), module->getModuleID(), 0});
+        topics.push_back(topic.get());
+        moduleOfNode.push_back(modules.size());
+      }
+    }
+    modules.push_back(module.get());
+  }
+
+  int numModules = modules.size();
+  int numParts = options.numParts > 0 ? options.numParts : numModules;
+  size_t numNodes = proposal.topics.size();
+  if (numParts == 0 || numNodes == 0) {
+    return proposal;
+  }
+
+  // The fine graph has one node per topic and one edge per pair of topics with
+  // hard dependencies between them.
+  Graph graph;
+  graph.nodeWeights.assign(numNodes, 1);
+  graph.offsets.assign(numNodes + 1, 0);
+  std::vector<std::pair<int, int>> dependencies;
+  for (size_t node = 0; node < numNodes; ++node) {
+    for (int depID : topics[node]->dependencies()) {
+      auto dep = nodeOfTopic.find(depID);
+      if (dep != nodeOfTopic.end() && dep->second != static_cast<int>(node)) {
+        dependencies.emplace_back(node, dep->second);
+        ++graph.offsets[node + 1];
+        ++graph.offsets[dep->second + 1];
+      }
+    }
+  }
+  std::partial_sum(graph.offsets.begin(), graph.offsets.end(),
+                   graph.offsets.begin());
+  graph.edges.resize(graph.offsets[numNodes]);
+  std::vector<size_t> numEdges(numNodes, 0);
+  for (auto [source, target] : dependencies) {
+    graph.edges[graph.offsets[source] + numEdges[source]++] = {target, 1};
+    graph.edges[graph.offsets[target] + numEdges[target]++] = {source, 1};
+  }
+  dependencies = {};
+  mergeParallelEdges(graph, numEdges);
+  proposal.cutBefore = computeCut(graph, moduleOfNode);
+
+  int64_t maxPartWeight = static_cast<int64_t>(std::ceil(
+      (1 + std::max(0.0, options.imbalance)) * numNodes / numParts));
+  bool keepModules = options.keepModules && numParts == numModules;
+
+  // Coarsen until the graph is small enough to be partitioned directly, or
+  // until the matching hardly shrinks it. Starting from the current modules,
+  // only topics of the same module are contracted.
+  std::vector<CoarseLevel> levels;
+  std::vector<int> labels = keepModules ? moduleOfNode : std::vector<int>();
+  size_t coarsestSize = std::max<size_t>(100, 20 * numParts);
+  int maxNodeWeight = std::max<int64_t>(1, maxPartWeight / 8);
+  std::mt19937 rng(0);
+  while (true) {
+    const Graph &finest = levels.empty() ? graph : levels.back().graph;
+    const std::vector<int> &finestLabels =
+        levels.empty() ? labels : levels.back().labels;
+    if (finest.numNodes() <= coarsestSize) {
+      break;
+    }
+    CoarseLevel level = coarsen(finest, finestLabels, maxNodeWeight, rng);
+    if (level.graph.numNodes() > finest.numNodes() * 9 / 10) {
+      break;
+    }
+    levels.push_back(std::move(level));
+  }
+
+  const Graph &coarsest = levels.empty() ? graph : levels.back().graph;
+  std::vector<int> part;
+  if (keepModules) {
+    part = levels.empty() ? labels : levels.back().labels;
+  } else {
+    part = computeInitialPartition(coarsest, numParts, maxPartWeight,
+                                   options.refinementPasses);
+  }
+
+  // Refine on every level, then project the parts onto the next finer one.
+  for (size_t level = levels.size() + 1; level-- > 0;) {
+    const Graph &levelGraph = level == 0 ? graph : levels[level - 1].graph;
+    Partition partition(levelGraph, std::move(part), numParts, maxPartWeight);
+    partition.rebalance();
+    partition.refine(options.refinementPasses, /*parallel=*/true);
+    part = partition.takeParts();
+    if (level > 0) {
+      std::vector<int> finerPart(levels[level - 1].coarseNodes.size());
+      for (size_t node = 0; node < finerPart.size(); ++node) {
+        finerPart[node] = part[levels[level - 1].coarseNodes[node]];
+      }
+      part = std::move(finerPart);
+    }
+  }
+  proposal.cutAfter = computeCut(graph, part);
+
+  // Name the parts after their modules, new modules get unused names.
+  std::vector<int> moduleOfPart(numParts);
+  if (keepModules) {
+    std::iota(moduleOfPart.begin(), moduleOfPart.end(), 0);
+  } else {
+    moduleOfPart =
+        matchPartsToModules(moduleOfNode, part, numParts, numModules);
+  }
+  std::unordered_set<std::string> moduleNames;
+  for (const Module *module : modules) {
+    moduleNames.insert(module->getModuleName());
+  }
+  proposal.parts.resize(numParts);
+  for (int partIndex = 0; partIndex < numParts; ++partIndex) {
+    auto &newPart = proposal.parts[partIndex];
+    if (moduleOfPart[partIndex] >= 0) {
+      const Module *module = modules[moduleOfPart[partIndex]];
+      newPart.moduleID = module->getModuleID();
+      newPart.moduleName = module->getModuleName();
+      continue;
+    }
+    newPart.moduleName = absl::StrCat("partition_", partIndex + 1);
+    for (int suffix = 2; moduleNames.count(newPart.moduleName); ++suffix) {
+      newPart.moduleName =
+          absl::StrCat("partition_", partIndex + 1, "_", suffix);
+    }
+    moduleNames.insert(newPart.moduleName);
+  }
+  for (size_t node = 0; node < numNodes; ++node) {
+    proposal.topics[node].part = part[node];
+    ++proposal.parts[part[node]].numTopics;
+  }
+  return proposal;
+}
+
+void writePartitionScript(const PartitionProposal &proposal,
+                          std::ostream &out) {
+  for (auto &part : proposal.parts) {
+    if (!part.moduleID) {
+      out << "addModule " << part.moduleName << "\n";
+    }
+  }
+  // One batch, so every module is rebuilt once.
+  out << "moveTopics\n";
+  for (auto &topic : proposal.topics) {
+    auto &part = proposal.parts[topic.part];
+    if (part.moduleID == topic.moduleID) {
+      continue;
+    }
+    out << topic.moduleID << ":" << topic.topicID << " -> ";
+    if (part.moduleID) {
+      out << *part.moduleID << "\n";
+    } else {
+      out << part.moduleName << "\n";
+    }
+  }
+  out << "\nquit\nyes\n";
+}
+
+void applyPartition(ModuleCollection &moduleCollection,
+                    const PartitionProposal &proposal) {
+  std::vector<Module *> partModules;
+  for (auto &part : proposal.parts) {
+    partModules.push_back(part.moduleID
+                              ? moduleCollection.getModuleFromID(*part.moduleID)
+                              : &moduleCollection.addModule(part.moduleName));
+  }
+  std::vector<std::pair<int, Module *>> moves;
+  for (auto &topic : proposal.topics) {
+    Module *target = partModules[topic.part];
+    if (target && target->getModuleID() != topic.moduleID) {
+      moves.emplace_back(topic.topicID, target);
+    }
+  }
+  moduleCollection.moveTopics(moves);
+}
+
+} // namespace sg20
@@ -0,0 +1,438 @@
+#include "sg20_graphgen/graph_generator.h"
+#include "sg20_graphgen/modules.h"
+#include "sg20_graphgen/output_sink.h"
+#include "sg20_graphgen/serialization.h"
+#include "sg20_graphgen/validator.h"
+
+#include <pybind11/numpy.h>
+#include <pybind11/operators.h>
+#include <pybind11/pybind11.h>
+#include <pybind11/stl.h>
+#include <pybind11/stl/filesystem.h>
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace py = pybind11;
+
+namespace {
+
+using namespace sg20;
+
+//===----------------------------------------------------------------------===//
+// Edge arrays
+
+// Flat arrays of the topics and dependencies of a collection. The NumPy arrays
+// returned by edge_arrays view these vectors directly and keep them alive.
+struct EdgeArrays {
+  std::vector<int32_t> topicIDs;
+  std::vector<int32_t> topicModules;
+  std::vector<int32_t> sources;
+  std::vector<int32_t> targets;
+  std::vector<uint8_t> kinds;
+};
+
+std::unique_ptr<EdgeArrays> collectEdgeArrays(const ModuleCollection &MC) {
+  auto arrays = std::make_unique<EdgeArrays>();
+  size_t numTopics = MC.numTopics();
+  arrays->topicIDs.reserve(numTopics);
+  arrays->topicModules.reserve(numTopics);
+  for (auto &module : MC.modules()) {
+    for (auto &topic : module->topics()) {
+      arrays->topicIDs.push_back(topic->getID());
+      arrays->topicModules.push_back(module->getModuleID());
+      for (int dep : topic->dependencies()) {
+        arrays->sources.push_back(topic->getID());
+        arrays->targets.push_back(dep);
+        arrays->kinds.push_back(static_cast<uint8_t>(DependencyKind::Hard));
+      }
+      for (int dep : topic->softDependencies()) {
+        arrays->sources.push_back(topic->getID());
+        arrays->targets.push_back(dep);
+        arrays->kinds.push_back(static_cast<uint8_t>(DependencyKind::Soft));
+      }
+    }
+  }
+  return arrays;
+}
+
+template <typename T>
+py::array_t<T> viewArray(const std::vector<T> &vector, py::handle owner) {
+  return py::array_t<T>({vector.size()}, {sizeof(T)}, vector.data(), owner);
+}
+
+// The GIL stays held while MC is read, another Python thread could change the
+// collection otherwise.
+py::dict getEdgeArrays(const ModuleCollection &MC) {
+  std::unique_ptr<EdgeArrays> arrays = collectEdgeArrays(MC);
+  // The capsule owns the vectors, every array holds a reference to it.
+  EdgeArrays *data = arrays.get();
+  py::capsule owner(arrays.release(), [](void *pointer) {
+    delete static_cast<EdgeArrays *>(pointer);
+  });
+
+  py::dict result;
+  result["topic_ids"] = viewArray(data->topicIDs, owner);
+  result["topic_modules"] = viewArray(data->topicModules, owner);
+  result["src"] = viewArray(data->sources, owner);
+  result["dst"] = viewArray(data->targets, owner);
+  result["kind"] = viewArray(data->kinds, owner);
+  return result;
+}
+
+//===----------------------------------------------------------------------===//
+// Handles
+
+// The collection behind a Python ModuleCollection. Deleting topics or modules
+// and compacting the IDs destroy Topic and Module objects, so they start a new
+// generation, which invalidates all handles of the previous one.
+struct PyCollection {
+  ModuleCollection MC;
+  uint64_t generation = 0;
+};
+
+class StaleHandleError : public std::runtime_error {
+public:
+  using std::runtime_error::runtime_error;
+};
+
+// A topic or module as seen from Python. It keeps its collection alive and
+// checks on every access that the object was not destroyed since.
+template <typename T> struct Handle {
+  py::object owner;
+  T *element;
+  uint64_t generation;
+
+  bool isValid() const {
+    return owner.cast<PyCollection &>().generation == generation;
+  }
+
+  T &get() const {
+    if (!isValid()) {
+      throw StaleHandleError(
+          "A topic or module was deleted or the IDs were compacted after "
+          "this handle was created, look it up again by its ID");
+    }
+    return *element;
+  }
+
+  bool operator==(const Handle &other) const {
+    return element == other.element && generation == other.generation &&
+           owner.is(other.owner);
+  }
+};
+
+using TopicHandle = Handle<Topic>;
+using ModuleHandle = Handle<Module>;
+
+template <typename T> Handle<T> makeHandle(py::object owner, T &element) {
+  uint64_t generation = owner.cast<PyCollection &>().generation;
+  return Handle<T>{std::move(owner), &element, generation};
+}
+
+// Returns None for elements that do not exist.
+template <typename T> py::object toHandle(py::object owner, T *element) {
+  if (!element) {
+    return py::none();
+  }
+  return py::cast(makeHandle(std::move(owner), *element));
+}
+
+// Returns the elements of a range of owning pointers as handles, e.g., the
+// topics of a module.
+template <typename RangeTy>
+py::list toHandles(py::object owner, RangeTy range) {
+  py::list list;
+  for (auto &element : range) {
+    list.append(makeHandle(owner, *element));
+  }
+  return list;
+}
+
+// Edits need handles into the collection they edit.
+template <typename T>
+T &getOwnElement(const PyCollection &collection, const Handle<T> &handle) {
+  if (&handle.owner.template cast<PyCollection &>() != &collection) {
+    throw py::value_error("The handle belongs to another collection");
+  }
+  return handle.get();
+}
+
+//===----------------------------------------------------------------------===//
+// Helpers
+
+template <typename RangeTy> std::vector<int> toIDs(RangeTy range) {
+  return std::vector<int>(range.begin(), range.end());
+}
+
+py::bytes emitOutput(const ModuleCollection &MC, std::string_view kindName,
+                     bool layoutOrder, bool rankSame) {
+  auto kind = parseOutputKind(kindName);
+  if (!kind) {
+    throw py::value_error("Unknown output kind " + std::string(kindName));
+  }
+
+  std::ostringstream stream;
+  {
+    DotLayoutOptions layoutOptions;
+    layoutOptions.layoutOrder = layoutOrder;
+    layoutOptions.rankSame = rankSame;
+    OutputSink out(stream);
+    writeOutput(MC, *kind, out, layoutOptions);
+  }
+  return py::bytes(stream.str());
+}
+
+std::vector<std::string> validate(const ModuleCollection &MC) {
+  std::vector<std::string> issues;
+  for (auto &issue : validateModuleCollection(MC)) {
+    std::ostringstream out;
+    issue.dump(out);
+    std::string text = out.str();
+    while (!text.empty() && text.back() == '\n') {
+      text.pop_back();
+    }
+    issues.push_back(std::move(text));
+  }
+  return issues;
+}
+
+} // namespace
+
+PYBIND11_MODULE(sg20, m) {
+  m.doc() = "Module collections of the SG20 teaching graph generator.";
+
+  py::register_exception<ParseError>(m, "ParseError", PyExc_ValueError);
+  py::register_exception<StaleHandleError>(m, "StaleHandleError",
+                                           PyExc_LookupError);
+
+  py::enum_<DependencyKind>(m, "DependencyKind")
+      .value("Hard", DependencyKind::Hard)
+      .value("Soft", DependencyKind::Soft);
+
+  py::class_<TopicHandle>(m, "Topic")
+      .def_property_readonly(
+          "name", [](const TopicHandle &self) { return self.get().getName(); })
+      .def_property_readonly(
+          "id", [](const TopicHandle &self) { return self.get().getID(); })
+      .def_property_readonly("dependencies",
+                             [](const TopicHandle &self) {
+                               return toIDs(self.get().dependencies());
+                             })
+      .def_property_readonly("soft_dependencies",
+                             [](const TopicHandle &self) {
+                               return toIDs(self.get().softDependencies());
+                             })
+      .def_property_readonly("dependents",
+                             [](const TopicHandle &self) {
+                               return toIDs(self.get().dependents());
+                             })
+      .def_property_readonly("soft_dependents",
+                             [](const TopicHandle &self) {
+                               return toIDs(self.get().softDependents());
+                             })
+      .def(
+          "rename",
+          [](const TopicHandle &self, std::string name) {
+            self.get().rename(std::move(name));
+          },
+          py::arg("name"))
+      .def(
+          "add_dependency",
+          [](const TopicHandle &self, const TopicHandle &target,
+             DependencyKind kind) {
+            Topic &topic = self.get();
+            Topic &targetTopic =
+                getOwnElement(self.owner.cast<PyCollection &>(), target);
+            return kind == DependencyKind::Hard
+                       ? topic.addDependency(targetTopic)
+                       : topic.addSoftDependency(targetTopic);
+          },
+          py::arg("target"), py::arg("kind") = DependencyKind::Hard)
+      .def(
+          "remove_dependency",
+          [](const TopicHandle &self, const TopicHandle &target,
+             DependencyKind kind) {
+            Topic &topic = self.get();
+            Topic &targetTopic =
+                getOwnElement(self.owner.cast<PyCollection &>(), target);
+            if (kind == DependencyKind::Hard) {
+              topic.removeDependency(targetTopic);
+            } else {
+              topic.removeSoftDependency(targetTopic);
+            }
+          },
+          py::arg("target"), py::arg("kind") = DependencyKind::Hard)
+      .def_property_readonly("valid", &TopicHandle::isValid,
+                             "False once the topic may have been destroyed.")
+      .def(py::self == py::self)
+      .def("__hash__",
+           [](const TopicHandle &self) {
+             return std::hash<const Topic *>()(self.element);
+           })
+      .def("__repr__", [](const TopicHandle &self) {
+        const Topic &topic = self.get();
+        return "<Topic " + std::to_string(topic.getID()) + " " +
+               topic.getName() + ">";
+      });
+
+  py::class_<ModuleHandle>(m, "Module")
+      .def_property_readonly(
+          "name",
+          [](const ModuleHandle &self) { return self.get().getModuleName(); })
+      .def_property_readonly(
+          "id",
+          [](const ModuleHandle &self) { return self.get().getModuleID(); })
+      .def_property_readonly("topics",
+                             [](const ModuleHandle &self) {
+                               return toHandles(self.owner,
+                                                self.get().topics());
+                             })
+      .def_property_readonly("valid", &ModuleHandle::isValid,
+                             "False once the module may have been destroyed.")
+      .def(py::self == py::self)
+      .def("__hash__",
+           [](const ModuleHandle &self) {
+             return std::hash<const Module *>()(self.element);
+           })
+      .def("__len__",
+           [](const ModuleHandle &self) { return self.get().numTopics(); })
+      .def("__repr__", [](const ModuleHandle &self) {
+        const Module &module = self.get();
+        return "<Module " + std::to_string(module.getModuleID()) + " " +
+               module.getModuleName() + ">";
+      });
+
+  py::class_<PyCollection>(m, "ModuleCollection")
+      .def(py::init<>())
+      .def_static(
+          "load",
+          [](std::filesystem::path path) {
+            return PyCollection{
+                ModuleCollection::loadModulesFromFile(std::move(path))};
+          },
+          py::arg("path"), py::call_guard<py::gil_scoped_release>(),
+          "Loads a yaml, JSON, or MessagePack file, the format is selected by "
+          "the file extension.")
+      .def_static(
+          "from_json",
+          [](std::string_view input) {
+            return PyCollection{loadModulesFromJSON(input)};
+          },
+          py::arg("input"))
+      .def_static(
+          "from_msgpack",
+          [](py::bytes input) {
+            return PyCollection{
+                loadModulesFromMsgPack(std::string_view(input))};
+          },
+          py::arg("input"))
+      .def(
+          "store",
+          [](const PyCollection &self, std::filesystem::path path) {
+            ModuleCollection::storeModulesToFile(self.MC, std::move(path));
+          },
+          py::arg("path"))
+      .def_property_readonly("modules",
+                             [](py::object self) {
+                               return toHandles(
+                                   self, self.cast<PyCollection &>()
+                                             .MC.modules());
+                             })
+      .def_property_readonly(
+          "num_modules",
+          [](const PyCollection &self) { return self.MC.numModules(); })
+      .def_property_readonly(
+          "num_topics",
+          [](const PyCollection &self) { return self.MC.numTopics(); })
+      .def(
+          "module",
+          [](py::object self, int moduleID) {
+            return toHandle(
+                self, self.cast<PyCollection &>().MC.getModuleFromID(moduleID));
+          },
+          py::arg("id"))
+      .def(
+          "module_by_name",
+          [](py::object self, std::string_view name) {
+            return toHandle(
+                self, self.cast<PyCollection &>().MC.getModuleFromName(name));
+          },
+          py::arg("name"))
+      .def(
+          "topic",
+          [](py::object self, int topicID) {
+            return toHandle(
+                self, self.cast<PyCollection &>().MC.getTopicFromID(topicID));
+          },
+          py::arg("id"))
+      .def(
+          "add_module",
+          [](py::object self, std::string name) {
+            auto &collection = self.cast<PyCollection &>();
+            return makeHandle(self, collection.MC.addModule(std::move(name)));
+          },
+          py::arg("name"))
+      .def(
+          "add_topic",
+          [](py::object self, const ModuleHandle &module, std::string name) {
+            auto &collection = self.cast<PyCollection &>();
+            return toHandle(self, collection.MC.addTopicToModule(
+                                      std::move(name),
+                                      getOwnElement(collection, module)));
+          },
+          py::arg("module"), py::arg("name"))
+      .def(
+          "delete_module",
+          [](PyCollection &self, int moduleID) {
+            self.MC.deleteModule(moduleID);
+            ++self.generation;
+          },
+          py::arg("id"))
+      .def(
+          "delete_topic",
+          [](PyCollection &self, int topicID) {
+            self.MC.deleteTopic(topicID);
+            ++self.generation;
+          },
+          py::arg("id"))
+      .def(
+          "move_topic",
+          [](py::object self, int topicID, const ModuleHandle &target) {
+            auto &collection = self.cast<PyCollection &>();
+            return toHandle(self, collection.MC.moveTopic(
+                                      topicID,
+                                      getOwnElement(collection, target)));
+          },
+          py::arg("id"), py::arg("target"))
+      .def("compact_ids",
+           [](PyCollection &self) {
+             self.MC.compactIDs();
+             ++self.generation;
+           })
+      .def(
+          "validate",
+          [](const PyCollection &self) { return validate(self.MC); },
+          "Returns a description of every referential integrity issue.")
+      .def(
+          "edge_arrays",
+          [](const PyCollection &self) { return getEdgeArrays(self.MC); },
+          "Returns NumPy arrays of the topic IDs and their module IDs "
+          "(topic_ids, topic_modules), and of the dependencies (src, dst, "
+          "kind), where kind is 0 for hard and 1 for soft dependencies.")
+      .def(
+          "emit",
+          [](const PyCollection &self, std::string_view kindName,
+             bool layoutOrder, bool rankSame) {
+            return emitOutput(self.MC, kindName, layoutOrder, rankSame);
+          },
+          py::arg("kind"), py::arg("layout_order") = false,
+          py::arg("rank_same") = false,
+          "Returns the output of the kind, one of dot, htmldot, "
+          "htmldot-deps, html, yaml, json, msgpack, svg, and explorer.");
+}
@@ -0,0 +1,235 @@
+#include "sg20_graphgen/query_server.h"
+#include "sg20_graphgen/commands.h"
+
+#include "absl/strings/str_cat.h"
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+#include <sstream>
+#include <stdexcept>
+#include <system_error>
+#include <thread>
+
+namespace sg20 {
+
+// Requests are single lines, anything longer is rejected.
+static constexpr size_t MaxRequestSize = 64 * 1024;
+
+static std::system_error makeSystemError(const char *what) {
+  return std::system_error(errno, std::generic_category(), what);
+}
+
+// Writes the complete buffer, returns false if the client went away.
+static bool sendAll(int fd, std::string_view data) {
+  while (!data.empty()) {
+    ssize_t written = ::send(fd, data.data(), data.size(), MSG_NOSIGNAL);
+    if (written < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return false;
+    }
+    data.remove_prefix(written);
+  }
+  return true;
+}
+
+QueryServer::QueryServer(ModuleCollection moduleCollection,
+                         std::filesystem::path socketPath,
+                         std::filesystem::path outputPath)
+    : collection(std::move(moduleCollection)),
+      socketPath(std::move(socketPath)), outputPath(std::move(outputPath)) {}
+
+void QueryServer::run() {
+  sockaddr_un address{};
+  address.sun_family = AF_UNIX;
+  if (socketPath.native().size() >= sizeof(address.sun_path)) {
+    throw std::system_error(ENAMETOOLONG, std::generic_category(),
+                            "socket path");
+  }
+  std::strcpy(address.sun_path, socketPath.c_str());
+
+  int fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  if (fd < 0) {
+    throw makeSystemError("socket");
+  }
+  // Remove the socket left behind by a previous server.
+  if (std::filesystem::is_socket(socketPath)) {
+    std::filesystem::remove(socketPath);
+  }
+  if (::bind(fd, reinterpret_cast<sockaddr *>(&address), sizeof(address)) <
+      0) {
+    auto error = makeSystemError("bind");
+    ::close(fd);
+    throw error;
+  }
+  if (::listen(fd, SOMAXCONN) < 0) {
+    auto error = makeSystemError("listen");
+    ::close(fd);
+    throw error;
+  }
+  listenFD = fd;
+
+  while (!stopped) {
+    int clientFD = ::accept4(fd, nullptr, nullptr, SOCK_CLOEXEC);
+    if (clientFD < 0) {
+      if (stopped) {
+        break; // stop() shuts down the socket, which fails the accept
+      }
+      continue; // e.g., interrupted or aborted connection attempts
+    }
+
+    std::lock_guard<std::mutex> lock(clientsMutex);
+    if (stopped) {
+      ::close(clientFD);
+      break;
+    }
+    clientFDs.insert(clientFD);
+    std::thread([this, clientFD]() { serveClient(clientFD); }).detach();
+  }
+
+  stop();
+  {
+    std::unique_lock<std::mutex> lock(clientsMutex);
+    clientsDone.wait(lock, [this]() { return clientFDs.empty(); });
+  }
+  listenFD = -1;
+  ::close(fd);
+  std::filesystem::remove(socketPath);
+}
+
+void QueryServer::stop() {
+  stopped = true;
+  if (int fd = listenFD; fd >= 0) {
+    ::shutdown(fd, SHUT_RDWR);
+  }
+
+  // Wake up all clients waiting for requests, they close their connection.
+  std::lock_guard<std::mutex> lock(clientsMutex);
+  for (int clientFD : clientFDs) {
+    ::shutdown(clientFD, SHUT_RDWR);
+  }
+}
+
+QueryServer::Reply QueryServer::handleRequest(std::string_view request) {
+  std::istringstream in{std::string(request)};
+  std::string cmd;
+  in >> cmd;
+
+  Reply reply;
+  if (cmd.empty()) {
+    reply.failed = true;
+    reply.text = "Empty request\n";
+    return reply;
+  }
+  if (cmd == "save") {
+    auto snapshot = collection.acquire();
+    std::lock_guard<std::mutex> lock(saveMutex);
+    try {
+      ModuleCollection::storeModulesToFile(snapshot->getCollection(),
+                                           outputPath);
+    } catch (std::runtime_error &e) {
+      reply.failed = true;
+      reply.text = absl::StrCat(e.what(), "\n");
+      return reply;
+    }
+    reply.text = absl::StrCat("Saved to ", outputPath.string(), "\n");
+    return reply;
+  }
+
+  CommandType cmdType = convertToCommandType(cmd);
+  std::ostringstream out;
+  std::ostringstream err;
+  switch (cmdType) {
+  case CommandType::HELP:
+    printCommandHelp(out);
+    out << "\nServer commands:\n"
+        << "  save  stores the collection into the output file\n";
+    break;
+  case CommandType::QUIT:
+    reply.closeConnection = true;
+    break;
+  case CommandType::ERROR:
+    err << "Did not understand command: " << cmd << "\n";
+    break;
+  default:
+    if (isReadOnlyCommand(cmdType)) {
+      auto snapshot = collection.acquire();
+      executeReadOnlyCommand(snapshot->getCollection(), cmdType, in, out, err,
+                             &snapshot->getSearchIndex());
+    } else {
+      collection.update([&](ModuleCollection &moduleCollection) {
+        return executeCommand(moduleCollection, cmdType, in, out, err);
+      });
+    }
+    break;
+  }
+
+  reply.failed = !err.str().empty();
+  reply.text = out.str() + err.str();
+  return reply;
+}
+
+void QueryServer::serveClient(int clientFD) {
+  std::string buffer;
+  char chunk[4096];
+  bool keepServing = true;
+  while (keepServing) {
+    ssize_t received = ::recv(clientFD, chunk, sizeof(chunk), 0);
+    if (received < 0 && errno == EINTR) {
+      continue;
+    }
+    if (received <= 0) {
+      break; // client closed the connection or the server is stopped
+    }
+    buffer.append(chunk, received);
+
+    size_t lineStart = 0;
+    for (size_t lineEnd = buffer.find('\n'); lineEnd != std::string::npos;
+         lineEnd = buffer.find('\n', lineStart)) {
+      std::string_view request(buffer.data() + lineStart, lineEnd - lineStart);
+      lineStart = lineEnd + 1;
+      if (!request.empty() && request.back() == '\r') {
+        request.remove_suffix(1);
+      }
+
+      Reply reply;
+      try {
+        reply = handleRequest(request);
+      } catch (std::exception &e) {
+        reply.failed = true;
+        reply.text = absl::StrCat("Internal error: ", e.what(), "\n");
+      }
+      if (reply.closeConnection) {
+        keepServing = false;
+        break;
+      }
+      std::string header = absl::StrCat(reply.failed ? "ERROR " : "OK ",
+                                        reply.text.size(), "\n");
+      if (!sendAll(clientFD, header) || !sendAll(clientFD, reply.text)) {
+        keepServing = false;
+        break;
+      }
+    }
+    buffer.erase(0, lineStart);
+
+    if (keepServing && buffer.size() > MaxRequestSize) {
+      std::string_view error = "Request too long\n";
+      sendAll(clientFD, absl::StrCat("ERROR ", error.size(), "\n", error));
+      break;
+    }
+  }
+
+  std::lock_guard<std::mutex> lock(clientsMutex);
+  ::close(clientFD);
+  clientFDs.erase(clientFD);
+  if (clientFDs.empty()) {
+    clientsDone.notify_all();
+  }
+}
+
+} // namespace sg20
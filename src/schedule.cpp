@@ -0,0 +1,272 @@
+#include "sg20_graphgen/schedule.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <queue>
+#include <string_view>
+#include <tuple>
+#include <unordered_map>
+#include <utility>
+
+namespace sg20 {
+
+namespace {
+
+// Orders the topics topologically by their dependencies. If only cycles are
+// left, the first unplaced topic is placed next.
+std::vector<int>
+orderTopologically(const std::vector<std::vector<int>> &deps,
+                   const std::vector<std::vector<int>> &dependents) {
+  size_t numTopics = deps.size();
+  std::vector<size_t> unplacedDeps(numTopics);
+  std::vector<bool> placed(numTopics, false);
+  std::vector<int> worklist;
+  for (size_t node = numTopics; node-- > 0;) {
+    unplacedDeps[node] = deps[node].size();
+    if (unplacedDeps[node] == 0) {
+      worklist.push_back(node);
+    }
+  }
+
+  std::vector<int> order;
+  order.reserve(numTopics);
+  size_t cycleCandidate = 0;
+  while (order.size() < numTopics) {
+    if (worklist.empty()) {
+      while (placed[cycleCandidate]) {
+        ++cycleCandidate;
+      }
+      worklist.push_back(cycleCandidate);
+    }
+    int node = worklist.back();
+    worklist.pop_back();
+    if (placed[node]) {
+      continue;
+    }
+    placed[node] = true;
+    order.push_back(node);
+
+    for (int dependent : dependents[node]) {
+      if (!placed[dependent] && --unplacedDeps[dependent] == 0) {
+        worklist.push_back(dependent);
+      }
+    }
+  }
+  return order;
+}
+
+// Quotes the field if it contains a separator, a quote, or a line break.
+std::string escapeCSVField(std::string_view field) {
+  if (field.find_first_of(",\"\r\n") == std::string_view::npos) {
+    return std::string(field);
+  }
+
+  std::string escaped = "\"";
+  for (char c : field) {
+    if (c == '"') {
+      escaped += '"';
+    }
+    escaped += c;
+  }
+  escaped += '"';
+  return escaped;
+}
+
+} // namespace
+
+Schedule computeSchedule(const ModuleCollection &moduleCollection,
+                         const ScheduleOptions &options) {
+  Schedule schedule;
+  schedule.numTracks = std::max(1, options.tracks);
+
+  // Number the topics densely in collection order. Dependencies on a topic ID
+  // that is used more than once refer to its first topic.
+  std::vector<int> moduleOfTopic;
+  std::unordered_map<int, int> topicIndex;
+  int numModules = 0;
+  for (auto &module : moduleCollection.modules()) {
+    for (auto &topic : module->topics()) {
+      topicIndex.emplace(topic->getID(), schedule.topics.size());
+      schedule.topics.push_back({module.get(), topic.get(), 0, 0, 0, 0});
+      moduleOfTopic.push_back(numModules);
+    }
+    ++numModules;
+  }
+  size_t numTopics = schedule.topics.size();
+  if (numTopics == 0) {
+    return schedule;
+  }
+
+  std::vector<std::vector<int>> deps(numTopics);
+  std::vector<std::vector<int>> dependents(numTopics);
+  for (size_t node = 0; node < numTopics; ++node) {
+    for (int depID : schedule.topics[node].topic->dependencies()) {
+      auto dep = topicIndex.find(depID);
+      if (dep != topicIndex.end() && dep->second != static_cast<int>(node)) {
+        deps[node].push_back(dep->second);
+        dependents[dep->second].push_back(node);
+      }
+    }
+  }
+
+  // Only dependencies that agree with the topological order are kept, which
+  // drops the edges that close cycles.
+  std::vector<int> order = orderTopologically(deps, dependents);
+  std::vector<int> position(numTopics);
+  for (size_t i = 0; i < numTopics; ++i) {
+    position[order[i]] = i;
+  }
+  auto isOrdered = [&position](int from, int to) {
+    return position[from] < position[to];
+  };
+  for (size_t node = 0; node < numTopics; ++node) {
+    auto &nodeDeps = deps[node];
+    nodeDeps.erase(std::remove_if(nodeDeps.begin(), nodeDeps.end(),
+                                  [&](int dep) { return !isOrdered(dep, node); }),
+                   nodeDeps.end());
+    auto &nodeDependents = dependents[node];
+    nodeDependents.erase(
+        std::remove_if(nodeDependents.begin(), nodeDependents.end(),
+                       [&](int dependent) {
+                         return !isOrdered(node, dependent);
+                       }),
+        nodeDependents.end());
+  }
+
+  // Critical path method: earliest slots forward, latest slots backward.
+  for (int node : order) {
+    int earliest = 0;
+    for (int dep : deps[node]) {
+      earliest = std::max(earliest, schedule.topics[dep].earliest + 1);
+    }
+    schedule.topics[node].earliest = earliest;
+    schedule.criticalPathLength =
+        std::max(schedule.criticalPathLength, earliest + 1);
+  }
+  for (auto node = order.rbegin(); node != order.rend(); ++node) {
+    int latest = schedule.criticalPathLength - 1;
+    for (int dependent : dependents[*node]) {
+      latest = std::min(latest, schedule.topics[dependent].latest - 1);
+    }
+    schedule.topics[*node].latest = latest;
+  }
+
+  // Follow topics without slack from the first slot to the last one.
+  auto isCritical = [&schedule](int node) {
+    return schedule.topics[node].earliest == schedule.topics[node].latest;
+  };
+  int current = -1;
+  for (size_t node = 0; node < numTopics && current < 0; ++node) {
+    if (schedule.topics[node].earliest == 0 && isCritical(node)) {
+      current = node;
+    }
+  }
+  while (current >= 0) {
+    schedule.criticalPath.push_back(schedule.topics[current].topic);
+    int next = -1;
+    for (int dependent : dependents[current]) {
+      if (isCritical(dependent) &&
+          schedule.topics[dependent].earliest ==
+              schedule.topics[current].earliest + 1 &&
+          (next < 0 || dependent < next)) {
+        next = dependent;
+      }
+    }
+    current = next;
+  }
+
+  // List scheduling. Ready topics wait in a queue per module, and the modules
+  // wait in a queue ordered by their most urgent topic, so modules that
+  // reached their capacity in a slot are skipped without touching their
+  // topics. Module queue entries whose topic was taken, or whose module was
+  // already used in the slot, are stale and skipped.
+  using Priority = std::tuple<int, int, int>; // latest, earliest, topic
+  auto getPriority = [&schedule](int node) {
+    return Priority(schedule.topics[node].latest,
+                    schedule.topics[node].earliest, node);
+  };
+  using TopicQueue =
+      std::priority_queue<Priority, std::vector<Priority>, std::greater<>>;
+  std::vector<TopicQueue> readyTopics(numModules);
+  std::priority_queue<std::pair<Priority, int>,
+                      std::vector<std::pair<Priority, int>>, std::greater<>>
+      readyModules;
+  auto makeReady = [&](int node) {
+    int module = moduleOfTopic[node];
+    Priority priority = getPriority(node);
+    if (readyTopics[module].empty() || priority < readyTopics[module].top()) {
+      readyModules.emplace(priority, module);
+    }
+    readyTopics[module].push(priority);
+  };
+
+  std::vector<size_t> unscheduledDeps(numTopics);
+  for (size_t node = 0; node < numTopics; ++node) {
+    unscheduledDeps[node] = deps[node].size();
+    if (unscheduledDeps[node] == 0) {
+      makeReady(node);
+    }
+  }
+
+  size_t moduleCapacity =
+      options.moduleCapacity > 0 ? options.moduleCapacity : numTopics;
+  std::vector<int> scheduled;
+  std::vector<int> usedModules;
+  std::vector<int> lastUsedSlot(numModules, -1);
+  for (int slot = 0; !readyModules.empty(); ++slot) {
+    scheduled.clear();
+    usedModules.clear();
+    while (scheduled.size() < static_cast<size_t>(schedule.numTracks) &&
+           !readyModules.empty()) {
+      auto [priority, module] = readyModules.top();
+      readyModules.pop();
+      if (lastUsedSlot[module] == slot || readyTopics[module].empty() ||
+          readyTopics[module].top() != priority) {
+        continue; // stale entry
+      }
+      lastUsedSlot[module] = slot;
+      for (size_t taken = 0;
+           taken < moduleCapacity && !readyTopics[module].empty() &&
+           scheduled.size() < static_cast<size_t>(schedule.numTracks);
+           ++taken) {
+        int node = std::get<2>(readyTopics[module].top());
+        readyTopics[module].pop();
+        schedule.topics[node].slot = slot;
+        schedule.topics[node].track = scheduled.size();
+        scheduled.push_back(node);
+      }
+      usedModules.push_back(module);
+    }
+    // Modules with topics left compete again in the next slot.
+    for (int module : usedModules) {
+      if (!readyTopics[module].empty()) {
+        readyModules.emplace(readyTopics[module].top(), module);
+      }
+    }
+
+    for (int node : scheduled) {
+      for (int dependent : dependents[node]) {
+        if (--unscheduledDeps[dependent] == 0) {
+          makeReady(dependent);
+        }
+      }
+    }
+    schedule.numSlots = slot + 1;
+  }
+
+  return schedule;
+}
+
+void writeScheduleCSV(const Schedule &schedule, OutputSink &out) {
+  out << "module,topic,topic_id,earliest,latest,slot,track\n";
+  for (auto &topicSlot : schedule.topics) {
+    out << escapeCSVField(topicSlot.module->getModuleName()) << ","
+        << escapeCSVField(topicSlot.topic->getName()) << ","
+        << topicSlot.topic->getID() << "," << topicSlot.earliest << ","
+        << topicSlot.latest << "," << topicSlot.slot << "," << topicSlot.track
+        << "\n";
+  }
+}
+
+} // namespace sg20
@@ -0,0 +1,196 @@
+#include "sg20_graphgen/search_index.h"
+
+#include <algorithm>
+#include <cctype>
+#include <tuple>
+#include <unordered_set>
+
+namespace sg20 {
+
+namespace {
+
+std::string toLower(std::string_view str) {
+  std::string lower(str);
+  for (char &c : lower) {
+    c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+  }
+  return lower;
+}
+
+// Returns the sorted trigrams of the key, which is padded at both ends so the
+// first and the last characters get a trigram of their own.
+std::vector<uint32_t> getTrigrams(std::string_view key) {
+  std::string padded = "\x01" + std::string(key) + "\x01";
+  std::vector<uint32_t> trigrams;
+  for (size_t i = 0; i + 3 <= padded.size(); ++i) {
+    trigrams.push_back(static_cast<unsigned char>(padded[i]) << 16 |
+                       static_cast<unsigned char>(padded[i + 1]) << 8 |
+                       static_cast<unsigned char>(padded[i + 2]));
+  }
+  std::sort(trigrams.begin(), trigrams.end());
+  trigrams.erase(std::unique(trigrams.begin(), trigrams.end()),
+                 trigrams.end());
+  return trigrams;
+}
+
+// Returns the smallest edit distance between the query and a prefix of the
+// key, or maxDistance + 1 if it is larger than maxDistance.
+unsigned getPrefixEditDistance(std::string_view query, std::string_view key,
+                               unsigned maxDistance) {
+  std::vector<unsigned> previous(key.size() + 1);
+  std::vector<unsigned> current(key.size() + 1);
+  for (size_t j = 0; j <= key.size(); ++j) {
+    previous[j] = j;
+  }
+  for (size_t i = 1; i <= query.size(); ++i) {
+    current[0] = i;
+    unsigned rowMin = current[0];
+    for (size_t j = 1; j <= key.size(); ++j) {
+      unsigned substitution =
+          previous[j - 1] + (query[i - 1] == key[j - 1] ? 0 : 1);
+      current[j] =
+          std::min({previous[j] + 1, current[j - 1] + 1, substitution});
+      rowMin = std::min(rowMin, current[j]);
+    }
+    if (rowMin > maxDistance) {
+      return maxDistance + 1;
+    }
+    std::swap(previous, current);
+  }
+  return std::min(*std::min_element(previous.begin(), previous.end()),
+                  maxDistance + 1);
+}
+
+} // namespace
+
+SearchIndex::SearchIndex(const ModuleCollection &moduleCollection) {
+  for (auto &module : moduleCollection.modules()) {
+    entries.push_back({toLower(module->getModuleName()),
+                       module->getModuleName(), module->getModuleID(),
+                       std::nullopt, std::nullopt});
+    for (auto &topic : module->topics()) {
+      entries.push_back({toLower(topic->getName()), module->getModuleName(),
+                         module->getModuleID(), topic->getName(),
+                         topic->getID()});
+    }
+  }
+
+  sortedEntries.resize(entries.size());
+  for (uint32_t entry = 0; entry < entries.size(); ++entry) {
+    sortedEntries[entry] = entry;
+    for (uint32_t trigram : getTrigrams(entries[entry].key)) {
+      trigramEntries[trigram].push_back(entry);
+    }
+  }
+  std::sort(sortedEntries.begin(), sortedEntries.end(),
+            [this](uint32_t lhs, uint32_t rhs) {
+              return std::tie(entries[lhs].key, lhs) <
+                     std::tie(entries[rhs].key, rhs);
+            });
+}
+
+SearchIndex::Match SearchIndex::makeMatch(uint32_t entry,
+                                          unsigned distance) const {
+  const Entry &found = entries[entry];
+  return {found.moduleName, found.moduleID, found.topicName, found.topicID,
+          distance};
+}
+
+std::vector<SearchIndex::Match> SearchIndex::find(std::string_view query,
+                                                  size_t maxResults) const {
+  std::string key = toLower(query);
+  std::vector<Match> matches;
+  if (key.empty() || maxResults == 0) {
+    return matches;
+  }
+
+  // Prefix matches, the exact matches sort before all longer names.
+  std::unordered_set<uint32_t> found;
+  auto prefixMatch = std::lower_bound(
+      sortedEntries.begin(), sortedEntries.end(), key,
+      [this](uint32_t entry, const std::string &value) {
+        return entries[entry].key < value;
+      });
+  for (; prefixMatch != sortedEntries.end() && matches.size() < maxResults &&
+         entries[*prefixMatch].key.compare(0, key.size(), key) == 0;
+       ++prefixMatch) {
+    matches.push_back(makeMatch(*prefixMatch, 0));
+    found.insert(*prefixMatch);
+  }
+  if (matches.size() == maxResults) {
+    return matches;
+  }
+
+  // Typo-tolerant matches are looked up by shared trigrams. Trigrams that
+  // occur in a large part of all names hardly narrow down the candidates and
+  // are skipped. The counters are reused by all queries of a thread.
+  thread_local std::vector<uint32_t> sharedTrigrams;
+  sharedTrigrams.resize(std::max(sharedTrigrams.size(), entries.size()));
+  std::vector<uint32_t> candidateEntries;
+  size_t frequentTrigram = std::max<size_t>(64, entries.size() / 64);
+  for (uint32_t trigram : getTrigrams(key)) {
+    auto trigramMatches = trigramEntries.find(trigram);
+    if (trigramMatches == trigramEntries.end() ||
+        trigramMatches->second.size() > frequentTrigram) {
+      continue;
+    }
+    for (uint32_t entry : trigramMatches->second) {
+      if (sharedTrigrams[entry]++ == 0) {
+        candidateEntries.push_back(entry);
+      }
+    }
+  }
+
+  // Only the candidates that share the most trigrams are compared.
+  std::vector<std::pair<unsigned, uint32_t>> candidates;
+  candidates.reserve(candidateEntries.size());
+  for (uint32_t entry : candidateEntries) {
+    if (!found.count(entry)) {
+      candidates.emplace_back(sharedTrigrams[entry], entry);
+    }
+    sharedTrigrams[entry] = 0;
+  }
+  size_t maxCandidates = 32 * maxResults;
+  auto byShared = [](auto &lhs, auto &rhs) {
+    return std::tie(rhs.first, lhs.second) < std::tie(lhs.first, rhs.second);
+  };
+  if (candidates.size() > maxCandidates) {
+    std::nth_element(candidates.begin(), candidates.begin() + maxCandidates,
+                     candidates.end(), byShared);
+    candidates.resize(maxCandidates);
+  }
+
+  unsigned maxDistance = key.size() <= 4 ? 1 : key.size() <= 8 ? 2 : 3;
+  std::vector<std::tuple<unsigned, size_t, uint32_t>> fuzzyMatches;
+  for (auto [shared, entry] : candidates) {
+    unsigned distance =
+        getPrefixEditDistance(key, entries[entry].key, maxDistance);
+    if (distance <= maxDistance) {
+      fuzzyMatches.emplace_back(distance, entries[entry].key.size(), entry);
+    }
+  }
+  std::sort(fuzzyMatches.begin(), fuzzyMatches.end());
+  for (auto [distance, length, entry] : fuzzyMatches) {
+    if (matches.size() == maxResults) {
+      break;
+    }
+    matches.push_back(makeMatch(entry, distance));
+  }
+  return matches;
+}
+
+const SearchIndex &
+LazySearchIndex::get(const ModuleCollection &moduleCollection) {
+  std::lock_guard<std::mutex> lock(indexMutex);
+  if (!index) {
+    index = std::make_unique<SearchIndex>(moduleCollection);
+  }
+  return *index;
+}
+
+void LazySearchIndex::invalidate() {
+  std::lock_guard<std::mutex> lock(indexMutex);
+  index.reset();
+}
+
+} // namespace sg20
@@ -0,0 +1,21 @@
+#include "sg20_graphgen/snapshot.h"
+
+namespace sg20 {
+
+SnapshotPublisher::SnapshotPublisher(ModuleCollection collection)
+    : working(std::move(collection)) {
+  working.loadAllModules();
+  std::lock_guard<std::mutex> lock(writerMutex);
+  publish();
+}
+
+SnapshotPublisher::SnapshotPtr SnapshotPublisher::publish() {
+  // The copy is made before the snapshot is visible, readers only ever see
+  // complete versions.
+  auto snapshot = std::make_shared<const CollectionSnapshot>(working.clone(),
+                                                             nextVersion++);
+  std::atomic_store_explicit(&current, snapshot, std::memory_order_release);
+  return snapshot;
+}
+
+} // namespace sg20
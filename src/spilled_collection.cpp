@@ -0,0 +1,355 @@
+#include "sg20_graphgen/spilled_collection.h"
+#include "sg20_graphgen/output_sink.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <stdexcept>
+#include <string>
+#include <unordered_set>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace sg20 {
+
+//===----------------------------------------------------------------------===//
+// MappedFile
+
+MappedFile::MappedFile(const std::filesystem::path &path) {
+  int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    throw std::runtime_error("Could not open " + path.string());
+  }
+  struct stat status;
+  if (::fstat(fd, &status) != 0) {
+    ::close(fd);
+    throw std::runtime_error("Could not read the size of " + path.string());
+  }
+  size = status.st_size;
+  if (size > 0) {
+    void *mapping = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (mapping == MAP_FAILED) {
+      ::close(fd);
+      throw std::runtime_error("Could not map " + path.string());
+    }
+    data = static_cast<char *>(mapping);
+  }
+  // The mapping keeps the file alive, even if it is deleted.
+  ::close(fd);
+}
+
+MappedFile::MappedFile(MappedFile &&other) noexcept
+    : data(other.data), size(other.size) {
+  other.data = nullptr;
+  other.size = 0;
+}
+
+MappedFile &MappedFile::operator=(MappedFile &&other) noexcept {
+  std::swap(data, other.data);
+  std::swap(size, other.size);
+  return *this;
+}
+
+MappedFile::~MappedFile() {
+  if (data) {
+    ::munmap(data, size);
+  }
+}
+
+void MappedFile::release(size_t offset, size_t length) const {
+  // Only whole pages are released, the pages at the ends of the range may
+  // still be in use.
+  static const size_t pageSize = ::sysconf(_SC_PAGESIZE);
+  size_t begin = (offset + pageSize - 1) / pageSize * pageSize;
+  size_t end = std::min(offset + length, size) / pageSize * pageSize;
+  if (data && begin < end) {
+    ::madvise(data + begin, end - begin, MADV_DONTNEED);
+  }
+}
+
+//===----------------------------------------------------------------------===//
+// SpilledCollection
+
+namespace {
+
+// Memory the topic index and rankLayoutGraph need per topic and per
+// dependency, and for the output buffers and the parser.
+constexpr size_t BytesPerTopic = 96;
+constexpr size_t BytesPerDependency = 32;
+constexpr size_t FixedBytes = 16 << 20;
+// Peak memory of parsing a module, relative to the size of its yaml text.
+// yaml-cpp needs about 50 bytes per byte for the node tree.
+constexpr size_t BytesPerSourceByte = 64;
+
+std::string toMegabytes(size_t bytes) {
+  return std::to_string((bytes >> 20) + 1) + " MB";
+}
+
+// Temporary directory for the files of the store, deleted with its contents.
+class TemporaryDirectory {
+public:
+  explicit TemporaryDirectory(const std::filesystem::path &parent) {
+    std::string pattern = (parent / "sg20-spill-XXXXXX").string();
+    if (!::mkdtemp(pattern.data())) {
+      throw std::runtime_error("Could not create a temporary directory in " +
+                               parent.string());
+    }
+    path = pattern;
+  }
+  ~TemporaryDirectory() {
+    std::error_code error;
+    std::filesystem::remove_all(path, error);
+  }
+
+  std::filesystem::path path;
+};
+
+template <typename T> void writeRaw(OutputSink &out, const T &value) {
+  out.write(std::string_view(reinterpret_cast<const char *>(&value),
+                             sizeof(value)));
+}
+
+} // namespace
+
+SpilledCollection
+SpilledCollection::loadFromYAMLFile(const std::filesystem::path &path,
+                                    const SpillOptions &options) {
+  MappedFile yaml(path);
+  std::string_view contents = yaml.contents();
+  TemporaryDirectory directory(options.directory);
+
+  SpilledCollection collection;
+  {
+    OutputSink topicOut(directory.path / "topics");
+    OutputSink depOut(directory.path / "deps");
+    OutputSink nameOut(directory.path / "names");
+    uint64_t nameSize = 0;
+    auto writeName = [&](const std::string &name) {
+      uint64_t offset = nameSize;
+      nameOut << name;
+      nameSize += name.size();
+      return offset;
+    };
+
+    // Checked after every module and before a module is parsed, so files
+    // that do not fit fail before most of them is read.
+    auto getNeededBytes = [&collection]() {
+      return collection.modules.size() * sizeof(ModuleRecord) +
+             collection.numTopicRecords * BytesPerTopic +
+             collection.numDepRecords * BytesPerDependency + FixedBytes;
+    };
+    auto checkParsePart = [&](std::string_view part) {
+      size_t neededBytes = getNeededBytes() + part.size() * BytesPerSourceByte;
+      if (options.memoryLimit == 0 || neededBytes <= options.memoryLimit) {
+        return;
+      }
+      if (part.size() == contents.size()) {
+        throw std::runtime_error(
+            "The file cannot be split at module boundaries, parsing it as a "
+            "whole needs about " +
+            toMegabytes(neededBytes) + " of memory");
+      }
+      throw std::runtime_error(
+          "Parsing the module at byte " +
+          std::to_string(part.data() - contents.data()) + " needs about " +
+          toMegabytes(neededBytes) + " of memory, its yaml text has " +
+          std::to_string(part.size()) + " bytes");
+    };
+
+    bool first = true;
+    forEachYAMLModule(contents, [&](const Module &module,
+                                    std::string_view source) {
+      std::string moduleName = module.getModuleName();
+      collection.modules.push_back({module.getModuleID(),
+                                    static_cast<uint32_t>(moduleName.size()),
+                                    writeName(moduleName),
+                                    collection.numTopicRecords,
+                                    module.numTopics()});
+      for (auto &topic : module.topics()) {
+        std::string topicName = topic->getName();
+        TopicRecord record{
+            topic->getID(),
+            static_cast<uint32_t>(topicName.size()),
+            writeName(topicName),
+            collection.numDepRecords,
+            static_cast<uint32_t>(topic->numDependencies()),
+            static_cast<uint32_t>(topic->numSoftDependencies())};
+        for (int32_t dep : topic->dependencies()) {
+          writeRaw(depOut, dep);
+        }
+        for (int32_t dep : topic->softDependencies()) {
+          writeRaw(depOut, dep);
+        }
+        writeRaw(topicOut, record);
+        collection.topicIndex.emplace_back(topic->getID(),
+                                           collection.numTopicRecords);
+        collection.numDepRecords += record.numDeps + record.numSoftDeps;
+        ++collection.numTopicRecords;
+      }
+
+      // The whole file was read once to find the modules, afterwards only
+      // the part of the current module is needed.
+      if (first) {
+        yaml.release(0, contents.size());
+        first = false;
+      } else if (!source.empty()) {
+        yaml.release(source.data() - contents.data(), source.size());
+      }
+
+      size_t neededBytes = getNeededBytes();
+      if (options.memoryLimit > 0 && neededBytes > options.memoryLimit) {
+        throw std::runtime_error(
+            "The collection needs at least " + toMegabytes(neededBytes) +
+            " of memory, " + std::to_string(collection.numTopicRecords) +
+            " topics and " + std::to_string(collection.numDepRecords) +
+            " dependencies in the first " +
+            std::to_string(collection.modules.size()) + " modules");
+      }
+    }, checkParsePart);
+
+    topicOut.flush();
+    depOut.flush();
+    nameOut.flush();
+    if (!topicOut.good() || !depOut.good() || !nameOut.good()) {
+      throw std::runtime_error("Could not write the store in " +
+                               directory.path.string());
+    }
+  }
+
+  // Later topics with the same ID are dropped, they are never found.
+  std::stable_sort(
+      collection.topicIndex.begin(), collection.topicIndex.end(),
+      [](auto &lhs, auto &rhs) { return lhs.first < rhs.first; });
+  collection.topicIndex.erase(
+      std::unique(collection.topicIndex.begin(), collection.topicIndex.end(),
+                  [](auto &lhs, auto &rhs) { return lhs.first == rhs.first; }),
+      collection.topicIndex.end());
+  collection.topicIndex.shrink_to_fit();
+
+  collection.topicFile = MappedFile(directory.path / "topics");
+  collection.depFile = MappedFile(directory.path / "deps");
+  collection.nameFile = MappedFile(directory.path / "names");
+  return collection;
+}
+
+size_t SpilledCollection::getModuleOfTopic(size_t topic) const {
+  // Empty modules have the same first topic as the module after them.
+  auto module = std::upper_bound(
+      modules.begin(), modules.end(), topic,
+      [](size_t topic, const ModuleRecord &module) {
+        return topic < module.firstTopic;
+      });
+  return module - modules.begin() - 1;
+}
+
+std::optional<size_t> SpilledCollection::findTopic(int topicID) const {
+  auto entry = std::lower_bound(
+      topicIndex.begin(), topicIndex.end(), topicID,
+      [](const std::pair<int, uint32_t> &entry, int topicID) {
+        return entry.first < topicID;
+      });
+  if (entry == topicIndex.end() || entry->first != topicID) {
+    return std::nullopt;
+  }
+  return entry->second;
+}
+
+void SpilledCollection::releaseModule(size_t module) const {
+  const ModuleRecord &record = modules[module];
+  size_t nameEnd = record.nameOffset + record.nameLength;
+  if (record.numTopics > 0) {
+    size_t first = record.firstTopic;
+    size_t last = first + record.numTopics - 1;
+    const TopicRecord &lastTopic = getTopicRecord(last);
+    size_t depBegin = getTopicRecord(first).depOffset;
+    size_t depEnd =
+        lastTopic.depOffset + lastTopic.numDeps + lastTopic.numSoftDeps;
+    nameEnd = lastTopic.nameOffset + lastTopic.nameLength;
+    depFile.release(depBegin * sizeof(int32_t),
+                    (depEnd - depBegin) * sizeof(int32_t));
+    topicFile.release(first * sizeof(TopicRecord),
+                      record.numTopics * sizeof(TopicRecord));
+  }
+  nameFile.release(record.nameOffset, nameEnd - record.nameOffset);
+}
+
+LayoutGraph SpilledCollection::buildLayoutGraph() const {
+  LayoutGraph graph;
+  graph.numModules = modules.size();
+  graph.moduleOfTopic.reserve(numTopicRecords);
+  graph.edges.reserve(numDepRecords);
+  for (size_t module = 0; module < modules.size(); ++module) {
+    size_t first = modules[module].firstTopic;
+    for (size_t node = first; node < first + modules[module].numTopics;
+         ++node) {
+      graph.moduleOfTopic.push_back(module);
+      auto addEdge = [&](int depID) {
+        auto dep = findTopic(depID);
+        if (dep && *dep != node) {
+          graph.edges.emplace_back(node, *dep);
+        }
+      };
+      for (int dep : dependencies(node)) {
+        addEdge(dep);
+      }
+      for (int dep : softDependencies(node)) {
+        addEdge(dep);
+      }
+    }
+    releaseModule(module);
+  }
+  return graph;
+}
+
+std::vector<ValidationIssue> SpilledCollection::validate() const {
+  std::vector<ValidationIssue> issues;
+  std::unordered_set<int> moduleIDs;
+  for (size_t module = 0; module < modules.size(); ++module) {
+    int moduleID = modules[module].ID;
+    if (!moduleIDs.insert(moduleID).second) {
+      issues.push_back(
+          ValidationIssue{ValidationIssue::Kind::DuplicateModuleID, moduleID});
+    }
+    size_t first = modules[module].firstTopic;
+    for (size_t topic = first; topic < first + modules[module].numTopics;
+         ++topic) {
+      if (findTopic(getTopicID(topic)) != topic) {
+        issues.push_back(ValidationIssue{
+            ValidationIssue::Kind::DuplicateTopicID, moduleID,
+            getTopicID(topic)});
+      }
+    }
+    releaseModule(module);
+  }
+
+  for (size_t module = 0; module < modules.size(); ++module) {
+    int moduleID = modules[module].ID;
+    size_t first = modules[module].firstTopic;
+    for (size_t topic = first; topic < first + modules[module].numTopics;
+         ++topic) {
+      int topicID = getTopicID(topic);
+      auto checkDeps = [&](auto deps, bool isSoft) {
+        for (int dep : deps) {
+          ValidationIssue::Kind kind;
+          if (!findTopic(dep)) {
+            kind = ValidationIssue::Kind::DanglingDependency;
+          } else if (dep == topicID) {
+            kind = ValidationIssue::Kind::SelfLoop;
+          } else {
+            continue;
+          }
+          issues.push_back(
+              ValidationIssue{kind, moduleID, topicID, dep, isSoft});
+        }
+      };
+      checkDeps(dependencies(topic), false);
+      checkDeps(softDependencies(topic), true);
+    }
+    releaseModule(module);
+  }
+  return issues;
+}
+
+} // namespace sg20
@@ -0,0 +1,120 @@
+#include "sg20_graphgen/svg_generator.h"
+#include "sg20_graphgen/emitters.h"
+#include "sg20_graphgen/util.h"
+
+#include "absl/strings/str_cat.h"
+
+#include <cmath>
+#include <string>
+#include <vector>
+
+namespace sg20 {
+
+static long px(double coordinate) { return std::lround(coordinate); }
+
+static void appendEdge(std::string &markup, const GraphLayout::Box &source,
+                       const GraphLayout::Box &target, DependencyKind kind) {
+  // Edges leave the dependent on the side that faces the dependency.
+  double x1 = source.x + source.width / 2;
+  double x2 = target.x + target.width / 2;
+  double y1, y2;
+  if (target.y > source.y) {
+    y1 = source.y + source.height;
+    y2 = target.y;
+  } else if (target.y < source.y) {
+    y1 = source.y;
+    y2 = target.y + target.height;
+  } else {
+    bool rightwards = x1 < x2;
+    x1 = rightwards ? source.x + source.width : source.x;
+    x2 = rightwards ? target.x : target.x + target.width;
+    y1 = y2 = source.y + source.height / 2;
+  }
+  absl::StrAppend(&markup, "<line",
+                  kind == DependencyKind::Soft ? " class=\"soft\"" : "",
+                  " x1=\"", px(x1), "\" y1=\"", px(y1), "\" x2=\"", px(x2),
+                  "\" y2=\"", px(y2), "\"/>\n");
+}
+
+void writeSVGGraph(const LayoutOrder &order, const GraphLayout &layout,
+                   OutputSink &out) {
+  size_t numModules = order.modules.size();
+  std::vector<std::string> edgeMarkup(numModules);
+  std::vector<std::string> nodeMarkup(numModules);
+  parallelFor(numModules, [&](size_t module) {
+    for (const Topic *topic : order.modules[module].topics) {
+      auto box = layout.topicBoxes.find(topic->getID());
+      if (box == layout.topicBoxes.end()) {
+        continue;
+      }
+      auto appendEdges = [&](auto deps, DependencyKind kind) {
+        for (int dep : deps) {
+          auto target = layout.topicBoxes.find(dep);
+          if (target != layout.topicBoxes.end() && dep != topic->getID()) {
+            appendEdge(edgeMarkup[module], box->second, target->second, kind);
+          }
+        }
+      };
+      appendEdges(topic->dependencies(), DependencyKind::Hard);
+      appendEdges(topic->softDependencies(), DependencyKind::Soft);
+
+      const GraphLayout::Box &node = box->second;
+      std::string name = escapeXMLString(topic->getName());
+      absl::StrAppend(&nodeMarkup[module], "<g class=\"topic\" id=\"t",
+                      topic->getID(), "\"><title>", name, " (",
+                      topic->getID(), ")</title><rect x=\"", px(node.x),
+                      "\" y=\"", px(node.y), "\" width=\"", px(node.width),
+                      "\" height=\"", px(node.height), "\" rx=\"8\"/><text x=\"",
+                      px(node.x + node.width / 2), "\" y=\"",
+                      px(node.y + node.height / 2), "\">", name,
+                      "</text></g>\n");
+    }
+  });
+
+  out << "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+      << "<svg xmlns=\"http://www.w3.org/2000/svg\" width=\""
+      << px(layout.width) << "\" height=\"" << px(layout.height)
+      << "\" viewBox=\"0 0 " << px(layout.width) << " " << px(layout.height)
+      << "\">\n"
+      << "<defs>\n"
+      << "<marker id=\"arrow\" viewBox=\"0 0 10 10\" refX=\"10\" refY=\"5\" "
+         "markerWidth=\"8\" markerHeight=\"8\" orient=\"auto\">"
+         "<path d=\"M0,0L10,5L0,10z\"/></marker>\n"
+      << "<style>\n"
+      << "text{font-family:sans-serif;font-size:12px;text-anchor:middle;"
+         "dominant-baseline:central}\n"
+      << ".module rect{fill:#f4f4f4;stroke:#999}\n"
+      << ".module text{font-weight:bold;text-anchor:start}\n"
+      << ".topic rect{fill:#fff;stroke:#000}\n"
+      << "line{stroke:#555;marker-end:url(#arrow)}\n"
+      << "line.soft{stroke-dasharray:4 3}\n"
+      << "</style>\n"
+      << "</defs>\n";
+
+  // Clusters are drawn first, so edges and topics are drawn on top of them.
+  for (size_t module = 0; module < numModules; ++module) {
+    const GraphLayout::Box &box = layout.moduleBoxes[module];
+    out << "<g class=\"module\"><rect x=\"" << px(box.x) << "\" y=\""
+        << px(box.y) << "\" width=\"" << px(box.width) << "\" height=\""
+        << px(box.height) << "\"/><text x=\"" << px(box.x + 8) << "\" y=\""
+        << px(box.y + 16) << "\">"
+        << escapeXMLString(order.modules[module].module->getModuleName())
+        << "</text></g>\n";
+  }
+  for (auto &markup : edgeMarkup) {
+    out << markup;
+  }
+  for (auto &markup : nodeMarkup) {
+    out << markup;
+  }
+  out << "</svg>\n";
+}
+
+void writeSVGGraph(const ModuleCollection &moduleCollection,
+                   OutputSink &out) {
+  LayoutOrder order = computeLayoutOrder(moduleCollection);
+  GraphLayout layout = computeGraphLayout(order);
+  writeSVGGraph(order, layout, out);
+}
+
+} // namespace sg20
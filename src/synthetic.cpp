@@ -0,0 +1,78 @@
+#include "sg20_graphgen/synthetic.h"
+
+#include <algorithm>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace sg20 {
+
+namespace {
+
+// Topics mostly depend on the topics shortly before them in their module.
+constexpr int LocalWindow = 20;
+
+// The standard distributions differ between implementations, these do not.
+class Random {
+public:
+  explicit Random(uint64_t seed) : engine(seed) {}
+
+  double uniform() { return (engine() >> 11) * 0x1.0p-53; }
+  int below(int bound) { return static_cast<int>(engine() % bound); }
+  // Rounds average up or down at random, so the mean is average.
+  int count(double average) {
+    int whole = static_cast<int>(average);
+    return whole + (uniform() < average - whole ? 1 : 0);
+  }
+
+private:
+  std::mt19937_64 engine;
+};
+
+} // namespace
+
+ModuleCollection
+generateSyntheticCollection(const SyntheticCollectionOptions &options) {
+  Random random(options.seed);
+  ModuleCollection::Builder builder;
+  int topicsPerModule = std::max(options.topicsPerModule, 0);
+  std::vector<int> deps;
+  for (int moduleIndex = 0; moduleIndex < options.numModules; ++moduleIndex) {
+    Module &module =
+        builder.addModule("Module " + std::to_string(moduleIndex + 1),
+                          moduleIndex + 1);
+    int firstTopicID = moduleIndex * topicsPerModule;
+    for (int index = 0; index < topicsPerModule; ++index) {
+      int topicID = firstTopicID + index;
+      Topic &topic = builder.addTopic(
+          module,
+          "Topic " + std::to_string(moduleIndex + 1) + "." +
+              std::to_string(index + 1),
+          topicID);
+
+      deps.clear();
+      auto addDependencies = [&](double average, DependencyKind kind) {
+        for (int dep = random.count(average); dep > 0; --dep) {
+          int depID;
+          if (moduleIndex > 0 &&
+              (index == 0 || random.uniform() < options.crossModuleShare)) {
+            depID = random.below(firstTopicID);
+          } else if (index > 0) {
+            depID = topicID - 1 - random.below(std::min(index, LocalWindow));
+          } else {
+            break;
+          }
+          if (std::find(deps.begin(), deps.end(), depID) == deps.end()) {
+            deps.push_back(depID);
+            builder.addDependency(topic, depID, kind);
+          }
+        }
+      };
+      addDependencies(options.dependencies, DependencyKind::Hard);
+      addDependencies(options.softDependencies, DependencyKind::Soft);
+    }
+  }
+  return builder.finish();
+}
+
+} // namespace sg20
@@ -0,0 +1,126 @@
+#include "sg20_graphgen/validator.h"
+
+#include <unordered_set>
+
+namespace sg20 {
+
+void ValidationIssue::dump(std::ostream &out) const {
+  std::string_view depKind = isSoft ? "soft dependency" : "dependency";
+  switch (kind) {
+  case Kind::DanglingDependency:
+    out << "Topic " << topicID << " in module " << moduleID << " has a "
+        << depKind << " on unknown topic " << targetID;
+    break;
+  case Kind::DuplicateModuleID:
+    out << "Module ID " << moduleID << " is used by multiple modules";
+    break;
+  case Kind::DuplicateTopicID:
+    out << "Topic ID " << topicID << " in module " << moduleID
+        << " is already used by another topic";
+    break;
+  case Kind::SelfLoop:
+    out << "Topic " << topicID << " in module " << moduleID << " has a "
+        << depKind << " on itself";
+    break;
+  }
+  if (repaired) {
+    out << " (repaired)";
+  }
+  out << "\n";
+}
+
+namespace {
+
+std::vector<ValidationIssue> validate(const ModuleCollection &moduleCollection,
+                                      ModuleCollection *repairCollection) {
+  std::vector<ValidationIssue> issues;
+
+  std::unordered_set<int> moduleIDs;
+  std::unordered_set<int> topicIDs;
+  moduleIDs.reserve(moduleCollection.numModules());
+  topicIDs.reserve(moduleCollection.numTopics());
+
+  for (auto &module : moduleCollection.modules()) {
+    if (!moduleIDs.insert(module->getModuleID()).second) {
+      issues.push_back(ValidationIssue{ValidationIssue::Kind::DuplicateModuleID,
+                                       module->getModuleID()});
+    }
+    for (auto &topic : module->topics()) {
+      if (!topicIDs.insert(topic->getID()).second) {
+        issues.push_back(ValidationIssue{
+            ValidationIssue::Kind::DuplicateTopicID, module->getModuleID(),
+            topic->getID()});
+      }
+    }
+  }
+
+  // Topics with repairable issues, kept in sync with issues.
+  std::vector<std::pair<size_t, Topic *>> repairs;
+
+  auto checkDeps = [&](const Module &module, Topic &topic, auto deps,
+                       bool isSoft) {
+    for (int dep : deps) {
+      ValidationIssue::Kind kind;
+      if (topicIDs.count(dep) == 0) {
+        kind = ValidationIssue::Kind::DanglingDependency;
+      } else if (dep == topic.getID()) {
+        kind = ValidationIssue::Kind::SelfLoop;
+      } else {
+        continue;
+      }
+      repairs.emplace_back(issues.size(), &topic);
+      issues.push_back(ValidationIssue{kind, module.getModuleID(),
+                                       topic.getID(), dep, isSoft,
+                                       repairCollection != nullptr});
+    }
+  };
+
+  for (auto &module : moduleCollection.modules()) {
+    for (auto &topic : module->topics()) {
+      checkDeps(*module, *topic, topic->dependencies(), false);
+      checkDeps(*module, *topic, topic->softDependencies(), true);
+    }
+  }
+
+  if (!repairCollection) {
+    return issues;
+  }
+
+  for (auto [issueIdx, topic] : repairs) {
+    const ValidationIssue &issue = issues[issueIdx];
+    switch (issue.kind) {
+    case ValidationIssue::Kind::DanglingDependency:
+      if (issue.isSoft) {
+        topic->removeSoftDependency(issue.targetID);
+      } else {
+        topic->removeDependency(issue.targetID);
+      }
+      break;
+    case ValidationIssue::Kind::SelfLoop:
+      if (issue.isSoft) {
+        topic->removeSoftDependency(*topic);
+      } else {
+        topic->removeDependency(*topic);
+      }
+      break;
+    default:
+      break;
+    }
+  }
+
+  return issues;
+}
+
+} // namespace
+
+std::vector<ValidationIssue>
+validateModuleCollection(const ModuleCollection &moduleCollection) {
+  return validate(moduleCollection, nullptr);
+}
+
+std::vector<ValidationIssue>
+repairModuleCollection(ModuleCollection &moduleCollection) {
+  return validate(moduleCollection, &moduleCollection);
+}
+
+} // namespace sg20
@@ -0,0 +1,200 @@
+#include "sg20_graphgen/metrics.h"
+#include "sg20_graphgen/modules.h"
+#include "sg20_graphgen/partition.h"
+#include "sg20_graphgen/schedule.h"
+
+#include <functional>
+#include <iostream>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace sg20;
+
+namespace {
+
+// Topics by name with the IDs of their hard dependencies, per module.
+using TopicSpec = std::pair<std::string, std::vector<int>>;
+using ModuleSpec = std::pair<std::string, std::vector<TopicSpec>>;
+
+// Numbers the modules and topics from 1 in the order they are given.
+ModuleCollection buildCollection(const std::vector<ModuleSpec> &modules) {
+  ModuleCollection::Builder builder;
+  int moduleID = 0;
+  int topicID = 0;
+  for (auto &[moduleName, topics] : modules) {
+    Module &module = builder.addModule(moduleName, ++moduleID);
+    for (auto &[topicName, deps] : topics) {
+      Topic &topic = builder.addTopic(module, topicName, ++topicID);
+      for (int depID : deps) {
+        builder.addDependency(topic, depID, DependencyKind::Hard);
+      }
+    }
+  }
+  return builder.finish();
+}
+
+// a -> b -> d is the critical path, c and e have one and two slots of slack.
+ModuleCollection buildDAG() {
+  return buildCollection({{"M",
+                           {{"a", {}},
+                            {"b", {1}},
+                            {"c", {1}},
+                            {"d", {2}},
+                            {"e", {}}}}});
+}
+
+// A and B depend on each other, C only depends on A.
+ModuleCollection buildModuleCycle() {
+  return buildCollection({{"A", {{"a1", {3}}, {"a2", {}}}},
+                          {"B", {{"b3", {2}}, {"b4", {}}}},
+                          {"C", {{"c5", {1}}}}});
+}
+
+const Schedule::TopicSlot &getSlot(const Schedule &schedule,
+                                   const std::string &name) {
+  for (auto &topicSlot : schedule.topics) {
+    if (topicSlot.topic->getName() == name) {
+      return topicSlot;
+    }
+  }
+  static const Schedule::TopicSlot Missing{nullptr, nullptr, -1, -1, -1, -1};
+  return Missing;
+}
+
+std::string getNames(const std::vector<const Topic *> &topics) {
+  std::string result;
+  for (const Topic *topic : topics) {
+    result += topic->getName();
+  }
+  return result;
+}
+
+const CollectionMetrics::ModuleMetrics *
+getModuleMetrics(const CollectionMetrics &metrics, const std::string &name) {
+  for (auto &module : metrics.modules) {
+    if (module.name == name) {
+      return &module;
+    }
+  }
+  return nullptr;
+}
+
+struct Check {
+  const char *name;
+  std::function<bool()> passes;
+};
+
+const std::vector<Check> Checks = {
+    {"computeSchedule finds the critical path",
+     [] {
+       auto moduleCollection = buildDAG();
+       Schedule schedule = computeSchedule(moduleCollection, {});
+       return schedule.criticalPathLength == 3 &&
+              getNames(schedule.criticalPath) == "abd";
+     }},
+    {"computeSchedule computes the slack of every topic",
+     [] {
+       auto moduleCollection = buildDAG();
+       Schedule schedule = computeSchedule(moduleCollection, {});
+       std::string slots;
+       for (auto &topicSlot : schedule.topics) {
+         slots += std::to_string(topicSlot.earliest) +
+                  std::to_string(topicSlot.latest) + " ";
+       }
+       return slots == "00 11 12 22 02 ";
+     }},
+    {"computeSchedule schedules the topics after their dependencies",
+     [] {
+       auto moduleCollection = buildDAG();
+       ScheduleOptions options;
+       options.tracks = 2;
+       Schedule schedule = computeSchedule(moduleCollection, options);
+       return schedule.numSlots == 3 &&
+              getSlot(schedule, "a").slot < getSlot(schedule, "b").slot &&
+              getSlot(schedule, "a").slot < getSlot(schedule, "c").slot &&
+              getSlot(schedule, "b").slot < getSlot(schedule, "d").slot;
+     }},
+    {"computeSchedule limits the topics of a module per slot",
+     [] {
+       auto moduleCollection = buildCollection(
+           {{"A", {{"a1", {}}, {"a2", {}}, {"a3", {}}}}, {"B", {{"b4", {}}}}});
+       ScheduleOptions options;
+       options.tracks = 3;
+       Schedule unlimited = computeSchedule(moduleCollection, options);
+       options.moduleCapacity = 1;
+       Schedule schedule = computeSchedule(moduleCollection, options);
+       std::map<int, int> topicsOfAPerSlot;
+       for (auto &topicSlot : schedule.topics) {
+         if (topicSlot.module->getModuleName() == "A" &&
+             ++topicsOfAPerSlot[topicSlot.slot] > 1) {
+           return false;
+         }
+       }
+       return unlimited.numSlots == 2 && schedule.numSlots == 3;
+     }},
+    {"computeSchedule breaks cycles at the first topic",
+     [] {
+       auto moduleCollection =
+           buildCollection({{"M", {{"x", {2}}, {"y", {1}}, {"z", {2}}}}});
+       Schedule schedule = computeSchedule(moduleCollection, {});
+       return schedule.numSlots == 3 && schedule.criticalPathLength == 3 &&
+              getSlot(schedule, "x").slot == 0 &&
+              getSlot(schedule, "y").slot == 1 &&
+              getSlot(schedule, "z").slot == 2;
+     }},
+    {"computeMetrics counts a cycle of two modules",
+     [] {
+       auto moduleCollection = buildModuleCycle();
+       CollectionMetrics metrics = computeMetrics(moduleCollection);
+       return metrics.moduleCycles == 1 && metrics.modulesInCycles == 2 &&
+              metrics.numTopics == 5 && metrics.hardEdges == 3 &&
+              metrics.crossModuleHardEdges == 3 &&
+              metrics.danglingEdges == 0;
+     }},
+    {"computeMetrics counts the fan-in and fan-out of the modules",
+     [] {
+       auto moduleCollection = buildModuleCycle();
+       CollectionMetrics metrics = computeMetrics(moduleCollection);
+       auto *a = getModuleMetrics(metrics, "A");
+       auto *c = getModuleMetrics(metrics, "C");
+       return a && c && a->fanIn == 2 && a->fanOut == 1 &&
+              a->incomingEdges == 2 && a->outgoingEdges == 1 &&
+              c->fanIn == 0 && c->fanOut == 1;
+     }},
+    {"computeMetrics finds no cycle in a chain of modules",
+     [] {
+       auto moduleCollection = buildCollection(
+           {{"A", {{"a1", {}}}}, {"B", {{"b2", {1}}}}, {"C", {{"c3", {2}}}}});
+       CollectionMetrics metrics = computeMetrics(moduleCollection);
+       return metrics.moduleCycles == 0 && metrics.modulesInCycles == 0;
+     }},
+    {"computePartition counts the dependencies between modules",
+     [] {
+       auto moduleCollection = buildModuleCycle();
+       PartitionProposal proposal = computePartition(moduleCollection, {});
+       return proposal.cutBefore == 3 &&
+              proposal.cutAfter <= proposal.cutBefore &&
+              proposal.topics.size() == 5;
+     }},
+};
+
+} // namespace
+
+// Runs the schedule, metrics, and partition analyses on small collections
+// whose results are known.
+int main() {
+  int failures = 0;
+  for (auto &check : Checks) {
+    if (!check.passes()) {
+      std::cerr << "Failed: " << check.name << "\n";
+      ++failures;
+    }
+  }
+  if (failures > 0) {
+    return 1;
+  }
+  std::cout << "All " << Checks.size() << " checks passed\n";
+  return 0;
+}
@@ -0,0 +1,191 @@
+#include "sg20_graphgen/commands.h"
+#include "sg20_graphgen/modules.h"
+
+#include <functional>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace sg20;
+
+namespace {
+
+// Two modules that both have a topic with ID 5, the first one has it twice.
+ModuleCollection buildCollection() {
+  ModuleCollection::Builder builder;
+  Module &first = builder.addModule("first", 1);
+  builder.addTopic(first, "a", 5);
+  builder.addTopic(first, "b", 5);
+  builder.addTopic(first, "c", 6);
+  Module &second = builder.addModule("second", 2);
+  builder.addTopic(second, "d", 5);
+  builder.addTopic(second, "e", 7);
+  return builder.finish();
+}
+
+// Two modules with the same ID, whose topics have the same ID, too.
+ModuleCollection buildDuplicateModules() {
+  ModuleCollection::Builder builder;
+  Module &first = builder.addModule("A", 1);
+  builder.addTopic(first, "a", 5);
+  Module &second = builder.addModule("B", 1);
+  builder.addTopic(second, "b", 5);
+  return builder.finish();
+}
+
+// Runs an editor command and returns what it printed.
+std::string runCommand(ModuleCollection &moduleCollection, CommandType cmd,
+                       const std::string &arguments) {
+  std::istringstream in(arguments + "\n");
+  std::ostringstream out;
+  executeCommand(moduleCollection, cmd, in, out, out);
+  return out.str();
+}
+
+std::string describeModules(const ModuleCollection &moduleCollection) {
+  std::string result;
+  for (auto &module : moduleCollection.modules()) {
+    result += module->getModuleName() + ":";
+    for (auto &topic : module->topics()) {
+      result += " " + topic->getName();
+    }
+    result += ";";
+  }
+  return result;
+}
+
+std::string getTopicName(const ModuleCollection &moduleCollection,
+                         int topicID) {
+  const Topic *topic = moduleCollection.getTopicFromID(topicID);
+  return topic ? topic->getName() : "none";
+}
+
+// Adds a topic to the last module and returns its ID.
+int addTopic(ModuleCollection &moduleCollection) {
+  Module *last = nullptr;
+  for (auto &module : moduleCollection.modules()) {
+    last = module.get();
+  }
+  return moduleCollection.addTopicToModule("new", *last)->getID();
+}
+
+struct Check {
+  const char *name;
+  std::function<bool()> passes;
+};
+
+const std::vector<Check> Checks = {
+    {"deleteTopic hands the ID to the next topic with it",
+     [] {
+       auto moduleCollection = buildCollection();
+       moduleCollection.deleteTopic(5);
+       return getTopicName(moduleCollection, 5) == "b" &&
+              moduleCollection.getModuleFromID(1)->numTopics() == 2;
+     }},
+    {"deleteTopic keeps a duplicate ID in use",
+     [] {
+       auto moduleCollection = buildCollection();
+       moduleCollection.deleteTopic(5);
+       moduleCollection.deleteTopic(5);
+       return getTopicName(moduleCollection, 5) == "d" &&
+              addTopic(moduleCollection) != 5;
+     }},
+    {"deleteTopic releases the ID of the last topic with it",
+     [] {
+       auto moduleCollection = buildCollection();
+       for (int deletion = 0; deletion < 3; ++deletion) {
+         moduleCollection.deleteTopic(5);
+       }
+       return getTopicName(moduleCollection, 5) == "none" &&
+              addTopic(moduleCollection) == 5;
+     }},
+    {"deleteModule hands the IDs of its topics to other modules",
+     [] {
+       auto moduleCollection = buildCollection();
+       moduleCollection.deleteModule(1);
+       return getTopicName(moduleCollection, 5) == "d" &&
+              getTopicName(moduleCollection, 6) == "none" &&
+              addTopic(moduleCollection) == 6;
+     }},
+    {"deleteModule releases IDs without duplicates",
+     [] {
+       auto moduleCollection = buildCollection();
+       moduleCollection.deleteModule(2);
+       return getTopicName(moduleCollection, 5) == "a" &&
+              addTopic(moduleCollection) == 7;
+     }},
+    {"delModule deletes the named module with a duplicate ID",
+     [] {
+       auto moduleCollection = buildDuplicateModules();
+       std::string output =
+           runCommand(moduleCollection, CommandType::DELETE_MODULE, "B");
+       return output.find("Deleted module: B") != std::string::npos &&
+              describeModules(moduleCollection) == "A: a;" &&
+              moduleCollection.getModuleFromID(1)->getModuleName() == "A";
+     }},
+    {"delModule hands the module ID to the next module with it",
+     [] {
+       auto moduleCollection = buildDuplicateModules();
+       runCommand(moduleCollection, CommandType::DELETE_MODULE, "A");
+       return describeModules(moduleCollection) == "B: b;" &&
+              moduleCollection.getModuleFromID(1)->getModuleName() == "B" &&
+              getTopicName(moduleCollection, 5) == "b";
+     }},
+    {"delModule keeps a duplicate module ID in use",
+     [] {
+       auto moduleCollection = buildDuplicateModules();
+       runCommand(moduleCollection, CommandType::DELETE_MODULE, "A");
+       Module &added = moduleCollection.addModule("D");
+       runCommand(moduleCollection, CommandType::DELETE_MODULE, "B");
+       Module &readded = moduleCollection.addModule("E");
+       return added.getModuleID() != 1 && readded.getModuleID() == 1;
+     }},
+    {"delTopic deletes the named topic with a duplicate ID",
+     [] {
+       auto moduleCollection = buildDuplicateModules();
+       std::string output =
+           runCommand(moduleCollection, CommandType::DELETE_TOPIC, "B:b");
+       return output.find("Deleted topic: b") != std::string::npos &&
+              describeModules(moduleCollection) == "A: a;B:;" &&
+              getTopicName(moduleCollection, 5) == "a" &&
+              addTopic(moduleCollection) != 5;
+     }},
+    {"moveTopic moves the named topic with a duplicate ID",
+     [] {
+       auto moduleCollection = buildDuplicateModules();
+       runCommand(moduleCollection, CommandType::MOVE_TOPIC, "B:b -> A");
+       return describeModules(moduleCollection) == "A: a b;B:;" &&
+              getTopicName(moduleCollection, 5) == "a";
+     }},
+    {"moveTopics reads the moves from one line",
+     [] {
+       auto moduleCollection = buildDuplicateModules();
+       moduleCollection.addModule("C");
+       std::string output = runCommand(
+           moduleCollection, CommandType::MOVE_TOPICS, " B:b -> C; A:a -> C");
+       return output == "Moved 2 topics\n" &&
+              describeModules(moduleCollection) == "A:;B:;C: a b;" &&
+              moduleCollection.getModuleFromTopicID(5)->getModuleName() ==
+                  "C";
+     }},
+};
+
+} // namespace
+
+// Deletes and moves topics and modules of collections with duplicate IDs, as
+// loaded from a file, and checks which IDs can be handed out again.
+int main() {
+  int failures = 0;
+  for (auto &check : Checks) {
+    if (!check.passes()) {
+      std::cerr << "Failed: " << check.name << "\n";
+      ++failures;
+    }
+  }
+  if (failures > 0) {
+    return 1;
+  }
+  std::cout << "All " << Checks.size() << " checks passed\n";
+  return 0;
+}
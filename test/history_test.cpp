@@ -0,0 +1,224 @@
+#include "test_util.h"
+
+#include "sg20_graphgen/history.h"
+#include "sg20_graphgen/modules.h"
+#include "sg20_graphgen/synthetic.h"
+
+#include <cstdint>
+#include <filesystem>
+#include <iostream>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <unistd.h>
+
+using namespace sg20;
+using sg20::test::describe;
+
+namespace {
+
+std::vector<Module *> getModules(const ModuleCollection &moduleCollection) {
+  std::vector<Module *> modules;
+  for (auto &module : moduleCollection.modules()) {
+    modules.push_back(module.get());
+  }
+  return modules;
+}
+
+std::vector<int> getTopicIDs(const ModuleCollection &moduleCollection) {
+  std::vector<int> topicIDs;
+  for (auto &module : moduleCollection.modules()) {
+    for (auto &topic : module->topics()) {
+      topicIDs.push_back(topic->getID());
+    }
+  }
+  return topicIDs;
+}
+
+// Copies the collection with the module at index renamed and swapped with the
+// next one, which modules cannot do themselves.
+ModuleCollection renameAndSwap(const ModuleCollection &moduleCollection,
+                               size_t index) {
+  auto modules = getModules(moduleCollection);
+  const Module *renamed = modules[index];
+  if (index + 1 < modules.size()) {
+    std::swap(modules[index], modules[index + 1]);
+  }
+  ModuleCollection::Builder builder;
+  for (const Module *module : modules) {
+    Module &copy = builder.addModule(
+        module->getModuleName() + (module == renamed ? " renamed" : ""),
+        module->getModuleID());
+    for (auto &topic : module->topics()) {
+      Topic &topicCopy =
+          builder.addTopic(copy, topic->getName(), topic->getID());
+      for (int dep : topic->dependencies()) {
+        builder.addDependency(topicCopy, dep, DependencyKind::Hard);
+      }
+      for (int dep : topic->softDependencies()) {
+        builder.addDependency(topicCopy, dep, DependencyKind::Soft);
+      }
+    }
+  }
+  return builder.finish();
+}
+
+class RandomEditor {
+public:
+  explicit RandomEditor(uint64_t seed) : rng(seed) {}
+
+  // Applies one random edit, mostly to the topic lists of the modules.
+  void edit(ModuleCollection &moduleCollection) {
+    auto modules = getModules(moduleCollection);
+    auto topicIDs = getTopicIDs(moduleCollection);
+    if (modules.empty()) {
+      moduleCollection.addModule("module " + std::to_string(++counter));
+      return;
+    }
+    Module &module = *modules[below(modules.size())];
+    bool hasTopics = !topicIDs.empty();
+    int topicID = hasTopics ? topicIDs[below(topicIDs.size())] : 0;
+
+    switch (below(10)) {
+    case 0:
+    case 1:
+      if (hasTopics) {
+        moduleCollection.moveTopic(topicID, module);
+      }
+      break;
+    case 2: {
+      // Moves a topic to the end of its module.
+      std::vector<int> moduleTopicIDs;
+      for (auto &topic : module.topics()) {
+        moduleTopicIDs.push_back(topic->getID());
+      }
+      if (!moduleTopicIDs.empty()) {
+        module.addTopic(
+            module.takeTopic(moduleTopicIDs[below(moduleTopicIDs.size())]));
+      }
+      break;
+    }
+    case 3:
+      moduleCollection.addTopicToModule("topic " + std::to_string(++counter),
+                                        module);
+      break;
+    case 4:
+      if (hasTopics) {
+        moduleCollection.deleteTopic(topicID);
+      }
+      break;
+    case 5:
+      if (hasTopics) {
+        Topic *topic = moduleCollection.getTopicFromID(topicID);
+        int depID = topicIDs[below(topicIDs.size())];
+        if (below(2) == 0) {
+          topic->addDependency(depID);
+        } else {
+          topic->addSoftDependency(depID);
+        }
+      }
+      break;
+    case 6:
+      if (hasTopics) {
+        moduleCollection.getTopicFromID(topicID)->rename(
+            "renamed " + std::to_string(++counter));
+      }
+      break;
+    case 7:
+      moduleCollection =
+          renameAndSwap(moduleCollection, below(modules.size()));
+      break;
+    case 8:
+      moduleCollection.addModule("module " + std::to_string(++counter));
+      break;
+    default:
+      if (below(3) == 0) {
+        moduleCollection.deleteModule(module.getModuleID());
+      }
+      break;
+    }
+  }
+
+private:
+  size_t below(size_t bound) { return rng() % bound; }
+
+  std::mt19937_64 rng;
+  int counter = 0;
+};
+
+bool checkRevisions(const HistoryStore &history,
+                    const std::vector<std::string> &expected, uint64_t seed) {
+  if (history.numRevisions() != expected.size()) {
+    std::cerr << "Seed " << seed << ": " << history.numRevisions()
+              << " revisions instead of " << expected.size() << "\n";
+    return false;
+  }
+  for (size_t revision = 0; revision < expected.size(); ++revision) {
+    std::string actual = describe(history.loadRevision(revision));
+    if (actual != expected[revision]) {
+      std::cerr << "Seed " << seed << ": revision " << revision
+                << " differs\nExpected:\n"
+                << expected[revision] << "Got:\n"
+                << actual;
+      return false;
+    }
+  }
+  return true;
+}
+
+// Appends a revision after every random edit and checks that every revision
+// is reconstructed, also after reopening the history.
+bool checkHistory(uint64_t seed, const std::filesystem::path &filepath) {
+  SyntheticCollectionOptions options;
+  options.numModules = 5;
+  options.topicsPerModule = 12;
+  options.seed = seed;
+  ModuleCollection moduleCollection = generateSyntheticCollection(options);
+
+  std::filesystem::remove(filepath);
+  std::vector<std::string> expected;
+  {
+    HistoryStore history(filepath, HistoryOptions{5});
+    RandomEditor editor(seed);
+    for (int step = 0; step < 60; ++step) {
+      if (step > 0) {
+        editor.edit(moduleCollection);
+      }
+      std::string current = describe(moduleCollection);
+      size_t revision = history.appendRevision(moduleCollection);
+      if (revision == expected.size()) {
+        expected.push_back(std::move(current));
+      } else if (revision + 1 != expected.size() ||
+                 expected.back() != current) {
+        std::cerr << "Seed " << seed << ": step " << step
+                  << " was not appended\n";
+        return false;
+      }
+    }
+    if (!checkRevisions(history, expected, seed)) {
+      return false;
+    }
+  }
+  return checkRevisions(HistoryStore(filepath), expected, seed);
+}
+
+} // namespace
+
+int main() {
+  auto filepath = std::filesystem::temp_directory_path() /
+                  ("sg20_history_test_" + std::to_string(::getpid()));
+
+  bool passed = true;
+  for (uint64_t seed = 1; passed && seed <= 100; ++seed) {
+    passed = checkHistory(seed, filepath);
+  }
+
+  std::filesystem::remove(filepath);
+  if (!passed) {
+    return 1;
+  }
+  std::cout << "All revisions reconstructed\n";
+  return 0;
+}
@@ -0,0 +1,105 @@
+"""Checks the sg20 Python module, mostly that handles to topics and modules
+fail cleanly instead of dangling after the objects they refer to are gone."""
+
+import sys
+
+import sg20
+
+
+def build_collection():
+    return sg20.ModuleCollection.from_json(
+        '{"Modules": ['
+        '{"name": "First", "mid": 1, "sub": ['
+        '{"name": "a", "tid": 1},'
+        '{"name": "b", "tid": 2, "dep": [1]}]},'
+        '{"name": "Second", "mid": 2, "sub": ['
+        '{"name": "c", "tid": 3, "dep": [2], "softdep": [1]}]}]}')
+
+
+def expect_stale(handle):
+    assert not handle.valid
+    try:
+        handle.name
+    except sg20.StaleHandleError:
+        return
+    raise AssertionError(f"{handle!r} is still usable")
+
+
+def check_lookup():
+    mc = build_collection()
+    assert mc.num_modules == 2 and mc.num_topics == 3
+    assert mc.topic(3).dependencies == [2]
+    assert mc.topic(3).soft_dependencies == [1]
+    assert mc.topic(1).dependents == [2]
+    assert mc.topic(42) is None
+    assert mc.module_by_name("Second") == mc.module(2)
+    assert [topic.name for topic in mc.module(1).topics] == ["a", "b"]
+    assert set(mc.edge_arrays()["src"].tolist()) == {2, 3}
+
+
+def check_edits():
+    mc = build_collection()
+    second = mc.module(2)
+    topic = mc.add_topic(second, "d")
+    topic.add_dependency(mc.topic(1))
+    assert topic.dependencies == [1] and len(second) == 2
+
+    moved = mc.move_topic(1, second)
+    assert moved == mc.topic(1) and topic.valid
+    assert [t.name for t in second.topics] == ["c", "d", "a"]
+
+    try:
+        mc.add_topic(build_collection().module(1), "e")
+    except ValueError:
+        pass
+    else:
+        raise AssertionError("added a topic to another collection")
+
+    other = build_collection().topic(2)
+    for edit in [topic.add_dependency, topic.remove_dependency]:
+        try:
+            edit(other)
+        except ValueError:
+            pass
+        else:
+            raise AssertionError("edited a dependency on another collection")
+    assert topic.dependencies == [1]
+
+
+def check_stale_handles():
+    mc = build_collection()
+    topic = mc.topic(2)
+    module = mc.module(1)
+    topics = module.topics
+    mc.delete_topic(2)
+    for handle in [topic, module] + topics:
+        expect_stale(handle)
+    assert [t.name for t in mc.module(1).topics] == ["a"]
+
+    new_topic = mc.topic(3)
+    mc.delete_module(1)
+    expect_stale(new_topic)
+    assert mc.topic(3).name == "c"
+
+    last = mc.topic(3)
+    mc.compact_ids()
+    expect_stale(last)
+    assert mc.topic(1).name == "c"
+
+
+def check_lifetime():
+    # Handles keep their collection alive.
+    topic = build_collection().topic(1)
+    assert topic.name == "a"
+
+
+def main():
+    for check in [check_lookup, check_edits, check_stale_handles,
+                  check_lifetime]:
+        check()
+    print("All Python binding checks passed")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
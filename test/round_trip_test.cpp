@@ -0,0 +1,188 @@
+#include "test_util.h"
+
+#include "sg20_graphgen/modules.h"
+#include "sg20_graphgen/serialization.h"
+
+#include "yaml-cpp/exceptions.h"
+
+#include <climits>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+using namespace sg20;
+using sg20::test::describe;
+
+namespace {
+
+// Characters that need quoting or escaping in one of the formats, and
+// multi-byte UTF-8 sequences.
+const std::vector<std::string> NameParts = {
+    "a", "Z", "7", " ", ":", "-", ">", "->", "#", "\"", "'", "\\", "{",
+    "}", "[", "]", ",", "&", "*", "!", "|", "%", "@", "`", "?", "\t", "/",
+    "\xc3\xa9", "\xe2\x86\x92", "null", "true", "~", "0x1F", "1e3", "-1", "\n",
+};
+
+class RandomCollection {
+public:
+  explicit RandomCollection(uint64_t seed) : rng(seed) {}
+
+  ModuleCollection generate(int maxModules, int maxTopicsPerModule) {
+    ModuleCollection::Builder builder;
+    std::vector<int> topicIDs;
+    int numModules = below(maxModules + 1);
+    for (int moduleIndex = 0; moduleIndex < numModules; ++moduleIndex) {
+      // Module and topic IDs are mostly unique, but not always.
+      int moduleID = chance(0.05) ? randomID() : moduleIndex + 1;
+      Module &module = builder.addModule(randomName(), moduleID);
+      int numTopics = below(maxTopicsPerModule + 1);
+      for (int index = 0; index < numTopics; ++index) {
+        int topicID = !topicIDs.empty() && chance(0.02)
+                          ? topicIDs[below(topicIDs.size())]
+                      : chance(0.1) ? randomID()
+                                    : static_cast<int>(topicIDs.size()) * 3;
+        topicIDs.push_back(topicID);
+        Topic &topic = builder.addTopic(module, randomName(), topicID);
+        addDependencies(builder, topic, topicIDs, DependencyKind::Hard);
+        addDependencies(builder, topic, topicIDs, DependencyKind::Soft);
+      }
+    }
+    return builder.finish();
+  }
+
+private:
+  int below(size_t bound) { return static_cast<int>(rng() % bound); }
+  bool chance(double probability) {
+    return (rng() >> 11) * 0x1.0p-53 < probability;
+  }
+
+  int randomID() {
+    switch (below(4)) {
+    case 0:
+      return INT_MIN + below(3);
+    case 1:
+      return INT_MAX - below(3);
+    case 2:
+      return -below(1000);
+    default:
+      return below(1 << 30);
+    }
+  }
+
+  std::string randomName() {
+    std::string name;
+    for (int length = below(8); length > 0; --length) {
+      name += NameParts[below(NameParts.size())];
+    }
+    return name;
+  }
+
+  // Mostly on existing topics, sometimes dangling or on the topic itself.
+  void addDependencies(ModuleCollection::Builder &builder, Topic &topic,
+                       const std::vector<int> &topicIDs, DependencyKind kind) {
+    for (int dep = below(4); dep > 0; --dep) {
+      int depID = chance(0.1) ? randomID() : topicIDs[below(topicIDs.size())];
+      builder.addDependency(topic, depID, kind);
+    }
+  }
+
+  std::mt19937_64 rng;
+};
+
+struct Loader {
+  const char *name;
+  const char *extension;
+  std::function<ModuleCollection(const std::filesystem::path &)> load;
+};
+
+const std::vector<Loader> Loaders = {
+    {"yaml", ".yaml",
+     [](const std::filesystem::path &path) {
+       return ModuleCollection::loadModulesFromFile(path);
+     }},
+    {"yaml serial", ".yaml",
+     [](const std::filesystem::path &path) {
+       return loadModulesFromYAML(readFileContents(path),
+                                  YAMLSplitting::Never);
+     }},
+    {"yaml split", ".yaml",
+     [](const std::filesystem::path &path) {
+       return loadModulesFromYAML(readFileContents(path),
+                                  YAMLSplitting::Always);
+     }},
+    {"yaml lazy", ".yaml",
+     [](const std::filesystem::path &path) {
+       auto collection = ModuleCollection::loadModulesLazilyFromFile(path);
+       collection.loadAllModules();
+       return collection;
+     }},
+    {"json", ".json",
+     [](const std::filesystem::path &path) {
+       return ModuleCollection::loadModulesFromFile(path);
+     }},
+    {"msgpack", ".msgpack",
+     [](const std::filesystem::path &path) {
+       return ModuleCollection::loadModulesFromFile(path);
+     }},
+};
+
+// Stores the collection in every format and checks that loading it gives
+// the same collection. Returns false and reports the first difference.
+bool checkRoundTrip(const ModuleCollection &moduleCollection, uint64_t seed,
+                    const std::filesystem::path &directory) {
+  std::string expected = describe(moduleCollection);
+  for (auto &loader : Loaders) {
+    auto path = directory / (std::string("collection") + loader.extension);
+    std::string actual;
+    try {
+      ModuleCollection::storeModulesToFile(moduleCollection, path);
+      actual = describe(loader.load(path));
+    } catch (YAML::Exception &e) {
+      actual = std::string("YAML::Exception: ") + e.what() + "\n";
+    } catch (std::runtime_error &e) {
+      actual = std::string("std::runtime_error: ") + e.what() + "\n";
+    }
+    if (actual != expected) {
+      std::cerr << "Seed " << seed << ": " << loader.name
+                << " round trip differs\nExpected:\n"
+                << expected << "Got:\n"
+                << actual;
+      return false;
+    }
+  }
+  return true;
+}
+
+} // namespace
+
+// Stores random collections with unusual names and IDs, dangling
+// dependencies, and duplicate IDs, and loads them again with every loader.
+int main() {
+  auto directory = std::filesystem::temp_directory_path() /
+                   ("sg20_round_trip_" + std::to_string(::getpid()));
+  std::filesystem::create_directories(directory);
+
+  bool passed = true;
+  for (uint64_t seed = 1; passed && seed <= 300; ++seed) {
+    passed = checkRoundTrip(RandomCollection(seed).generate(6, 8), seed,
+                            directory);
+  }
+  // Large enough to be split into several parts.
+  for (uint64_t seed = 1001; passed && seed <= 1003; ++seed) {
+    passed = checkRoundTrip(RandomCollection(seed).generate(300, 60), seed,
+                            directory);
+  }
+
+  std::filesystem::remove_all(directory);
+  if (!passed) {
+    return 1;
+  }
+  std::cout << "All round trips passed\n";
+  return 0;
+}
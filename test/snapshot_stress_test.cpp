@@ -0,0 +1,213 @@
+#include "test_util.h"
+
+#include "sg20_graphgen/commands.h"
+#include "sg20_graphgen/query_server.h"
+#include "sg20_graphgen/snapshot.h"
+#include "sg20_graphgen/synthetic.h"
+
+#include <atomic>
+#include <cstdint>
+#include <filesystem>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <unistd.h>
+
+using namespace sg20;
+using sg20::test::describe;
+
+namespace {
+
+constexpr int NumUpdates = 300;
+constexpr int NumReaders = 3;
+
+ModuleCollection buildCollection() {
+  SyntheticCollectionOptions options;
+  options.numModules = 5;
+  options.topicsPerModule = 20;
+  return generateSyntheticCollection(options);
+}
+
+// Readers hold snapshots while a writer publishes new versions. A snapshot
+// must not change while it is held, and versions must not go backwards.
+bool stressPublisher() {
+  SnapshotPublisher publisher(buildCollection());
+  std::atomic<bool> done{false};
+  std::atomic<int> failures{0};
+
+  std::vector<std::thread> readers;
+  for (int reader = 0; reader < NumReaders; ++reader) {
+    readers.emplace_back([&]() {
+      uint64_t lastVersion = 0;
+      while (!done) {
+        auto snapshot = publisher.acquire();
+        std::string before = describe(snapshot->getCollection());
+        snapshot->getSearchIndex().get(snapshot->getCollection());
+        if (snapshot->getVersion() < lastVersion ||
+            describe(snapshot->getCollection()) != before) {
+          ++failures;
+        }
+        lastVersion = snapshot->getVersion();
+      }
+    });
+  }
+
+  for (int update = 0; update < NumUpdates; ++update) {
+    publisher.update([update](ModuleCollection &moduleCollection) {
+      Module &module = **moduleCollection.modules().begin();
+      Topic *topic = moduleCollection.addTopicToModule(
+          "stress " + std::to_string(update), module);
+      topic->addDependency(update % 20);
+      if (update % 3 == 0) {
+        moduleCollection.deleteTopic(topic->getID());
+      }
+      return true;
+    });
+  }
+  done = true;
+  for (auto &reader : readers) {
+    reader.join();
+  }
+
+  if (failures > 0) {
+    std::cerr << failures << " snapshots changed or went back in version\n";
+    return false;
+  }
+  if (publisher.acquire()->getVersion() != NumUpdates) {
+    std::cerr << "Published " << publisher.acquire()->getVersion()
+              << " versions instead of " << NumUpdates << "\n";
+    return false;
+  }
+  return true;
+}
+
+// Queries and modifying commands on the query server at the same time.
+bool stressQueryServer(const std::filesystem::path &directory) {
+  QueryServer server(buildCollection(), directory / "unused.sock",
+                     directory / "saved.yaml");
+  std::atomic<bool> done{false};
+  std::atomic<int> failures{0};
+
+  std::vector<std::thread> readers;
+  for (int reader = 0; reader < NumReaders; ++reader) {
+    readers.emplace_back([&, reader]() {
+      const char *queries[] = {"listModules", "listTopics 1",
+                               "listDeps 2:21", "listRevDeps 1:2",
+                               "find Topic",  "render 1 html",
+                               "render 2 dot"};
+      std::mt19937 rng(reader);
+      while (!done) {
+        if (server.handleRequest(queries[rng() % 7]).failed) {
+          ++failures;
+        }
+      }
+    });
+  }
+
+  std::mt19937 rng(NumReaders);
+  for (int update = 0; update < NumUpdates; ++update) {
+    std::string request;
+    switch (rng() % 6) {
+    case 0:
+      request = "addTopic 3:stress" + std::to_string(rng() % 50);
+      break;
+    case 1:
+      request = "delTopic 3:stress" + std::to_string(rng() % 50);
+      break;
+    case 2:
+      request = "addDep 4:" + std::to_string(60 + rng() % 20) + " -> 3:" +
+                std::to_string(40 + rng() % 20);
+      break;
+    case 3:
+      request = "delDep 4:" + std::to_string(60 + rng() % 20) + " -> 3:" +
+                std::to_string(40 + rng() % 20);
+      break;
+    case 4:
+      request = "addModule Stress " + std::to_string(rng() % 5);
+      break;
+    default:
+      request = "save";
+      break;
+    }
+    server.handleRequest(request);
+  }
+  done = true;
+  for (auto &reader : readers) {
+    reader.join();
+  }
+
+  if (failures > 0) {
+    std::cerr << failures << " queries failed\n";
+    return false;
+  }
+  return true;
+}
+
+// Updates that throw or change nothing must not publish a version, and a
+// throwing edit must not leave its changes behind for the next update.
+bool checkFailedUpdates() {
+  SnapshotPublisher publisher(buildCollection());
+  try {
+    publisher.update([](ModuleCollection &moduleCollection) -> bool {
+      moduleCollection.addModule("Lost");
+      throw std::runtime_error("edit failed");
+    });
+  } catch (std::runtime_error &) {
+  }
+  publisher.update([](ModuleCollection &) { return false; });
+  auto snapshot = publisher.update([](ModuleCollection &moduleCollection) {
+    moduleCollection.addModule("Kept");
+    return true;
+  });
+  if (snapshot->getVersion() != 1 ||
+      describe(snapshot->getCollection()).find("Lost") != std::string::npos) {
+    std::cerr << "A failed update was published\n";
+    return false;
+  }
+
+  // Failed editing commands, like the query server runs them.
+  const char *requests[] = {"delTopic 3:missing", "addModule",
+                            "delDep 1:1 -> 1:1", "validate",
+                            "moveTopics 1:missing -> 2"};
+  for (const char *request : requests) {
+    std::istringstream in(request);
+    std::string cmd;
+    in >> cmd;
+    std::ostringstream out;
+    snapshot = publisher.update([&](ModuleCollection &moduleCollection) {
+      return executeCommand(moduleCollection, convertToCommandType(cmd), in,
+                            out, out);
+    });
+    if (snapshot->getVersion() != 1) {
+      std::cerr << "\"" << request << "\" published a version\n";
+      return false;
+    }
+  }
+  return true;
+}
+
+} // namespace
+
+// Meant to be run under ThreadSanitizer, see SG20GG_TSAN, which reports data
+// races between the readers and the writer. Without it, only the invariants of
+// the snapshots are checked.
+int main() {
+  auto directory = std::filesystem::temp_directory_path() /
+                   ("sg20_snapshot_stress_" + std::to_string(::getpid()));
+  std::filesystem::create_directories(directory);
+
+  bool passed = stressPublisher() && stressQueryServer(directory) &&
+                checkFailedUpdates();
+
+  std::filesystem::remove_all(directory);
+  if (!passed) {
+    return 1;
+  }
+  std::cout << "No snapshot changed while it was read\n";
+  return 0;
+}
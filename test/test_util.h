@@ -0,0 +1,40 @@
+#ifndef SG20_GRAPHGEN_TEST_UTIL_H
+#define SG20_GRAPHGEN_TEST_UTIL_H
+
+#include "sg20_graphgen/modules.h"
+
+#include <algorithm>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace sg20::test {
+
+// Everything a store has to preserve, independent of the writers.
+inline std::string describe(const ModuleCollection &moduleCollection) {
+  std::ostringstream out;
+  auto writeIDs = [&out](auto IDs) {
+    std::vector<int> sorted(IDs.begin(), IDs.end());
+    std::sort(sorted.begin(), sorted.end());
+    for (int ID : sorted) {
+      out << " " << ID;
+    }
+    out << "\n";
+  };
+  for (auto &module : moduleCollection.modules()) {
+    out << "module " << module->getModuleID() << " [" << module->getModuleName()
+        << "]\n";
+    for (auto &topic : module->topics()) {
+      out << "  topic " << topic->getID() << " [" << topic->getName() << "]\n"
+          << "    deps";
+      writeIDs(topic->dependencies());
+      out << "    soft";
+      writeIDs(topic->softDependencies());
+    }
+  }
+  return out.str();
+}
+
+} // namespace sg20::test
+
+#endif // SG20_GRAPHGEN_TEST_UTIL_H